@@ -0,0 +1,482 @@
+#include "../BackTest/backtest_includes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+// Usage: bench [output] [baseline] [tolerance]
+// Writes the results as csv into output. If a baseline written by an earlier run is given,
+// compares the medians with it and fails if any benchmark got slower by more than tolerance
+// percent.
+//
+// With -DBACKTEST_ALLOCATION_TRACKING=ON it also prints the allocations of the replay and fails
+// if one of the paths which have to be allocation free allocates.
+//
+// Usage: bench scale [output] [max events]
+// Generates synthetic data of doubling durations and writes how the time to the first event, the
+// peak memory of the replay and the replay speed of BackTest change with the number of events.
+//
+// BackTest parses the files on background threads during the replay, so there is no separate
+// load: backtest_first_event is the time until the first snapshot is parsed and
+// backtest_parse_and_replay includes the parsing which the replay has to wait for.
+
+std::mt19937 rnd(1791791791);
+
+const std::string path_orderbook = "../Data/orderbooks_eth_depth50.csv";
+const std::string path_transactions = "../Data/trades_eth.csv";
+const std::string default_output = "bench_results.csv";
+const double default_tolerance = 20;
+
+const uint64_t parse_repetitions = 5;
+const uint64_t book_repetitions = 3;
+const uint64_t replay_repetitions = 3;
+const uint64_t user_orders_per_snapshot = 20;
+const uint64_t pnl_orders = 1000;
+const uint64_t pnl_calls = 10000;
+const uint64_t allocation_free_calls = 1000;
+const uint64_t price_step = 1000;
+const uint64_t feature_set_depth = 50;
+const std::string default_scale_output = "bench_scale.csv";
+const std::string path_scale_orderbook = "bench_orderbook.csv";
+const std::string path_scale_transactions = "bench_transactions.csv";
+const uint64_t default_scale_max_events = 1000000;
+const uint64_t scale_start_duration = 3600000;
+
+// prevents the compiler from throwing away the benchmarked computations
+volatile uint64_t sink = 0;
+
+struct BenchmarkResult {
+    std::string name;
+    uint64_t operations;
+    uint64_t samples;
+    // operations per second over all samples
+    double throughput;
+    // percentiles of ns per operation over the samples
+    double p50, p90, p99;
+    BenchmarkResult() = default;
+    BenchmarkResult(const std::string& name, const uint64_t& operations,
+                    const std::vector<std::pair<double, uint64_t>>& samples);
+    void Print() const;
+};
+
+BenchmarkResult::BenchmarkResult(const std::string& name, const uint64_t& operations,
+                                 const std::vector<std::pair<double, uint64_t>>& samples)
+    : name(name), operations(operations), samples(samples.size()) {
+    if (samples.empty() || operations == 0) {
+        throw std::runtime_error("BenchmarkResult::BenchmarkResult - Nothing was measured.");
+    }
+    double total = 0;
+    std::vector<double> per_operation;
+    for (const auto& [nanoseconds, count] : samples) {
+        total += nanoseconds;
+        per_operation.emplace_back(nanoseconds / std::max<uint64_t>(count, 1));
+    }
+    throughput = operations / std::max(total, 1.0) * 1e9;
+    std::sort(per_operation.begin(), per_operation.end());
+    auto percentile = [&per_operation](const uint64_t& percent) {
+        return per_operation[(per_operation.size() - 1) * percent / 100];
+    };
+    p50 = percentile(50);
+    p90 = percentile(90);
+    p99 = percentile(99);
+}
+
+void BenchmarkResult::Print() const {
+    std::cerr << name << ": " << operations << " ops, " << throughput << " ops/s, p50 = " << p50
+              << " ns, p90 = " << p90 << " ns, p99 = " << p99 << " ns" << std::endl;
+}
+
+// Every Measure call is one sample, the function returns the number of operations it did.
+class Recorder {
+public:
+    explicit Recorder(const std::string& name) : name_(name), operations_(0), samples_() {
+    }
+
+    template <typename TFunction>
+    void Measure(TFunction function) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t operations = function();
+        auto finish = std::chrono::steady_clock::now();
+        samples_.emplace_back(std::chrono::duration<double, std::nano>(finish - start).count(),
+                              operations);
+        operations_ += operations;
+    }
+
+    BenchmarkResult GetResult() const {
+        auto result = BenchmarkResult(name_, operations_, samples_);
+        result.Print();
+        return result;
+    }
+
+private:
+    std::string name_;
+    uint64_t operations_;
+    std::vector<std::pair<double, uint64_t>> samples_;
+};
+
+// the book is owned by the replay, so every snapshot is copied before it is applied
+TLimitVector CopyOrders(const TLimitVector& orders) {
+    TLimitVector copy;
+    for (const auto& order : orders) {
+        copy.emplace_back(std::make_shared<LimitOrder>(*order));
+    }
+    return copy;
+}
+
+void BenchmarkScanner(std::vector<BenchmarkResult>& results) {
+    Recorder orderbook("scanner_read_orderbook");
+    Recorder transactions("scanner_read_transactions");
+    for (uint64_t i = 0; i < parse_repetitions; ++i) {
+        Scanner scanner;
+        orderbook.Measure([&]() {
+            scanner.ReadOrderBook(path_orderbook);
+            return scanner.GetAsk().size();
+        });
+        transactions.Measure([&]() {
+            scanner.ReadTransactions(path_transactions);
+            return scanner.GetTransactions().size();
+        });
+    }
+    results.emplace_back(orderbook.GetResult());
+    results.emplace_back(transactions.GetResult());
+}
+
+void BenchmarkOrderBook(const Scanner& scanner, std::vector<BenchmarkResult>& results) {
+    const auto& ask = scanner.GetAsk();
+    const auto& bid = scanner.GetBid();
+    const auto& transactions = scanner.GetTransactions();
+    Recorder update("orderbook_update");
+    Recorder market("orderbook_market_transaction");
+    Recorder insert("orderbook_user_limit_insert");
+    Recorder cancel("orderbook_user_limit_cancel");
+    for (uint64_t repetition = 0; repetition < book_repetitions; ++repetition) {
+        OrderBook book;
+        size_t transactions_position = 0;
+        for (size_t i = 0; i < ask.size(); ++i) {
+            auto cur_ask = CopyOrders(ask[i]);
+            auto cur_bid = CopyOrders(bid[i]);
+            update.Measure([&]() {
+                book.UpdateOrderBook(cur_ask, cur_bid);
+                return 1;
+            });
+
+            std::vector<uint64_t> order_ids;
+            // the user orders are placed around the best prices, so a snapshot with an empty side
+            // gets none
+            if (!book.GetAsk().empty() && !book.GetBid().empty()) {
+                uint64_t best_ask = (*book.GetAsk().begin())->GetPriceLimit();
+                uint64_t best_bid = (*book.GetBid().begin())->GetPriceLimit();
+                for (uint64_t j = 0; j < user_orders_per_snapshot; ++j) {
+                    uint64_t order_id = book.AddNewOrder();
+                    order_ids.emplace_back(order_id);
+                    auto order_type = j % 2 == 0 ? ASK : BID;
+                    uint64_t shift = rnd() % 20 * price_step;
+                    uint64_t price = order_type == ASK ? best_ask + shift : best_bid - shift;
+                    insert.Measure([&]() {
+                        book.AddUserLimitOrder(order_id, ask[i][0]->GetSubmitTimestamp(),
+                                               order_type, 1 + rnd() % 1000000, price);
+                        return 1;
+                    });
+                }
+            }
+
+            uint64_t next_time =
+                i + 1 < ask.size() ? ask[i + 1][0]->GetSubmitTimestamp() : uint64_t(-1);
+            while (transactions_position < transactions.size() &&
+                   transactions[transactions_position].GetTransactionTimestamp() < next_time) {
+                const auto& transaction = transactions[transactions_position++];
+                market.Measure([&]() {
+                    book.CompleteMarketTransaction(transaction);
+                    return 1;
+                });
+            }
+
+            for (const auto& order_id : order_ids) {
+                cancel.Measure([&]() {
+                    book.RemoveOrder(order_id);
+                    return 1;
+                });
+            }
+        }
+    }
+    results.emplace_back(update.GetResult());
+    results.emplace_back(market.GetResult());
+    results.emplace_back(insert.GetResult());
+    results.emplace_back(cancel.GetResult());
+}
+
+void BenchmarkPNL(const uint64_t& start_timestamp, std::vector<BenchmarkResult>& results) {
+    BackTest backtest(path_orderbook, path_transactions);
+    backtest.ProcessTimeInterval(start_timestamp);
+    for (uint64_t i = 0; i < pnl_orders; ++i) {
+        backtest.ProcessBeforeUnlock();
+        auto order_type = i % 2 == 0 ? ASK : BID;
+        uint64_t price = order_type == ASK ? backtest.GetBestBid() : backtest.GetBestAsk();
+        backtest.SendLimitOrder(order_type, 1000, price);
+        backtest.ProcessTimeInterval(backtest.GetCallFrequency());
+    }
+    Recorder pnl("backtest_get_pnl");
+    for (uint64_t i = 0; i < pnl_calls; ++i) {
+        pnl.Measure([&]() {
+            sink = sink + backtest.GetPNL().total_cash;
+            return 1;
+        });
+    }
+    results.emplace_back(pnl.GetResult());
+}
+
+void BenchmarkReplay(const uint64_t& end_timestamp, const uint64_t& events,
+                     std::vector<BenchmarkResult>& results) {
+    Recorder first_event("backtest_first_event");
+    Recorder replay("backtest_parse_and_replay");
+    for (uint64_t i = 0; i < replay_repetitions; ++i) {
+        BackTest backtest;
+        first_event.Measure([&]() {
+            backtest = BackTest(path_orderbook, path_transactions);
+            // waits for the first blocks of the parsers
+            sink = sink + backtest.GetNextEventTimestamp();
+            return 1;
+        });
+        ResetAllocations();
+        replay.Measure([&]() {
+            backtest.ProcessTimeInterval(end_timestamp);
+            return events;
+        });
+    }
+    results.emplace_back(first_event.GetResult());
+    results.emplace_back(replay.GetResult());
+    if (IsAllocationTrackingEnabled()) {
+        std::cerr << "Last replay of " << events << " events:" << std::endl;
+        PrintAllocations(false);
+    }
+}
+
+// returns true if function didn't allocate
+template <typename TFunction>
+bool CheckAllocationFree(const std::string& name, TFunction function) {
+    uint64_t before = GetThreadAllocations();
+    for (uint64_t i = 0; i < allocation_free_calls; ++i) {
+        function();
+    }
+    uint64_t allocations = GetThreadAllocations() - before;
+    std::cerr << "  " << name << ": " << allocations << " allocations"
+              << (allocations > 0 ? " FAILED" : "") << std::endl;
+    return allocations == 0;
+}
+
+// returns the number of paths which have to be allocation free but allocate
+uint64_t CheckAllocationFreePaths(const uint64_t& start_timestamp) {
+    if (!IsAllocationTrackingEnabled()) {
+        std::cerr << "Allocation free paths aren't checked, allocation tracking is compiled out"
+                  << std::endl;
+        return 0;
+    }
+    FeatureSet feature_set(GetDefaultFeatures());
+    BackTest backtest(path_orderbook, path_transactions);
+    feature_set.RegisterWindows(backtest.GetFeatureStore());
+    backtest.ProcessTimeInterval(start_timestamp + 60000);
+    backtest.ProcessBeforeUnlock();
+    auto order_id = backtest.SendLimitOrder(BID, 1000, backtest.GetBestBid()).value();
+    backtest.ProcessTimeInterval(backtest.GetPostLatency());
+
+    BookLevels ask, bid;
+    FillBookLevels(backtest.GetAsk(), feature_set_depth, ask);
+    FillBookLevels(backtest.GetBid(), feature_set_depth, bid);
+    std::vector<double> features(feature_set.Size());
+    std::cerr << "Allocation free paths:" << std::endl;
+    uint64_t failures = 0;
+    failures += !CheckAllocationFree("queue position", [&]() {
+        sink = sink + backtest.GetOrderPosition(order_id) + backtest.GetVolumeAhead(order_id);
+    });
+    failures += !CheckAllocationFree("fill book levels", [&]() {
+        FillBookLevels(backtest.GetAsk(), feature_set_depth, ask);
+        FillBookLevels(backtest.GetBid(), feature_set_depth, bid);
+    });
+    backtest.GetDepth(feature_set_depth);
+    failures += !CheckAllocationFree("depth view", [&]() {
+        auto depth = backtest.GetDepth(feature_set_depth);
+        sink = sink + depth.ask_prices[0] + depth.bid_volumes[depth.bid_depth - 1] +
+               backtest.GetQuote().ask_volume;
+    });
+    failures += !CheckAllocationFree("feature set", [&]() {
+        feature_set.Compute(ask, bid, backtest.GetFeatureStore(), features.data());
+    });
+    failures += !CheckAllocationFree("pnl", [&]() {
+        sink = sink + backtest.GetPNL().total_cash;
+    });
+    return failures;
+}
+
+void WriteResults(const std::string& path, const std::vector<BenchmarkResult>& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        throw std::runtime_error("WriteResults - Failed to open the output file.");
+    }
+    out << "name,operations,samples,throughput,p50_ns,p90_ns,p99_ns" << std::endl;
+    for (const auto& result : results) {
+        out << result.name << "," << result.operations << "," << result.samples << ","
+            << result.throughput << "," << result.p50 << "," << result.p90 << "," << result.p99
+            << std::endl;
+    }
+}
+
+std::map<std::string, double> ReadBaselineMedians(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        throw std::runtime_error("ReadBaselineMedians - Failed to open the baseline.");
+    }
+    static const size_t p50_position = 4;
+    std::map<std::string, double> medians;
+    std::string line;
+    getline(in, line);
+    while (getline(in, line)) {
+        std::vector<std::string> blocks;
+        std::stringstream stream(line);
+        for (std::string block; getline(stream, block, ',');) {
+            blocks.emplace_back(block);
+        }
+        if (blocks.size() <= p50_position) {
+            throw std::runtime_error("ReadBaselineMedians - Incorrect line in the baseline.");
+        }
+        medians[blocks[0]] = std::stod(blocks[p50_position]);
+    }
+    return medians;
+}
+
+// returns the number of regressions
+uint64_t CompareWithBaseline(const std::vector<BenchmarkResult>& results,
+                             const std::map<std::string, double>& baseline,
+                             const double& tolerance) {
+    uint64_t regressions = 0;
+    std::cerr << "Comparison with the baseline (p50):" << std::endl;
+    for (const auto& result : results) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second <= 0) {
+            std::cerr << "  " << result.name << ": no baseline" << std::endl;
+            continue;
+        }
+        double change = (result.p50 / it->second - 1) * 100;
+        bool is_regression = change > tolerance;
+        regressions += is_regression;
+        std::cerr << "  " << result.name << ": " << it->second << " ns -> " << result.p50
+                  << " ns (" << (change > 0 ? "+" : "") << change << "%)"
+                  << (is_regression ? " REGRESSION" : "") << std::endl;
+    }
+    return regressions;
+}
+
+// peak resident memory of the process in bytes since the last reset
+uint64_t GetPeakResidentMemory() {
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while (getline(in, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoull(line.substr(line.find_first_of("0123456789"))) << 10;
+        }
+    }
+    return 0;
+}
+
+// without the support of the kernel the peak stays the peak of the whole process
+void ResetPeakResidentMemory() {
+    std::ofstream out("/proc/self/clear_refs");
+    out << "5";
+}
+
+void RunScale(const std::string& output, const uint64_t& max_events) {
+    std::ofstream out(output);
+    if (!out.is_open()) {
+        throw std::runtime_error("RunScale - Failed to open the output file.");
+    }
+    out << "duration_ms,events,file_mib,generate_s,first_event_s,peak_resident_mib,"
+        << "replay_events_per_sec" << std::endl;
+    GeneratorConfig config;
+    for (config.duration = scale_start_duration;; config.duration *= 2) {
+        auto start = std::chrono::steady_clock::now();
+        auto stats = MarketGenerator(config).Generate(path_scale_orderbook,
+                                                      path_scale_transactions);
+        double generate = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                              .count();
+
+        ResetPeakResidentMemory();
+        start = std::chrono::steady_clock::now();
+        double first_event, replay;
+        uint64_t memory;
+        {
+            BackTest backtest(path_scale_orderbook, path_scale_transactions);
+            sink = sink + backtest.GetNextEventTimestamp();
+            first_event = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                              .count();
+            start = std::chrono::steady_clock::now();
+            backtest.ProcessTimeInterval(config.start_timestamp + config.duration);
+            replay = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                         .count();
+            memory = GetPeakResidentMemory();
+        }
+        std::cerr << stats.GetEvents() << " events: generate = " << generate
+                  << " s, first event = " << first_event << " s, peak resident = "
+                  << memory / (1 << 20) << " MiB, replay = " << stats.GetEvents() / replay
+                  << " events/s" << std::endl;
+        out << config.duration << "," << stats.GetEvents() << ","
+            << static_cast<double>(stats.bytes) / (1 << 20) << "," << generate << ","
+            << first_event << "," << static_cast<double>(memory) / (1 << 20) << ","
+            << stats.GetEvents() / replay << std::endl;
+        if (stats.GetEvents() >= max_events) {
+            break;
+        }
+    }
+    std::remove(path_scale_orderbook.c_str());
+    std::remove(path_scale_transactions.c_str());
+    std::cerr << "Results are written to " << output << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc > 1 && std::string(argv[1]) == "scale") {
+            RunScale(argc > 2 ? argv[2] : default_scale_output,
+                     argc > 3 ? std::stoull(argv[3]) : default_scale_max_events);
+            return EXIT_SUCCESS;
+        }
+        std::string output = argc > 1 ? argv[1] : default_output;
+        double tolerance = argc > 3 ? std::stod(argv[3]) : default_tolerance;
+        std::cerr.precision(4);
+
+        Scanner scanner;
+        scanner.ReadAll(path_orderbook, path_transactions);
+        if (scanner.GetAsk().empty() || scanner.GetTransactions().empty()) {
+            throw std::runtime_error("main - The data have to be non empty.");
+        }
+        uint64_t start_timestamp = scanner.GetAsk()[0][0]->GetSubmitTimestamp();
+        uint64_t end_timestamp =
+            std::max(scanner.GetAsk().back()[0]->GetSubmitTimestamp(),
+                     scanner.GetTransactions().back().GetTransactionTimestamp());
+        uint64_t events = scanner.GetAsk().size() + scanner.GetTransactions().size();
+
+        std::vector<BenchmarkResult> results;
+        BenchmarkScanner(results);
+        BenchmarkOrderBook(scanner, results);
+        BenchmarkPNL(start_timestamp, results);
+        BenchmarkReplay(end_timestamp, events, results);
+        WriteResults(output, results);
+        std::cerr << "Results are written to " << output << std::endl;
+
+        if (CheckAllocationFreePaths(start_timestamp) > 0) {
+            std::cerr << "Some allocation free paths allocate." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (argc > 2 && CompareWithBaseline(results, ReadBaselineMedians(argv[2]), tolerance) > 0) {
+            std::cerr << "Some benchmarks are slower than the baseline." << std::endl;
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+#include "../BackTest/backtest_includes.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+std::mt19937 rnd(1791791791);
+
+const uint64_t depth = 50;
+const uint64_t top = 10;
+const uint64_t iterations = 1000000;
+const uint64_t base_price = 40753000;
+const uint64_t price_step = 1000;
+const uint64_t bps = 5;
+
+// prevents the compiler from throwing away the benchmarked computations
+volatile double sink = 0;
+
+OrderBook MakeOrderBook() {
+    std::uniform_int_distribution<uint64_t> random_volume(100000, 20000000);
+    TLimitVector ask, bid;
+    for (uint64_t i = 0; i < depth; ++i) {
+        ask.emplace_back(std::make_shared<LimitOrder>(-1, 0, ASK, random_volume(rnd),
+                                                      base_price + (i + 1) * price_step));
+        bid.emplace_back(std::make_shared<LimitOrder>(-1, 0, BID, random_volume(rnd),
+                                                      base_price - i * price_step));
+    }
+    OrderBook orderbook;
+    orderbook.UpdateOrderBook(ask, bid);
+    return orderbook;
+}
+
+template <typename TFunction>
+void Measure(const std::string& name, TFunction function) {
+    auto before = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        sink = sink + function();
+    }
+    auto after = std::chrono::steady_clock::now();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count();
+    std::cerr << name << ": " << static_cast<double>(ns) / iterations << " ns/op" << std::endl;
+}
+
+// the way GetTopPressurePrediction and GetMarketPressurePrediction read the book
+template <typename TLimitSet>
+uint64_t WalkVolume(const TLimitSet& orders, const uint64_t& count) {
+    uint64_t volume = 0, cur = 0;
+    for (const auto& order : orders) {
+        if (cur == count) {
+            break;
+        }
+        volume += order->GetRemainingVolume();
+        ++cur;
+    }
+    return volume;
+}
+
+template <typename TLimitSet>
+double WalkNotional(const TLimitSet& orders, const double& mid, const double& band) {
+    double notional = 0;
+    for (const auto& order : orders) {
+        double price = order->GetPriceLimit();
+        if (std::abs(price - mid) <= band) {
+            notional += price * order->GetRemainingVolume();
+        }
+    }
+    return notional;
+}
+
+void CheckResults(const BookLevels& ask, const BookLevels& bid, const OrderBook& orderbook) {
+    if (GetCumulativeVolume(ask, top) != WalkVolume(orderbook.GetAsk(), top) ||
+        GetCumulativeVolume(bid, depth) != WalkVolume(orderbook.GetBid(), depth)) {
+        throw std::runtime_error("CheckResults - Cumulative volume differs from the set walk.");
+    }
+    double mid = (ask.prices[0] + bid.prices[0]) / 2.0;
+    double band = mid * bps / 10000;
+    double expected = WalkNotional(orderbook.GetAsk(), mid, band) +
+                      WalkNotional(orderbook.GetBid(), mid, band);
+    if (std::abs(GetNotionalNearMid(ask, bid, bps) - expected) > 1e-9 * expected) {
+        throw std::runtime_error("CheckResults - Notional near mid differs from the set walk.");
+    }
+}
+
+void Execution() {
+    OrderBook orderbook = MakeOrderBook();
+    BookLevels ask, bid;
+    FillBookLevels(orderbook.GetAsk(), depth, ask);
+    FillBookLevels(orderbook.GetBid(), depth, bid);
+
+    std::cerr << "set walk:" << std::endl;
+    Measure("  top volume", [&]() {
+        return WalkVolume(orderbook.GetAsk(), top) + WalkVolume(orderbook.GetBid(), top);
+    });
+    Measure("  full volume", [&]() {
+        return WalkVolume(orderbook.GetAsk(), depth) + WalkVolume(orderbook.GetBid(), depth);
+    });
+    Measure("  notional near mid", [&]() {
+        double mid = ((*orderbook.GetAsk().begin())->GetPriceLimit() +
+                      (*orderbook.GetBid().begin())->GetPriceLimit()) /
+                     2.0;
+        double band = mid * bps / 10000;
+        return WalkNotional(orderbook.GetAsk(), mid, band) +
+               WalkNotional(orderbook.GetBid(), mid, band);
+    });
+    Measure("  fill book levels", [&]() {
+        FillBookLevels(orderbook.GetAsk(), depth, ask);
+        FillBookLevels(orderbook.GetBid(), depth, bid);
+        return ask.volumes[0];
+    });
+
+    for (const auto& isa : {SCALAR, SSE2, AVX2}) {
+        if (!IsKernelIsaSupported(isa)) {
+            std::cerr << ToString(isa) << " isn't supported" << std::endl;
+            continue;
+        }
+        SetKernelIsa(isa);
+        CheckResults(ask, bid, orderbook);
+        std::cerr << ToString(isa) << ":" << std::endl;
+        Measure("  top volume", [&]() {
+            return GetCumulativeVolume(ask, top) + GetCumulativeVolume(bid, top);
+        });
+        Measure("  full volume", [&]() {
+            return GetCumulativeVolume(ask, depth) + GetCumulativeVolume(bid, depth);
+        });
+        Measure("  depth weighted imbalance",
+                [&]() { return GetDepthWeightedImbalance(ask, bid, depth); });
+        Measure("  micro price", [&]() { return GetMicroPrice(ask, bid); });
+        Measure("  notional near mid", [&]() { return GetNotionalNearMid(ask, bid, bps); });
+    }
+}
+
+int main() {
+    try {
+        Execution();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
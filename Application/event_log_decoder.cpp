@@ -0,0 +1,49 @@
+#include "../BackTest/backtest_includes.h"
+
+#include <iostream>
+#include <set>
+
+// usage: event-log-decoder <log> [event]...
+// prints the records of an event log written by the engine, one per line, to stdout; the
+// optional event names, e.g. fill or order_ack, keep only these events
+void Execution(int argc, char** argv) {
+    if (argc < 2) {
+        throw std::runtime_error("Execution - Usage: event-log-decoder <log> [event]...");
+    }
+    std::set<uint32_t> events;
+    for (int i = 2; i < argc; ++i) {
+        uint32_t event = 0;
+        while (event < LOG_EVENTS_COUNT && ToString(static_cast<LogEvents>(event)) != argv[i]) {
+            ++event;
+        }
+        if (event == LOG_EVENTS_COUNT) {
+            throw std::runtime_error("Execution - Unknown event " + std::string(argv[i]) + ".");
+        }
+        events.insert(event);
+    }
+
+    auto records = ReadEventLog(argv[1]);
+    std::vector<uint64_t> counts(LOG_EVENTS_COUNT, 0);
+    for (const auto& record : records) {
+        ++counts[record.event];
+        if (events.empty() || events.count(record.event)) {
+            std::cout << Format(record) << '\n';
+        }
+    }
+    std::cout.flush();
+    std::cerr << "Decoded " << records.size() << " records:";
+    for (uint32_t event = 0; event < LOG_EVENTS_COUNT; ++event) {
+        std::cerr << ' ' << ToString(static_cast<LogEvents>(event)) << '=' << counts[event];
+    }
+    std::cerr << std::endl;
+}
+
+int main(int argc, char** argv) {
+    try {
+        Execution(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,53 @@
+#include "../BackTest/backtest_includes.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+const std::string path_orderbook = "../Data/orderbooks_eth_depth50.csv";
+const std::string path_transactions = "../Data/trades_eth.csv";
+const std::string default_path_output = "../Data/features_eth.bin";
+const uint64_t initial_time = 1603659600000;
+const uint64_t end_time = 1603663200000;
+
+double GetSeconds(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// usage: feature-export [output path] [threads]
+void Execution(int argc, char** argv) {
+    auto start = std::chrono::steady_clock::now();
+    std::string path_output = argc > 1 ? argv[1] : default_path_output;
+    ExportConfig config;
+    config.start_timestamp = initial_time;
+    config.end_timestamp = end_time;
+    config.shard_duration = 600000;
+    config.threads = argc > 2 ? std::stoull(argv[2])
+                              : std::max<uint64_t>(1, std::thread::hardware_concurrency());
+
+    std::unique_ptr<FeatureExporter> exporter;
+    {
+        Scanner scanner;
+        scanner.ReadAll(path_orderbook, path_transactions);
+        std::cerr << "Data read. time: " << GetSeconds(start) << std::endl;
+        // the parsed rows are freed, the export runs over the compact copy
+        exporter = std::make_unique<FeatureExporter>(scanner, config);
+    }
+    std::cerr << "Compact data: " << exporter->GetData().GetMemoryUsage() / 1024 / 1024
+              << " MB" << std::endl;
+    auto rows = exporter->Export(path_output);
+    std::cerr << "Exported " << rows << " rows of " << exporter->GetColumnNames().size()
+              << " columns into " << path_output << " using " << config.threads
+              << " threads. time: " << GetSeconds(start) << std::endl;
+}
+
+int main(int argc, char** argv) {
+    try {
+        Execution(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -1,9 +1,12 @@
 #include "../BackTest/backtest_includes.h"
 
+#include <array>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <queue>
 #include <random>
+#include <vector>
 
 std::mt19937 rnd(1791791791);
 
@@ -24,6 +27,15 @@ const uint64_t cancel_open_order_time = 10000;
 // all measures multiply by 10^4
 const uint64_t limit_order_volume = 10;
 const int64_t limit_order_price_step = 100;
+// the model is trained on the output of feature-export and predicts the return of mid price in bps
+const bool use_model = false;
+const std::string path_model = "../Data/model_eth.txt";
+const double model_threshold = 1;
+// if not empty, the engine events are recorded into a binary log, event-log-decoder prints it
+const std::string path_event_log = "";
+
+FeatureSet model_features(GetDefaultFeatures());
+TreeEnsemble model;
 
 struct ForCancel {
     uint64_t cancel_timestamp;
@@ -53,18 +65,11 @@ PREDICTION GetRandomPrediction(const BackTest& /*backtest*/) {
 
 PREDICTION GetCountTransactionsPredictoin(const BackTest& backtest) {
     static const uint64_t butch = 10;
-    auto& transactions = backtest.GetCompletedTrades();
-    if (transactions.size() < butch) {
+    const auto& window = backtest.GetFeatureStore().GetTradeCountWindow(butch);
+    if (window.count < butch) {
         return GetRandomPrediction(backtest);
     } else {
-        int balance = 0;
-        for (uint64_t i = 0; i < butch; ++i) {
-            if (transactions[transactions.size() - 1 - i]->GetIsBuyerMaker()) {
-                ++balance;
-            } else {
-                --balance;
-            }
-        }
+        int64_t balance = window.GetBuyerMakerImbalance();
         if (abs(balance) < butch / 2) {
             return WAIT;
         } else if (balance > 0) {
@@ -77,21 +82,12 @@ PREDICTION GetCountTransactionsPredictoin(const BackTest& backtest) {
 
 PREDICTION GetVolumeTransactionsPredictoin(const BackTest& backtest) {
     static const uint64_t butch = 15;
-    auto& transactions = backtest.GetCompletedTrades();
-    if (transactions.size() < butch) {
+    const auto& window = backtest.GetFeatureStore().GetTradeCountWindow(butch);
+    if (window.count < butch) {
         return GetRandomPrediction(backtest);
     } else {
-        uint64_t total = 0;
-        int64_t balance = 0;
-        for (uint64_t i = 0; i < butch; ++i) {
-            auto& transaction = transactions[transactions.size() - 1 - i];
-            total += transaction->GetVolume();
-            if (transaction->GetIsBuyerMaker()) {
-                balance += transaction->GetVolume();
-            } else {
-                balance -= transaction->GetVolume();
-            }
-        }
+        uint64_t total = window.volume;
+        int64_t balance = window.signed_volume;
         if (abs(balance) < total / 2) {
             return WAIT;
         } else if (balance > 0) {
@@ -103,22 +99,14 @@ PREDICTION GetVolumeTransactionsPredictoin(const BackTest& backtest) {
 }
 
 uint64_t GetAverageCost(const BackTest& backtest, const uint64_t& n) {
-    uint64_t total_cost = 0;
-    uint64_t total_volume = 0;
-    auto& transactions = backtest.GetCompletedTrades();
-    for (uint64_t i = 0; i < n; ++i) {
-        auto& transaction = transactions[transactions.size() - 1 - i];
-        total_cost += transaction->GetVolume() * transaction->GetPrice();
-        total_volume += transaction->GetVolume();
-    }
     // I decided to ignore the margin of error here
-    return total_cost / total_volume;
+    const auto& trades = backtest.GetCompletedTrades();
+    return trades.GetVWAP(trades.GetTotalCount() - n, trades.GetTotalCount());
 }
 
 PREDICTION GetAgeragePrediction(const BackTest& backtest) {
     static const uint64_t butch = 10;
-    auto& transactions = backtest.GetCompletedTrades();
-    if (transactions.size() < butch) {
+    if (backtest.GetFeatureStore().GetTotalTransactions() < butch) {
         return GetRandomPrediction(backtest);
     } else {
         auto total_avg = GetAverageCost(backtest, butch);
@@ -197,6 +185,20 @@ PREDICTION GetMixedPrediction(const BackTest& backtest) {
     return WAIT;
 }
 
+PREDICTION GetModelPrediction(const BackTest& backtest) {
+    static std::vector<double> features(model_features.Size());
+    model_features.Compute(backtest.GetAskLevels(), backtest.GetBidLevels(),
+                           backtest.GetFeatureStore(), features.data());
+    double prediction = model.Predict(features.data());
+    if (std::abs(prediction) < model_threshold) {
+        return WAIT;
+    } else if (prediction > 0) {
+        return BUY;
+    } else {
+        return SELL;
+    }
+}
+
 PREDICTION GetPrediction(const BackTest& backtest) {
     // return GetRandomPrediction(backtest);
     // return GetCountTransactionsPredictoin(backtest);
@@ -204,22 +206,34 @@ PREDICTION GetPrediction(const BackTest& backtest) {
     // return GetAgeragePrediction(backtest);
     // return GetMarketPressurePrediction(backtest);
     // return GetTopPressurePrediction(backtest);
+    if (use_model) {
+        return GetModelPrediction(backtest);
+    }
     return GetMixedPrediction(backtest);
 }
 
+// all trade windows used by the predictions above
+void RegisterFeatureWindows(BackTest& backtest) {
+    auto& feature_store = backtest.GetFeatureStore();
+    for (const uint64_t count : {10, 15}) {
+        feature_store.AddTradeCountWindow(count);
+    }
+    if (use_model) {
+        model_features.RegisterWindows(feature_store);
+    }
+}
+
 void WithdrawAllOrders(BackTest& backtest) {
-    for (const auto& order : backtest.GetUserLimitAsk()) {
-        if (!order->IsClosed() && !order->IsCanceled()) {
-            while (!backtest.WithdrawLimitOrder(order->GetOrderId())) {
-                backtest.ProcessTimeInterval(backtest.GetCallFrequency());
-            }
+    // the active set changes while the replay goes on, so the ids are copied first
+    std::vector<uint64_t> order_ids;
+    for (const auto& [order_id, order] : backtest.GetActiveOrders()) {
+        if (!order.is_market && order.state != ORDER_PENDING_CANCEL) {
+            order_ids.emplace_back(order_id);
         }
     }
-    for (const auto& order : backtest.GetUserLimitBid()) {
-        if (!order->IsClosed() && !order->IsCanceled()) {
-            while (!backtest.WithdrawLimitOrder(order->GetOrderId())) {
-                backtest.ProcessTimeInterval(backtest.GetCallFrequency());
-            }
+    for (const auto& order_id : order_ids) {
+        while (!backtest.WithdrawLimitOrder(order_id)) {
+            backtest.ProcessTimeInterval(backtest.GetCallFrequency());
         }
     }
 }
@@ -265,7 +279,17 @@ bool ExecuteCancelQueue(BackTest& backtest, std::queue<ForCancel>& cancel_queue)
 
 void Execution() {
     start = clock();
+    if (use_model) {
+        model = TreeEnsemble(path_model);
+        if (model.GetFeatureCount() != model_features.Size()) {
+            throw std::runtime_error("Execution - The model expects another set of features.");
+        }
+    }
+    if (!path_event_log.empty()) {
+        OpenEventLog(path_event_log);
+    }
     BackTest backtest(path_orderbook, path_transactions);
+    RegisterFeatureWindows(backtest);
     std::queue<ForCancel> cancel_queue;
     backtest.ProcessTimeInterval(initial_time);
 
@@ -285,7 +309,6 @@ void Execution() {
         if (prediction != WAIT) {
             auto cur_price = (backtest.GetBestBid() + backtest.GetBestAsk()) / 2 +
                              (prediction == BUY ? -limit_order_price_step : limit_order_price_step);
-            // std::cerr << "cur_price = " << cur_price << std::endl;
             auto id = backtest.SendLimitOrder(prediction == BUY ? BID : ASK, limit_order_volume,
                                               cur_price);
             if (!id) {
@@ -318,6 +341,10 @@ void Execution() {
               << std::endl;
     std::cerr.precision(4);
     std::cerr << "Average profit from the transaction = " << cash / total_orders << std::endl;
+    if (IsInstrumentationEnabled()) {
+        backtest.GetStats().Print();
+    }
+    CloseEventLog();
     std::cerr << "Finish testing. time: " << GetCurrentTime() << std::endl;
 }
 
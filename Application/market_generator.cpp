@@ -0,0 +1,74 @@
+#include "../BackTest/backtest_includes.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+
+// usage: market-generator [name=value]...
+// names are the fields of GeneratorConfig and orderbook/transactions for the output paths,
+// e.g. market-generator duration=86400000 trades_per_second=1000 depth=20
+const std::string default_path_orderbook = "../Data/orderbooks_generated.csv";
+const std::string default_path_transactions = "../Data/trades_generated.csv";
+
+double GetSeconds(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Execution(int argc, char** argv) {
+    GeneratorConfig config;
+    std::string path_orderbook = default_path_orderbook;
+    std::string path_transactions = default_path_transactions;
+    std::map<std::string, std::function<void(const std::string&)>> setters = {
+        {"seed", [&](const std::string& value) { config.seed = std::stoull(value); }},
+        {"start_timestamp",
+         [&](const std::string& value) { config.start_timestamp = std::stoull(value); }},
+        {"duration", [&](const std::string& value) { config.duration = std::stoull(value); }},
+        {"snapshot_interval",
+         [&](const std::string& value) { config.snapshot_interval = std::stoull(value); }},
+        {"trades_per_second",
+         [&](const std::string& value) { config.trades_per_second = std::stod(value); }},
+        {"depth", [&](const std::string& value) { config.depth = std::stoull(value); }},
+        {"level_step", [&](const std::string& value) { config.level_step = std::stoull(value); }},
+        {"start_price",
+         [&](const std::string& value) { config.start_price = std::stoull(value); }},
+        {"volatility", [&](const std::string& value) { config.volatility = std::stod(value); }},
+        {"min_level_volume",
+         [&](const std::string& value) { config.min_level_volume = std::stoull(value); }},
+        {"max_level_volume",
+         [&](const std::string& value) { config.max_level_volume = std::stoull(value); }},
+        {"trade_size_median",
+         [&](const std::string& value) { config.trade_size_median = std::stod(value); }},
+        {"trade_size_sigma",
+         [&](const std::string& value) { config.trade_size_sigma = std::stod(value); }},
+        {"orderbook", [&](const std::string& value) { path_orderbook = value; }},
+        {"transactions", [&](const std::string& value) { path_transactions = value; }},
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        auto separator = argument.find('=');
+        auto it = setters.find(argument.substr(0, separator));
+        if (separator == std::string::npos || it == setters.end()) {
+            throw std::runtime_error("Execution - Unknown argument " + argument + ".");
+        }
+        it->second(argument.substr(separator + 1));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto stats = MarketGenerator(config).Generate(path_orderbook, path_transactions);
+    double seconds = GetSeconds(start);
+    std::cerr << "Generated " << stats.snapshots << " snapshots and " << stats.transactions
+              << " transactions (" << stats.bytes / (1 << 20) << " MiB) into " << path_orderbook
+              << " and " << path_transactions << ". time: " << seconds
+              << " events/sec: " << stats.GetEvents() / seconds << std::endl;
+}
+
+int main(int argc, char** argv) {
+    try {
+        Execution(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
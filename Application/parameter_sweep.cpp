@@ -0,0 +1,58 @@
+#include "../BackTest/backtest_includes.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+const std::string path_orderbook = "../Data/orderbooks_eth_depth50.csv";
+const std::string path_transactions = "../Data/trades_eth.csv";
+const uint64_t initial_time = 1603659600000;
+const uint64_t end_time = 1603663200000;
+const uint64_t step = 1000;
+
+double GetSeconds(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// usage: parameter-sweep
+// runs the grid of cnts, thresholds and butches of the top pressure strategy in one replay
+void Execution() {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<TopPressureParameters> parameters;
+    for (const uint64_t cnt : {1, 2, 3, 5, 10, 15, 20, 30}) {
+        for (const double threshold : {1, 2, 4, 6, 8, 12, 16, 32}) {
+            for (const uint64_t butch : {0, 10}) {
+                parameters.emplace_back(cnt, threshold, butch);
+            }
+        }
+    }
+    BackTest backtest(path_orderbook, path_transactions);
+    backtest.ProcessTimeInterval(initial_time);
+    TopPressureSweep sweep(parameters);
+    backtest.Run(sweep, end_time, step);
+    std::cerr << "Swept " << sweep.Size() << " parameter sets using " << ToString(GetKernelIsa())
+              << " kernels. time: " << GetSeconds(start) << std::endl;
+    // the position is valued at the last mid price
+    uint64_t mid = (backtest.GetQuote().ask_price + backtest.GetQuote().bid_price) / 2;
+    for (size_t lane = 0; lane < sweep.Size(); ++lane) {
+        auto pnl = sweep.GetPNL(lane);
+        std::cerr << "cnt = " << sweep.GetParameters(lane).cnt
+                  << " threshold = " << sweep.GetParameters(lane).threshold
+                  << " butch = " << sweep.GetParameters(lane).butch
+                  << " orders = " << sweep.GetOrdersCount(lane)
+                  << " filled_volume = " << sweep.GetFilledVolume(lane)
+                  << " total_cash = " << pnl.total_cash << " total_asset = " << pnl.total_asset
+                  << " value = " << pnl.total_cash + pnl.total_asset * static_cast<int64_t>(mid)
+                  << std::endl;
+    }
+}
+
+int main() {
+    try {
+        Execution();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
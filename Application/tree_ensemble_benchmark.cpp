@@ -0,0 +1,136 @@
+#include "../BackTest/backtest_includes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+
+std::mt19937 rnd(1791791791);
+
+const uint64_t feature_count = 27;
+const uint64_t tree_count = 500;
+const uint32_t depth = 6;
+const uint64_t rows = 100000;
+
+// the usual node-based layout, every level is a pointer dereference
+struct Node {
+    uint32_t feature;
+    double threshold;
+    double value;
+    std::unique_ptr<Node> left, right;
+};
+
+std::unique_ptr<Node> MakeNode(const std::vector<uint32_t>& features,
+                               const std::vector<double>& thresholds,
+                               const std::vector<double>& leaves, const uint32_t& level,
+                               const uint32_t& leaf) {
+    auto node = std::make_unique<Node>();
+    if (level == features.size()) {
+        node->value = leaves[leaf];
+        return node;
+    }
+    node->feature = features[level];
+    node->threshold = thresholds[level];
+    node->left = MakeNode(features, thresholds, leaves, level + 1, leaf);
+    node->right = MakeNode(features, thresholds, leaves, level + 1, leaf | (1u << level));
+    return node;
+}
+
+double PredictNodes(const std::vector<std::unique_ptr<Node>>& trees, const double* features) {
+    double prediction = 0;
+    for (const auto& tree : trees) {
+        const Node* node = tree.get();
+        while (node->left) {
+            node = features[node->feature] > node->threshold ? node->right.get()
+                                                             : node->left.get();
+        }
+        prediction += node->value;
+    }
+    return prediction;
+}
+
+double GetNanoseconds(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+template <typename TFunction>
+void MeasureLatency(const std::string& name, TFunction function) {
+    static const uint64_t samples = 20000;
+    std::vector<double> latencies;
+    for (uint64_t i = 0; i < samples; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function(i % rows);
+        latencies.emplace_back(GetNanoseconds(start));
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::cerr << name << ": p50 = " << latencies[samples / 2]
+              << " ns, p99 = " << latencies[samples * 99 / 100]
+              << " ns, max = " << latencies.back() << " ns" << std::endl;
+}
+
+void Execution() {
+    std::uniform_int_distribution<uint32_t> random_feature(0, feature_count - 1);
+    std::normal_distribution<double> random_value(0, 1);
+    TreeEnsemble ensemble(feature_count);
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (uint64_t tree = 0; tree < tree_count; ++tree) {
+        std::vector<uint32_t> features(depth);
+        std::vector<double> thresholds(depth);
+        std::vector<double> leaves(1u << depth);
+        for (uint32_t level = 0; level < depth; ++level) {
+            features[level] = random_feature(rnd);
+            thresholds[level] = random_value(rnd);
+        }
+        for (auto& leaf : leaves) {
+            leaf = random_value(rnd) / tree_count;
+        }
+        ensemble.AddTree(features, thresholds, leaves);
+        nodes.emplace_back(MakeNode(features, thresholds, leaves, 0, 0));
+    }
+    std::vector<double> features(rows * feature_count);
+    for (auto& feature : features) {
+        feature = random_value(rnd);
+    }
+
+    std::vector<double> expected(rows), single(rows), batched(rows);
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t row = 0; row < rows; ++row) {
+        expected[row] = PredictNodes(nodes, features.data() + row * feature_count);
+    }
+    std::cerr << "nodes: " << GetNanoseconds(start) / rows << " ns/row" << std::endl;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t row = 0; row < rows; ++row) {
+        single[row] = ensemble.Predict(features.data() + row * feature_count);
+    }
+    std::cerr << "flat: " << GetNanoseconds(start) / rows << " ns/row" << std::endl;
+    start = std::chrono::steady_clock::now();
+    ensemble.Predict(features.data(), rows, batched.data());
+    std::cerr << "flat batched: " << GetNanoseconds(start) / rows << " ns/row" << std::endl;
+    for (uint64_t row = 0; row < rows; ++row) {
+        if (std::abs(single[row] - expected[row]) > 1e-9 ||
+            std::abs(batched[row] - expected[row]) > 1e-9) {
+            throw std::runtime_error("Execution - Predictions of the layouts differ.");
+        }
+    }
+
+    volatile double sink = 0;
+    MeasureLatency("nodes latency", [&](const uint64_t& row) {
+        sink = sink + PredictNodes(nodes, features.data() + row * feature_count);
+    });
+    MeasureLatency("flat latency", [&](const uint64_t& row) {
+        sink = sink + ensemble.Predict(features.data() + row * feature_count);
+    });
+}
+
+int main() {
+    try {
+        Execution();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -1,23 +1,83 @@
 #include "../BackTest/backtest_includes.h"
 
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
 
 long double GetTime() {
     return (long double)clock() / CLOCKS_PER_SEC;
 }
 
+bool test_allocation_tracker = true;
 bool test_completed_transactions = true;
+bool test_book_kernels = true;
+bool test_feature_store = true;
+bool test_tree_ensemble = true;
 bool test_orders = true;
 bool test_orderbook = true;
 bool test_scanner = true;
+bool test_prefetcher = true;
+bool test_compact_data = true;
+bool test_market_generator = true;
 bool test_backtest = true;
+bool test_strategy = true;
+bool test_execution_models = true;
+bool test_lazy_book = true;
+bool test_trade_coalescing = true;
+bool test_level_updates = true;
+bool test_depth_view = true;
+bool test_queue_position = true;
+bool test_active_orders = true;
+bool test_accounts = true;
+bool test_parameter_sweep = true;
+bool test_trade_history = true;
+bool test_results_sink = true;
+bool test_event_log = true;
+bool test_coroutines = true;
+bool test_feature_export = true;
 
 const std::string path_orderbook = "../Data/orderbooks_eth_depth50.csv";
 const std::string path_transactions = "../Data/trades_eth.csv";
 const uint64_t initial_time = 1603659600000;
 
+// tests for allocation tracker
+
+void TestAllocationTracker() {
+    try {
+        ResetAllocations();
+        uint64_t before = GetThreadAllocations();
+        {
+            AllocationScope scope(MARKET_TRADE, MATCHING);
+            auto transaction = std::make_shared<CompletedTransaction>(1, 2, 3, true);
+            {
+                AllocationScope inner(FEATURES);
+                std::vector<uint64_t> values(100);
+            }
+        }
+        uint64_t allocations = GetThreadAllocations() - before;
+        PrintAllocations();
+        if (IsAllocationTrackingEnabled() &&
+            (GetAllocations(MARKET_TRADE, MATCHING).allocations != 1 ||
+             GetAllocations(MARKET_TRADE, FEATURES).bytes != 100 * sizeof(uint64_t) ||
+             allocations != 2)) {
+            throw std::logic_error("Allocations were counted incorrectly.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
 // tests for completed transactions
 
 void TestCompletedTransactions() {
@@ -32,6 +92,130 @@ void TestCompletedTransactions() {
     std::cerr << std::endl;
 }
 
+// tests for book kernels
+
+void TestBookKernels() {
+    try {
+        BookLevels ask, bid;
+        for (uint64_t i = 0; i < 7; ++i) {
+            ask.prices.emplace_back(1000 + i);
+            ask.volumes.emplace_back(10 * (i + 1));
+            bid.prices.emplace_back(999 - i);
+            bid.volumes.emplace_back(5 * (i + 1));
+        }
+        for (const auto& isa : {SCALAR, SSE2, AVX2}) {
+            if (!IsKernelIsaSupported(isa)) {
+                continue;
+            }
+            SetKernelIsa(isa);
+            std::cerr << ToString(isa) << ": cumulative volume = " << GetCumulativeVolume(ask, 5)
+                      << " imbalance = " << GetDepthWeightedImbalance(ask, bid, 7)
+                      << " micro price = " << GetMicroPrice(ask, bid)
+                      << " notional = " << GetNotionalNearMid(ask, bid, 20) << std::endl;
+            if (GetCumulativeVolume(ask, 5) != 150 || GetCumulativeVolume(bid, 100) != 140 ||
+                std::abs(GetDepthWeightedImbalance(ask, bid, 7) + 1.0 / 3) > 1e-12 ||
+                GetMicroPrice(ask, bid) != (1000.0 * 5 + 999.0 * 10) / 15 ||
+                GetNotionalNearMid(ask, bid, 20) != 1000 * 10 + 1001 * 20 + 999 * 5 + 998 * 10) {
+                throw std::logic_error("Book kernels returned incorrect values.");
+            }
+            std::vector<double> ask_cumulative = {0, 10, 30, 60}, bid_cumulative = {0, 20, 25, 30};
+            std::vector<uint64_t> depths = {0, 1, 1, 2, 3};
+            std::vector<double> thresholds = {8, 8, 4, 20, 2}, signals(5);
+            GetLaneSignals(ask_cumulative.data(), bid_cumulative.data(), depths.data(),
+                           thresholds.data(), 60, 5, signals.data());
+            std::vector<double> imbalances = {0, 1, -2, 3}, half_butches = {0, 0, 1, 1, 4};
+            std::vector<uint64_t> butches = {0, 1, 2, 3, 3};
+            std::vector<double> confirmed(5, 1);
+            GetLaneConfirmations(imbalances.data(), butches.data(), half_butches.data(), 5,
+                                 confirmed.data());
+            std::vector<double> prices = {100, 101, 99, 100, 102}, sides = {1, 1, -1, -1, 0};
+            std::vector<double> remaining = {5, 5, 5, 1, 5}, bid_fills(5), ask_fills(5);
+            GetLaneFills(prices.data(), sides.data(), remaining.data(), 100, 3, true, 5,
+                         bid_fills.data());
+            GetLaneFills(prices.data(), sides.data(), remaining.data(), 100, 3, false, 5,
+                         ask_fills.data());
+            if (signals != std::vector<double>({0, 1, 0, -1, -1}) ||
+                confirmed != std::vector<double>({1, 1, 0, 1, 0}) ||
+                bid_fills != std::vector<double>({3, 3, 0, 0, 0}) ||
+                ask_fills != std::vector<double>({0, 0, 3, 1, 0})) {
+                throw std::logic_error("Lane kernels returned incorrect values.");
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for feature store
+
+void TestFeatureStore() {
+    try {
+        FeatureStore feature_store;
+        auto last_two = feature_store.AddTradeCountWindow(2);
+        auto last_second = feature_store.AddTimeWindow(1000);
+        if (feature_store.AddTradeCountWindow(2) != last_two) {
+            throw std::logic_error("Registered the same window twice.");
+        }
+        feature_store.AddTransaction(CompletedTransaction(100, 10, 5, true));
+        feature_store.AddTransaction(CompletedTransaction(600, 20, 8, false));
+        feature_store.AddTransaction(CompletedTransaction(1200, 30, 6, true));
+        feature_store.GetWindow(last_two).Print();
+        feature_store.GetWindow(last_second).Print(false);
+        const auto& window = feature_store.GetWindow(last_two);
+        if (window.count != 2 || window.volume != 50 || window.signed_volume != 10 ||
+            window.GetVWAP() != (20 * 8 + 30 * 6) / 50) {
+            throw std::logic_error("Incorrect trade count window.");
+        }
+        feature_store.AdvanceTo(1700);
+        if (feature_store.GetWindow(last_second).count != 1 ||
+            feature_store.GetWindow(last_second).GetBuyerMakerImbalance() != 1) {
+            throw std::logic_error("Incorrect time window.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for tree ensemble
+
+void TestTreeEnsemble() {
+    try {
+        {
+            std::ofstream out("model_test.txt");
+            out << "features 3\nbias 0.5\n"
+                << "tree 2 split 0 1.5 split 2 -1 leaves 1 2 3 4\n"
+                << "tree 1 split 1 0 leaves -10 10\n";
+        }
+        TreeEnsemble ensemble("model_test.txt");
+        std::remove("model_test.txt");
+        std::vector<double> features = {1, 5, 0, 2, -1, -2, 2, 0, 3};
+        std::vector<double> expected = {0.5 + 3 + 10, 0.5 + 2 - 10, 0.5 + 4 - 10};
+        std::vector<double> predictions(3);
+        ensemble.Predict(features.data(), 3, predictions.data());
+        for (size_t row = 0; row < 3; ++row) {
+            std::cerr << "prediction = " << predictions[row] << std::endl;
+            if (predictions[row] != expected[row] ||
+                ensemble.Predict(features.data() + row * 3) != expected[row]) {
+                throw std::logic_error("Incorrect prediction of the tree ensemble.");
+            }
+        }
+        try {
+            ensemble.AddTree({3}, {0}, {1, 2});
+            throw std::logic_error(
+                "Added a split by a non-existent feature, but code didn't failed.");
+        } catch (const std::runtime_error& r) {
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
 // tests for orders
 
 void TestOrders() {
@@ -140,6 +324,218 @@ void TestScanner() {
     }
 }
 
+// tests for prefetcher
+
+void TestPrefetcher() {
+    try {
+        Scanner scanner;
+        scanner.ReadAll(path_orderbook, path_transactions);
+        auto before = GetTime();
+        Prefetcher prefetcher(path_orderbook, path_transactions, {7, 13, 2});
+        size_t snapshots = 0, transactions = 0;
+        for (; prefetcher.HasSnapshot(); prefetcher.PopSnapshot(), ++snapshots) {
+            if (snapshots >= scanner.GetAsk().size()) {
+                throw std::logic_error("Prefetcher returned too many snapshots.");
+            }
+            for (const auto& [rows, expected] :
+                 {std::make_pair(&prefetcher.GetAsk(), &scanner.GetAsk()[snapshots]),
+                  std::make_pair(&prefetcher.GetBid(), &scanner.GetBid()[snapshots])}) {
+                if (rows->size() != expected->size()) {
+                    throw std::logic_error("Incorrect snapshot depth in Prefetcher.");
+                }
+                for (size_t i = 0; i < rows->size(); ++i) {
+                    const auto& row = *(*rows)[i];
+                    const auto& expected_row = *(*expected)[i];
+                    if (row.GetSubmitTimestamp() != expected_row.GetSubmitTimestamp() ||
+                        row.GetPriceLimit() != expected_row.GetPriceLimit() ||
+                        row.GetVolume() != expected_row.GetVolume() ||
+                        row.GetOrderType() != expected_row.GetOrderType()) {
+                        throw std::logic_error("Incorrect snapshot in Prefetcher.");
+                    }
+                }
+            }
+        }
+        for (; prefetcher.HasTransaction(); prefetcher.PopTransaction(), ++transactions) {
+            if (transactions >= scanner.GetTransactions().size()) {
+                throw std::logic_error("Prefetcher returned too many transactions.");
+            }
+            const auto& transaction = prefetcher.GetTransaction();
+            const auto& expected = scanner.GetTransactions()[transactions];
+            if (transaction.GetTransactionTimestamp() != expected.GetTransactionTimestamp() ||
+                transaction.GetPrice() != expected.GetPrice() ||
+                transaction.GetVolume() != expected.GetVolume() ||
+                transaction.GetIsBuyerMaker() != expected.GetIsBuyerMaker()) {
+                throw std::logic_error("Incorrect transaction in Prefetcher.");
+            }
+        }
+        std::cerr << "time for prefetch: " << GetTime() - before << ", waits "
+                  << prefetcher.GetWaits() << std::endl;
+        if (snapshots != scanner.GetAsk().size() ||
+            transactions != scanner.GetTransactions().size()) {
+            throw std::logic_error("Prefetcher lost rows.");
+        }
+
+        // stopping in the middle of the files
+        {
+            Prefetcher stopped(path_orderbook, path_transactions, {1, 1, 1});
+            if (!stopped.HasSnapshot() || !stopped.HasTransaction()) {
+                throw std::logic_error("Prefetcher returned no rows.");
+            }
+        }
+
+        {
+            std::ofstream out("prefetcher_broken_test.csv");
+            out << "header\n0,100,1,2,True\n1,200,x,2,True\n";
+        }
+        Prefetcher broken(path_orderbook, "prefetcher_broken_test.csv");
+        bool has_thrown = false;
+        try {
+            while (broken.HasTransaction()) {
+                broken.PopTransaction();
+            }
+        } catch (const std::runtime_error&) {
+            has_thrown = true;
+        }
+        std::remove("prefetcher_broken_test.csv");
+        if (!has_thrown) {
+            throw std::logic_error("Prefetcher didn't pass the parsing error.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+// tests for compact data
+
+void TestCompactData() {
+    try {
+        auto is_same_side = [](const TLimitVector& lhs, const TLimitVector& rhs) {
+            if (lhs.size() != rhs.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < lhs.size(); ++i) {
+                if (lhs[i]->GetSubmitTimestamp() != rhs[i]->GetSubmitTimestamp() ||
+                    lhs[i]->GetPriceLimit() != rhs[i]->GetPriceLimit() ||
+                    lhs[i]->GetVolume() != rhs[i]->GetVolume() ||
+                    lhs[i]->GetOrderType() != rhs[i]->GetOrderType()) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        auto is_same_data = [&](const CompactDataset& data, const Scanner& scanner) {
+            const auto& snapshots = data.GetSnapshots();
+            const auto& transactions = data.GetTransactions();
+            if (snapshots.Size() != scanner.GetAsk().size() ||
+                transactions.Size() != scanner.GetTransactions().size()) {
+                return false;
+            }
+            for (size_t row = 0; row < snapshots.Size(); ++row) {
+                if (!is_same_side(snapshots.DecodeAsk(row), scanner.GetAsk()[row]) ||
+                    !is_same_side(snapshots.DecodeBid(row), scanner.GetBid()[row])) {
+                    return false;
+                }
+            }
+            for (size_t i = 0; i < transactions.Size(); ++i) {
+                auto transaction = transactions.Get(i);
+                const auto& expected = scanner.GetTransactions()[i];
+                if (transaction.GetTransactionTimestamp() != expected.GetTransactionTimestamp() ||
+                    transaction.GetPrice() != expected.GetPrice() ||
+                    transaction.GetVolume() != expected.GetVolume() ||
+                    transaction.GetIsBuyerMaker() != expected.GetIsBuyerMaker()) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        Scanner scanner;
+        scanner.ReadAll(path_orderbook, path_transactions);
+        auto before = GetTime();
+        CompactDataset data(scanner);
+        std::cerr << "time for compact: " << GetTime() - before << ", memory "
+                  << data.GetMemoryUsage() / 1024 << " KB" << std::endl;
+        data.GetScale().Print();
+        if (!is_same_data(data, scanner)) {
+            throw std::logic_error("Compact data differs from the parsed data.");
+        }
+        if (data.GetSnapshots().IsWide() || data.GetTransactions().IsWide()) {
+            throw std::logic_error("Compact data is widened without a reason.");
+        }
+
+        ReplayBook book, compact_book;
+        for (size_t row = 0; row < scanner.GetAsk().size(); ++row) {
+            book.UpdateOrderBook(scanner.GetAsk()[row], scanner.GetBid()[row]);
+            compact_book.UpdateOrderBook(data.GetSnapshots(), row);
+            if (book.GetAsk().prices != compact_book.GetAsk().prices ||
+                book.GetAsk().volumes != compact_book.GetAsk().volumes ||
+                book.GetBid().prices != compact_book.GetBid().prices ||
+                book.GetBid().volumes != compact_book.GetBid().volumes) {
+                throw std::logic_error("ReplayBook differs on compact snapshots.");
+            }
+        }
+
+        // values which don't fit into 32 bits
+        {
+            std::ofstream out("compact_orderbook_test.csv");
+            out << "header\n";
+            out << "0,1000,1.5,2.5,0.1,0.2,1.4,1.3,0.3,0\n";
+            out << "1,1000,1.5,50000000.00001,0.1,0.2,1.4,1.3,90000.00001,0\n";
+            out << "2,99999999999,1.5,2.5,0.1,0.2,1.4,1.3,0.3,0.4\n";
+        }
+        {
+            std::ofstream out("compact_transactions_test.csv");
+            out << "header\n0,1000,0.1,1.5,True\n1,10000000000,0.3,1.4,False\n";
+        }
+        Scanner wide_scanner;
+        wide_scanner.ReadAll("compact_orderbook_test.csv", "compact_transactions_test.csv");
+        std::remove("compact_orderbook_test.csv");
+        std::remove("compact_transactions_test.csv");
+        CompactDataset wide_data(wide_scanner);
+        if (!wide_data.GetSnapshots().IsWide() || !wide_data.GetTransactions().IsWide() ||
+            !is_same_data(wide_data, wide_scanner)) {
+            throw std::logic_error("Incorrect widening of compact data.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for market generator
+
+void TestMarketGenerator() {
+    try {
+        GeneratorConfig config;
+        config.duration = 600000;
+        config.depth = 10;
+        config.trades_per_second = 200;
+        auto stats = MarketGenerator(config).Generate("generated_orderbook_test.csv",
+                                                      "generated_transactions_test.csv");
+        std::cerr << "Generated " << stats.snapshots << " snapshots and " << stats.transactions
+                  << " transactions" << std::endl;
+        Scanner scanner;
+        scanner.ReadAll("generated_orderbook_test.csv", "generated_transactions_test.csv");
+        if (scanner.GetAsk().size() != stats.snapshots || scanner.GetAsk()[0].size() != 10 ||
+            scanner.GetTransactions().size() != stats.transactions) {
+            throw std::logic_error("Generated data were read incorrectly.");
+        }
+        BackTest backtest("generated_orderbook_test.csv", "generated_transactions_test.csv");
+        backtest.ProcessTimeInterval(config.start_timestamp + config.duration);
+        if (backtest.GetCompletedTrades().Size() < stats.transactions) {
+            throw std::logic_error("Generated transactions weren't replayed.");
+        }
+        std::remove("generated_orderbook_test.csv");
+        std::remove("generated_transactions_test.csv");
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
 // tests for backtest
 
 void TestBackTest() {
@@ -189,11 +585,1485 @@ void TestBackTest() {
     std::cerr << std::endl;
 }
 
+// tests for strategy driver
+
+class CountingStrategy : public BaseStrategy {
+public:
+    void OnBookUpdate(BackTest& /*backtest*/) {
+        ++book_updates;
+    }
+    void OnTrade(BackTest& /*backtest*/, const CompletedTransaction& /*transaction*/) {
+        ++trades;
+    }
+    void OnFill(BackTest& /*backtest*/, const BaseOrder& /*order*/,
+                const CompletedTransaction& transaction) {
+        filled_volume += transaction.GetVolume();
+    }
+    void OnOrderAck(BackTest& /*backtest*/, const uint64_t& /*order_id*/) {
+        ++acks;
+    }
+    void OnTimer(BackTest& backtest) {
+        ++timers;
+        if (timers == 1) {
+            backtest.SendMarketOrder(BID, 1000);
+        }
+    }
+
+    uint64_t book_updates = 0;
+    uint64_t trades = 0;
+    uint64_t filled_volume = 0;
+    uint64_t acks = 0;
+    uint64_t timers = 0;
+};
+
+void TestStrategy() {
+    try {
+        BackTest backtest(path_orderbook, path_transactions);
+        backtest.ProcessTimeInterval(initial_time);
+        CountingStrategy strategy;
+        backtest.Run(strategy, initial_time + 60000, 1000);
+        std::cerr << "book_updates = " << strategy.book_updates << " trades = " << strategy.trades
+                  << " filled_volume = " << strategy.filled_volume << " acks = " << strategy.acks
+                  << " timers = " << strategy.timers << std::endl;
+        if (strategy.timers != 60 || strategy.acks != 1 || strategy.filled_volume != 1000) {
+            throw std::logic_error("Strategy hooks were called incorrectly.");
+        }
+        auto stats = backtest.GetStats();
+        stats.Print();
+        if (IsInstrumentationEnabled() &&
+            (stats.events[BOOK_UPDATE] < strategy.book_updates ||
+             stats.events[MARKET_TRADE] < strategy.trades || stats.events[USER_MARKET_ORDER] != 1 ||
+             stats.orderbook.stages[UPDATE_ORDER_BOOK].calls != stats.events[BOOK_UPDATE])) {
+            throw std::logic_error("Incorrect event counters.");
+        }
+        Histogram histogram;
+        for (const uint64_t value : {0, 1, 2, 3, 4, 1000}) {
+            histogram.Add(value);
+        }
+        if (histogram.buckets[0] != 1 || histogram.buckets[1] != 1 || histogram.buckets[2] != 2 ||
+            histogram.buckets[3] != 1 || histogram.buckets[10] != 1 || histogram.max != 1000) {
+            throw std::logic_error("Incorrect histogram.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for lazy book
+
+std::vector<uint64_t> ReplaySparseOrders(const bool is_lazy) {
+    BackTest backtest(path_orderbook, path_transactions);
+    backtest.SetLazyBook(is_lazy);
+    backtest.ProcessTimeInterval(initial_time);
+    std::vector<uint64_t> results;
+    std::optional<uint64_t> limit_order;
+    for (uint64_t step = 0; step < 600; ++step) {
+        if (step % 20 == 0) {
+            backtest.SendMarketOrder(step % 40 == 0 ? BID : ASK, 100);
+        } else if (step % 20 == 5) {
+            limit_order = backtest.SendLimitOrder(BID, 1000, backtest.GetBestBid());
+        } else if (step % 20 == 10) {
+            backtest.WithdrawLimitOrder(limit_order.value());
+        }
+        // every few seconds the book is only read by the engine
+        backtest.ProcessTimeInterval(step % 7 == 0 ? 3000 : 1000);
+        auto pnl = backtest.GetPNL();
+        results.insert(
+            results.end(),
+            {backtest.GetBestAsk(), backtest.GetBestBid(), backtest.GetAsk().size(),
+             backtest.GetBid().size(), backtest.GetTotalMarketAsset(),
+             backtest.GetTotalMarketCash(), backtest.GetCompletedTrades().GetTotalCount(),
+             static_cast<uint64_t>(pnl.total_cash), static_cast<uint64_t>(pnl.total_asset),
+             backtest.GetOrderPosition(limit_order.value_or(0))});
+    }
+    return results;
+}
+
+void TestLazyBook() {
+    try {
+        if (ReplaySparseOrders(true) != ReplaySparseOrders(false)) {
+            throw std::logic_error("Lazy book changes the results.");
+        }
+        for (const bool is_lazy : {false, true}) {
+            BackTest backtest(path_orderbook, path_transactions);
+            backtest.SetLazyBook(is_lazy);
+            auto before = GetTime();
+            backtest.ProcessTimeInterval(initial_time + 3600000);
+            std::cerr << "time for replay without orders, lazy = " << is_lazy << ": "
+                      << GetTime() - before << ", trades "
+                      << backtest.GetCompletedTrades().GetTotalCount() << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for trade coalescing
+
+// the remaining volume of every order and the PnL, which don't depend on the coalescing
+// the PnL of account 0 and an isolated account which place the same orders, the number of rows
+// and then every fill of the orders as its order id, time, volume, price and aggressor side
+std::vector<uint64_t> ReplayRestingOrders(const bool is_coalescing) {
+    BackTest backtest(path_orderbook, path_transactions);
+    auto isolated = backtest.AddAccount(true);
+    backtest.SetTradeCoalescing(is_coalescing);
+    backtest.ProcessTimeInterval(initial_time);
+    std::vector<uint64_t> order_ids;
+    for (uint64_t step = 0; step < 600; ++step) {
+        if (step % 10 == 0) {
+            for (const size_t account : {size_t(0), isolated}) {
+                for (const auto& order : backtest.GetActiveOrders(account)) {
+                    backtest.WithdrawLimitOrder(order.first);
+                }
+                for (const auto& order :
+                     {backtest.SendLimitOrder(BID, 1000, backtest.GetBestBid(), account),
+                      backtest.SendLimitOrder(ASK, 1000, backtest.GetBestAsk(), account)}) {
+                    if (order) {
+                        order_ids.emplace_back(order.value());
+                    }
+                }
+            }
+        }
+        backtest.ProcessTimeInterval(1000);
+    }
+    std::vector<uint64_t> results;
+    for (const size_t account : {size_t(0), isolated}) {
+        auto pnl = backtest.GetPNL(account);
+        results.insert(results.end(), {static_cast<uint64_t>(pnl.total_cash),
+                                       static_cast<uint64_t>(pnl.total_asset)});
+    }
+    results.emplace_back(backtest.GetTransactionRows());
+    for (const auto& order_id : order_ids) {
+        for (const auto& fill : backtest.GetOrderInfo(order_id)->GetFilling()) {
+            results.insert(results.end(), {order_id, fill->GetTransactionTimestamp(),
+                                           fill->GetVolume(), fill->GetPrice(),
+                                           fill->GetIsBuyerMaker()});
+        }
+    }
+    return results;
+}
+
+void TestTradeCoalescing() {
+    try {
+        auto before = GetTime();
+        auto results = ReplayRestingOrders(false);
+        auto time_rows = GetTime() - before;
+        before = GetTime();
+        if (results != ReplayRestingOrders(true)) {
+            throw std::logic_error("Trade coalescing changes the fills.");
+        }
+        std::cerr << "time for replay with resting orders, coalescing = 0: " << time_rows
+                  << ", coalescing = 1: " << GetTime() - before << std::endl;
+        if (results.size() == 5) {
+            throw std::logic_error("No order was filled by the market transactions.");
+        }
+        uint64_t rows = 0;
+        for (const bool is_coalescing : {false, true}) {
+            BackTest backtest(path_orderbook, path_transactions);
+            backtest.SetTradeCoalescing(is_coalescing);
+            auto before = GetTime();
+            backtest.ProcessTimeInterval(initial_time + 3600000);
+            uint64_t events = backtest.GetTransactionRows() - backtest.GetCoalescedTransactions();
+            std::cerr << "time for replay without orders, coalescing = " << is_coalescing << ": "
+                      << GetTime() - before << ", rows " << backtest.GetTransactionRows()
+                      << ", trade events " << events << std::endl;
+            if (rows != 0 && rows != backtest.GetTransactionRows()) {
+                throw std::logic_error("Trade coalescing lost rows.");
+            }
+            rows = backtest.GetTransactionRows();
+            if (!is_coalescing && events != rows) {
+                throw std::logic_error("Transactions were merged without coalescing.");
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for level updates
+
+// the price and the volume columns of both sides of an orderbook line, by price
+std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>> ReadLevels(
+    const std::string& line) {
+    std::vector<std::string> blocks;
+    std::stringstream in(line);
+    for (std::string block; getline(in, block, ',');) {
+        blocks.emplace_back(block);
+    }
+    const size_t top = (blocks.size() - 2) / 4;
+    std::map<std::string, std::string> ask, bid;
+    for (size_t i = 0; i < top; ++i) {
+        ask[blocks[2 + i]] = blocks[2 + top + i];
+        bid[blocks[2 + 2 * top + i]] = blocks[2 + 3 * top + i];
+    }
+    return {ask, bid};
+}
+
+// the first snapshots of the sample as every resync_step-th snapshot and the level updates
+// between them, returns the timestamp of the last snapshot
+uint64_t WriteLevelUpdates(const size_t& snapshots, const size_t& resync_step,
+                           const std::string& path_snapshots, const std::string& path_updates) {
+    std::ifstream in(path_orderbook);
+    std::ofstream snapshots_out(path_snapshots), updates_out(path_updates);
+    std::string line;
+    getline(in, line);
+    snapshots_out << line << '\n';
+    updates_out << ",timestamp,side,price,volume\n";
+    std::map<std::string, std::string> previous_ask, previous_bid;
+    uint64_t timestamp = 0, rows = 0;
+    for (size_t i = 0; i < snapshots && getline(in, line); ++i) {
+        if (i % resync_step == 0) {
+            snapshots_out << line << '\n';
+        }
+        timestamp = std::stoull(line.substr(line.find(',') + 1));
+        auto [ask, bid] = ReadLevels(line);
+        for (const auto& [side, levels, previous_levels] :
+             {std::make_tuple("ASK", &ask, &previous_ask),
+              std::make_tuple("BID", &bid, &previous_bid)}) {
+            // the removals go first, a price can be written differently in the next line
+            for (const auto& [price, volume] : *previous_levels) {
+                if (levels->count(price) == 0) {
+                    updates_out << rows++ << ',' << timestamp << ',' << side << ',' << price
+                                << ",0\n";
+                }
+            }
+            for (const auto& [price, volume] : *levels) {
+                auto it = previous_levels->find(price);
+                if (it == previous_levels->end() || it->second != volume) {
+                    updates_out << rows++ << ',' << timestamp << ',' << side << ',' << price
+                                << ',' << volume << '\n';
+                }
+            }
+            *previous_levels = *levels;
+        }
+    }
+    return timestamp;
+}
+
+// a sparse feed from the first snapshot of the sample: every 100 ms the volumes of a few random
+// levels are replaced by the volumes of other levels of the same side. The full snapshots are
+// written to path_full, every resync_step-th of them to path_snapshots and the changes to
+// path_updates, returns the timestamp of the last snapshot
+uint64_t WriteSparseLevelUpdates(const size_t& steps, const size_t& changes,
+                                 const size_t& resync_step, const std::string& path_full,
+                                 const std::string& path_snapshots,
+                                 const std::string& path_updates) {
+    std::ifstream in(path_orderbook);
+    std::ofstream full_out(path_full), snapshots_out(path_snapshots), updates_out(path_updates);
+    std::string line;
+    getline(in, line);
+    full_out << line << '\n';
+    snapshots_out << line << '\n';
+    updates_out << ",timestamp,side,price,volume\n";
+    getline(in, line);
+    std::vector<std::string> blocks;
+    std::stringstream line_in(line);
+    for (std::string block; getline(line_in, block, ',');) {
+        blocks.emplace_back(block);
+    }
+    const size_t top = (blocks.size() - 2) / 4;
+    std::mt19937 rnd(1791791791);
+    std::uniform_int_distribution<size_t> random_level(0, top - 1), random_side(0, 1);
+    uint64_t timestamp = 0, rows = 0;
+    for (size_t i = 0; i < steps; ++i) {
+        timestamp = initial_time + 100 * i;
+        blocks[1] = std::to_string(timestamp);
+        for (size_t j = 0; i > 0 && j < changes; ++j) {
+            // the price column of the level is 2 + 2 * top * side + level
+            size_t side = random_side(rnd), level = random_level(rnd);
+            size_t price = 2 + 2 * top * side + level;
+            blocks[price + top] = blocks[2 + 2 * top * side + random_level(rnd) + top];
+            updates_out << rows++ << ',' << timestamp << ',' << (side == 0 ? "ASK" : "BID")
+                        << ',' << blocks[price] << ',' << blocks[price + top] << '\n';
+        }
+        blocks[0] = std::to_string(i);
+        std::string snapshot = blocks[0];
+        for (size_t j = 1; j < blocks.size(); ++j) {
+            snapshot += ',' + blocks[j];
+        }
+        full_out << snapshot << '\n';
+        if (i % resync_step == 0) {
+            snapshots_out << snapshot << '\n';
+        }
+    }
+    return timestamp;
+}
+
+// replays the full snapshots and the sparse snapshots with the level updates side by side and
+// compares the levels every 100 ms, with a user order resting in both books or without one
+void CompareLevelUpdates(const std::string& path_full, const std::string& path_snapshots,
+                         const std::string& path_updates, const std::string& path_trades,
+                         const uint64_t& end_timestamp, const bool has_user_order) {
+    BackTest snapshots(path_full, path_trades);
+    BackTest updates(path_snapshots, path_trades);
+    updates.SetLevelUpdates(path_updates);
+    snapshots.ProcessTimeInterval(initial_time);
+    updates.ProcessTimeInterval(initial_time);
+    std::optional<uint64_t> order_id;
+    if (has_user_order) {
+        snapshots.SendLimitOrder(BID, 1000, snapshots.GetBestBid());
+        order_id = updates.SendLimitOrder(BID, 1000, updates.GetBestBid());
+    }
+    uint64_t checks = 0;
+    while (snapshots.GetCurrentTimestamp() < end_timestamp) {
+        snapshots.ProcessTimeInterval(100);
+        updates.ProcessTimeInterval(100);
+        if (snapshots.GetAskLevels().prices != updates.GetAskLevels().prices ||
+            snapshots.GetAskLevels().volumes != updates.GetAskLevels().volumes ||
+            snapshots.GetBidLevels().prices != updates.GetBidLevels().prices ||
+            snapshots.GetBidLevels().volumes != updates.GetBidLevels().volumes) {
+            throw std::logic_error("Level updates don't match the snapshots.");
+        }
+        ++checks;
+    }
+    if (checks == 0) {
+        throw std::logic_error("Level updates weren't checked.");
+    }
+    if (order_id && updates.GetOrderPosition(order_id.value()) == -1) {
+        throw std::logic_error("The user order left the orderbook.");
+    }
+}
+
+// the time to replay the book from the full snapshots and from the sparse snapshots with the
+// level updates
+std::pair<long double, long double> TimeLevelUpdates(const std::string& path_full,
+                                                     const std::string& path_snapshots,
+                                                     const std::string& path_updates,
+                                                     const std::string& path_trades,
+                                                     const uint64_t& end_timestamp) {
+    std::vector<long double> times;
+    for (const bool use_updates : {false, true}) {
+        auto before = GetTime();
+        BackTest backtest(use_updates ? path_snapshots : path_full, path_trades);
+        if (use_updates) {
+            backtest.SetLevelUpdates(path_updates);
+        }
+        backtest.ProcessTimeInterval(end_timestamp);
+        times.emplace_back(GetTime() - before);
+    }
+    return {times[0], times[1]};
+}
+
+void TestLevelUpdates() {
+    try {
+        const std::string path_snapshots = "level_updates_test_orderbook.csv";
+        const std::string path_updates = "level_updates_test_updates.csv";
+        const std::string path_no_trades = "level_updates_test_trades.csv";
+        const std::string path_sparse = "level_updates_test_sparse.csv";
+        uint64_t end_timestamp = WriteLevelUpdates(1000, 200, path_snapshots, path_updates);
+        {
+            std::ofstream out(path_no_trades);
+            out << ",timestamp,volume,price,is_buyer_maker\n";
+        }
+        Scanner scanner;
+        scanner.ReadLevelUpdates(path_updates);
+        scanner.GetLevelUpdates().front().Print();
+
+        // without trades the updates keep the book equal to the snapshots
+        for (const bool has_user_order : {false, true}) {
+            CompareLevelUpdates(path_orderbook, path_snapshots, path_updates, path_no_trades,
+                                end_timestamp, has_user_order);
+        }
+        // nearly every level of the sample changes between its snapshots
+        auto [snapshots_time, updates_time] = TimeLevelUpdates(
+            path_orderbook, path_snapshots, path_updates, path_no_trades, end_timestamp);
+        std::cerr << "time for replay of the book, snapshots: " << snapshots_time
+                  << ", level updates: " << updates_time << std::endl;
+        std::cerr << "level updates " << scanner.GetLevelUpdates().size() << ", levels in the "
+                  << "snapshots " << 1000 * 100 << std::endl;
+
+        // a sparse feed changes 2 levels every 100 ms and resyncs every 500th snapshot
+        uint64_t sparse_end = WriteSparseLevelUpdates(5000, 2, 500, path_sparse, path_snapshots,
+                                                      path_updates);
+        CompareLevelUpdates(path_sparse, path_snapshots, path_updates, path_no_trades, sparse_end,
+                            false);
+        std::tie(snapshots_time, updates_time) = TimeLevelUpdates(
+            path_sparse, path_snapshots, path_updates, path_no_trades, sparse_end);
+        std::cerr << "time for replay of the sparse book, snapshots: " << snapshots_time
+                  << ", level updates: " << updates_time << std::endl;
+        if (updates_time > snapshots_time) {
+            throw std::logic_error("The sparse level updates are slower than the snapshots.");
+        }
+
+        {
+            std::ofstream out(path_updates);
+            out << "header\n0,1000,ASK,1.5,2\n1,1001,XYZ,1.5,2\n";
+        }
+        bool has_thrown = false;
+        try {
+            Scanner().ReadLevelUpdates(path_updates);
+        } catch (const std::runtime_error&) {
+            has_thrown = true;
+        }
+        std::remove(path_snapshots.c_str());
+        std::remove(path_updates.c_str());
+        std::remove(path_no_trades.c_str());
+        std::remove(path_sparse.c_str());
+        if (!has_thrown) {
+            throw std::logic_error("Scanner accepted an incorrect side.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for depth view
+
+void TestDepthView() {
+    try {
+        BackTest backtest(path_orderbook, path_transactions);
+        backtest.ProcessTimeInterval(initial_time);
+        BookLevels ask, bid;
+        uint64_t checks = 0;
+        for (uint64_t step = 0; step < 300; ++step) {
+            if (step % 10 == 0) {
+                backtest.SendLimitOrder(step % 20 == 0 ? ASK : BID, 1000,
+                                        step % 20 == 0 ? backtest.GetBestAsk()
+                                                       : backtest.GetBestBid());
+            }
+            // the views are read before and after the sets, in the lazy mode or not, the quote
+            // is read first after a change and then after the view
+            for (size_t i = 0; i < 2; ++i) {
+                Quote quote;
+                if (i == 0) {
+                    quote = backtest.GetQuote();
+                }
+                auto view = backtest.GetDepth(5);
+                if (i == 1) {
+                    quote = backtest.GetQuote();
+                }
+                FillBookLevels(backtest.GetAsk(), 5, ask);
+                FillBookLevels(backtest.GetBid(), 5, bid);
+                if (view.ask_depth != ask.Size() || view.bid_depth != bid.Size() ||
+                    !std::equal(ask.prices.begin(), ask.prices.end(), view.ask_prices) ||
+                    !std::equal(ask.volumes.begin(), ask.volumes.end(), view.ask_volumes) ||
+                    !std::equal(bid.prices.begin(), bid.prices.end(), view.bid_prices) ||
+                    !std::equal(bid.volumes.begin(), bid.volumes.end(), view.bid_volumes) ||
+                    quote.HasAsk() != (ask.Size() > 0) || quote.HasBid() != (bid.Size() > 0) ||
+                    (quote.HasAsk() && (quote.ask_price != ask.prices[0] ||
+                                        quote.ask_volume != ask.volumes[0])) ||
+                    (quote.HasBid() && (quote.bid_price != bid.prices[0] ||
+                                        quote.bid_volume != bid.volumes[0]))) {
+                    throw std::logic_error("Depth view differs from the orderbook.");
+                }
+                ++checks;
+            }
+            FillBookLevels(backtest.GetAsk(), -1, ask);
+            if (backtest.GetAskLevels().prices != ask.prices ||
+                backtest.GetAskLevels().volumes != ask.volumes) {
+                throw std::logic_error("Levels read after the depth view are incomplete.");
+            }
+            backtest.ProcessTimeInterval(step % 3 == 0 ? 100 : 1000);
+        }
+        std::cerr << "Checked " << checks << " depth views" << std::endl;
+        backtest.GetQuote().Print();
+        if (backtest.GetDepth().ask_depth != backtest.GetAskLevels().Size()) {
+            throw std::logic_error("Incorrect full depth view.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for execution models
+
+template <typename TBackTest>
+void SendTestOrders(TBackTest& backtest, std::vector<uint64_t>& send_timestamps) {
+    backtest.ProcessTimeInterval(initial_time);
+    for (uint64_t step = 0; step < 60; ++step) {
+        backtest.ProcessBeforeUnlock();
+        std::optional<uint64_t> order_id;
+        if (step % 10 == 0) {
+            order_id = backtest.SendMarketOrder(step % 20 == 0 ? BID : ASK, 100);
+        } else {
+            order_id = backtest.SendLimitOrder(step % 2 == 0 ? ASK : BID, 1000,
+                                               step % 2 == 0 ? backtest.GetBestAsk()
+                                                             : backtest.GetBestBid());
+        }
+        send_timestamps.push_back(backtest.GetCurrentTimestamp());
+        backtest.ProcessTimeInterval(5000);
+        if (step % 3 == 0) {
+            backtest.ProcessBeforeUnlock();
+            backtest.WithdrawLimitOrder(order_id.value());
+        }
+        backtest.ProcessTimeInterval(5000);
+    }
+    backtest.ProcessTimeInterval(backtest.GetPostLatency() + backtest.GetCancelLatency());
+}
+
+void TestExecutionModels() {
+    try {
+        const uint64_t maker_fee = 10, taker_fee = 20;
+        BackTest backtest(path_orderbook, path_transactions, maker_fee, taker_fee);
+        std::vector<uint64_t> send_timestamps;
+        SendTestOrders(backtest, send_timestamps);
+        int64_t total_cash = 0, total_asset = 0;
+        auto add_fills = [&](const auto& orders, const uint64_t& fee) {
+            for (const auto& order : orders) {
+                for (const auto& transaction : order->GetFilling()) {
+                    uint64_t cash = transaction->GetPrice() * transaction->GetVolume();
+                    if (order->GetOrderType() == ASK) {
+                        total_cash += cash * (10000 - fee) / 10000;
+                        total_asset -= transaction->GetVolume();
+                    } else {
+                        total_cash -= cash * (10000 + fee) / 10000;
+                        total_asset += transaction->GetVolume();
+                    }
+                }
+            }
+        };
+        add_fills(backtest.GetUserLimitAsk(), maker_fee);
+        add_fills(backtest.GetUserLimitBid(), maker_fee);
+        add_fills(backtest.GetUserMarketAsk(), taker_fee);
+        add_fills(backtest.GetUserMarketBid(), taker_fee);
+        backtest.GetPNL().Print();
+        if (backtest.GetPNL().total_cash != total_cash ||
+            backtest.GetPNL().total_asset != total_asset || total_asset == 0) {
+            throw std::logic_error("Incorrect PNL with maker and taker fees.");
+        }
+
+        TieredFee tiered_fee({{0, 10, 20}, {100, 5, 10}});
+        LimitOrder order(0, 0, BID, 180, 1);
+        std::vector<uint64_t> fees;
+        for (const auto& liquidity : {MAKER, TAKER, MAKER}) {
+            fees.push_back(
+                tiered_fee.GetFee(liquidity, order, CompletedTransaction(0, 60, 1, true)));
+        }
+        if (fees != std::vector<uint64_t>{10, 20, 5} || tiered_fee.GetTradedVolume() != 180) {
+            throw std::logic_error("Incorrect tiered fees.");
+        }
+
+        const std::vector<uint64_t> samples = {10, 300, 1000};
+        BasicBackTest<SampledLatency, TieredFee> sampled(path_orderbook, path_transactions,
+                                                         SampledLatency(samples, 7),
+                                                         TieredFee({{0, 10, 20}}));
+        send_timestamps.clear();
+        SendTestOrders(sampled, send_timestamps);
+        // the arrivals are clamped to keep the order of the requests
+        uint64_t last_arrival = 0;
+        std::set<uint64_t> latencies;
+        for (uint64_t order_id = 0; order_id < send_timestamps.size(); ++order_id) {
+            uint64_t arrival = sampled.GetOrderInfo(order_id)->GetSubmitTimestamp();
+            uint64_t latency = arrival - send_timestamps[order_id];
+            if (arrival < last_arrival || latency < 10 || latency > 1000) {
+                throw std::logic_error("Incorrect sampled latency.");
+            }
+            latencies.insert(latency);
+            last_arrival = arrival;
+        }
+        std::cerr << "Sampled latency: " << latencies.size() << " distinct values, traded volume "
+                  << sampled.GetFeeModel().GetTradedVolume() << std::endl;
+        if (latencies.size() < 2 || sampled.GetPostLatency() != 1000 ||
+            sampled.GetFeeModel().GetTradedVolume() == 0) {
+            throw std::logic_error("Incorrect models of BasicBackTest.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for queue position
+
+template <typename TLimitSet>
+std::pair<uint64_t, uint64_t> GetAheadLinear(const TLimitSet& orders, const uint64_t& order_id) {
+    uint64_t count = 0, volume = 0;
+    for (const auto& order : orders) {
+        if (order->GetOrderId() == order_id) {
+            return {count, volume};
+        }
+        ++count;
+        volume += order->GetRemainingVolume();
+    }
+    return {-1, -1};
+}
+
+void TestQueuePosition() {
+    try {
+        std::mt19937 rnd(1791791791);
+        BackTest backtest(path_orderbook, path_transactions);
+        backtest.ProcessTimeInterval(initial_time);
+        std::vector<uint64_t> order_ids;
+        uint64_t checked = 0;
+        for (uint64_t step = 0; step < 600; ++step) {
+            backtest.ProcessBeforeUnlock();
+            uint64_t mid = (backtest.GetBestAsk() + backtest.GetBestBid()) / 2;
+            int64_t shift = static_cast<int64_t>(rnd() % 2001) - 1000;
+            if (step % 3 == 2 && !order_ids.empty()) {
+                backtest.WithdrawLimitOrder(order_ids[rnd() % order_ids.size()]);
+            } else {
+                auto id = backtest.SendLimitOrder(shift > 0 ? ASK : BID, 1000 + rnd() % 100000,
+                                                  mid + shift * 10);
+                order_ids.emplace_back(id.value());
+            }
+            backtest.ProcessTimeInterval(1000);
+            for (const auto& order_id : order_ids) {
+                auto order = backtest.GetOrderInfo(order_id);
+                auto expected = order->GetOrderType() == ASK
+                                    ? GetAheadLinear(backtest.GetAsk(), order_id)
+                                    : GetAheadLinear(backtest.GetBid(), order_id);
+                if (backtest.GetOrderPosition(order_id) != expected.first ||
+                    backtest.GetVolumeAhead(order_id) != expected.second) {
+                    throw std::logic_error("Incorrect position of an order.");
+                }
+                checked += expected.first != -1;
+            }
+        }
+        std::cerr << "Checked " << checked << " positions of orders in the orderbook" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for active orders
+
+void TestActiveOrders() {
+    try {
+        std::mt19937 rnd(1791791791);
+        BackTest backtest(path_orderbook, path_transactions);
+        backtest.ProcessTimeInterval(initial_time);
+        // the remaining volumes of the active orders rebuilt from the change feed only
+        std::map<uint64_t, uint64_t> remaining;
+        std::vector<uint64_t> order_ids;
+        uint64_t changes = 0, max_active = 0;
+        auto read_changes = [&]() {
+            for (const auto& change : backtest.GetOrderChanges()) {
+                if (change.order_change == CHANGE_FILL) {
+                    remaining.at(change.order_id) -= change.volume;
+                } else if (change.volume != remaining.at(change.order_id)) {
+                    throw std::logic_error("Incorrect remaining volume in the change feed.");
+                } else if (change.order_change != CHANGE_ACK) {
+                    remaining.erase(change.order_id);
+                }
+                ++changes;
+            }
+        };
+        // the steps are longer than the call frequency, so every call is accepted
+        for (uint64_t step = 0; step < 600; ++step) {
+            uint64_t mid = (backtest.GetBestAsk() + backtest.GetBestBid()) / 2;
+            int64_t shift = static_cast<int64_t>(rnd() % 2001) - 1000;
+            std::optional<uint64_t> id;
+            if (step % 3 == 2 && !order_ids.empty()) {
+                backtest.WithdrawLimitOrder(order_ids[rnd() % order_ids.size()]);
+            } else if (step % 10 == 0) {
+                id = backtest.SendMarketOrder(shift > 0 ? ASK : BID, 1000 + rnd() % 100000);
+            } else {
+                id = backtest.SendLimitOrder(shift > 0 ? ASK : BID, 1000 + rnd() % 100000,
+                                             mid + shift * 10);
+                order_ids.emplace_back(id.value());
+            }
+            if (id) {
+                remaining[id.value()] = backtest.FindActiveOrder(id.value())->volume;
+            }
+            backtest.ProcessTimeInterval(1000);
+            read_changes();
+            const auto& active_orders = backtest.GetActiveOrders();
+            max_active = std::max<uint64_t>(max_active, active_orders.size());
+            if (active_orders.size() != remaining.size()) {
+                throw std::logic_error("The change feed doesn't match the active orders.");
+            }
+            for (const auto& [order_id, order] : active_orders) {
+                auto info = backtest.GetOrderInfo(order_id);
+                auto limit_order = dynamic_cast<const LimitOrder*>(info.get());
+                if (remaining.at(order_id) != order.remaining_volume ||
+                    info->GetRemainingVolume() != order.remaining_volume || info->IsClosed() ||
+                    !limit_order || limit_order->IsCanceled() ||
+                    (order.state == ORDER_PARTIALLY_FILLED) == info->GetFilling().empty()) {
+                    throw std::logic_error("Incorrect active order.");
+                }
+            }
+            for (const auto& order_id : order_ids) {
+                auto info = backtest.GetOrderInfo(order_id);
+                if (!backtest.FindActiveOrder(order_id) && !info->IsClosed() &&
+                    !static_cast<const LimitOrder*>(info.get())->IsCanceled()) {
+                    throw std::logic_error("An open order isn't active.");
+                }
+            }
+        }
+        std::cerr << "Checked " << changes << " order changes, at most " << max_active
+                  << " active orders of " << order_ids.size() << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for accounts
+
+// the account i + 1 runs random orders from seeds[i], account 0 keeps the shared book without
+// user orders, returns the cash and the asset of the accounts
+// the PnL, the sum of the positions and the sum of the volumes ahead of the last order of every
+// strategy, each strategy trades in a new account or, for a plain replay, the only one in account 0
+std::vector<int64_t> ReplayAccounts(const std::vector<uint64_t>& seeds, const bool is_isolated,
+                                    const bool is_plain = false, const bool is_lazy = true) {
+    BackTest backtest(path_orderbook, path_transactions);
+    backtest.SetLazyBook(is_lazy);
+    std::vector<size_t> accounts;
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        accounts.emplace_back(is_plain ? 0 : backtest.AddAccount(is_isolated));
+    }
+    backtest.ProcessTimeInterval(initial_time);
+    std::vector<std::mt19937> generators(seeds.begin(), seeds.end());
+    std::vector<std::vector<uint64_t>> order_ids(seeds.size());
+    std::vector<uint64_t> positions(seeds.size()), volumes_ahead(seeds.size());
+    for (uint64_t step = 0; step < 300; ++step) {
+        // the user orders in the shared orderbook don't move the mid price
+        auto is_historical = [](const TLimit& order) { return order->GetOrderId() == -1; };
+        uint64_t mid = ((*std::find_if(backtest.GetAsk().begin(), backtest.GetAsk().end(),
+                                       is_historical))->GetPriceLimit() +
+                        (*std::find_if(backtest.GetBid().begin(), backtest.GetBid().end(),
+                                       is_historical))->GetPriceLimit()) / 2;
+        for (size_t i = 0; i < seeds.size(); ++i) {
+            auto& rnd = generators[i];
+            int64_t shift = static_cast<int64_t>(rnd() % 2001) - 1000;
+            auto order_type = shift > 0 ? ASK : BID;
+            if (step % 3 == 2 && !order_ids[i].empty()) {
+                backtest.WithdrawLimitOrder(order_ids[i][rnd() % order_ids[i].size()]);
+            } else if (step % 10 == 0) {
+                backtest.SendMarketOrder(order_type, 100 + rnd() % 1000, accounts[i]);
+            } else {
+                auto id = backtest.SendLimitOrder(order_type, 1000 + rnd() % 100000,
+                                                  mid + shift * 10, accounts[i]);
+                order_ids[i].emplace_back(id.value());
+            }
+        }
+        backtest.ProcessTimeInterval(1000);
+        for (size_t i = 0; i < seeds.size(); ++i) {
+            if (!order_ids[i].empty()) {
+                positions[i] += backtest.GetOrderPosition(order_ids[i].back());
+                volumes_ahead[i] += backtest.GetVolumeAhead(order_ids[i].back());
+            }
+        }
+    }
+    std::vector<int64_t> results;
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        auto pnl = backtest.GetPNL(accounts[i]);
+        results.insert(results.end(),
+                       {pnl.total_cash, pnl.total_asset, static_cast<int64_t>(positions[i]),
+                        static_cast<int64_t>(volumes_ahead[i])});
+    }
+    return results;
+}
+
+void TestAccounts() {
+    try {
+        std::vector<uint64_t> seeds = {1, 2, 3, 4};
+        auto before = GetTime();
+        auto results = ReplayAccounts(seeds, true);
+        auto time_isolated_accounts = GetTime() - before;
+        before = GetTime();
+        for (size_t i = 0; i < seeds.size(); ++i) {
+            auto single = ReplayAccounts({seeds[i]}, false, true);
+            if (!std::equal(single.begin(), single.end(), results.begin() + 4 * i)) {
+                throw std::logic_error("An isolated account differs from a replay of its own.");
+            }
+        }
+        auto time_separate_replays = GetTime() - before;
+        if (ReplayAccounts(seeds, true, false, false) != results) {
+            throw std::logic_error("The overlays depend on the lazy mode.");
+        }
+        before = GetTime();
+        ReplayAccounts(seeds, false);
+        std::cerr << "time for " << seeds.size()
+                  << " isolated accounts: " << time_isolated_accounts
+                  << ", shared accounts: " << GetTime() - before
+                  << ", separate replays: " << time_separate_replays << std::endl;
+
+        BackTest backtest(path_orderbook, path_transactions);
+        auto shared = backtest.AddAccount();
+        auto isolated = backtest.AddAccount(true);
+        backtest.ProcessTimeInterval(initial_time);
+        std::vector<uint64_t> order_ids;
+        for (const size_t account : {size_t(0), shared, isolated}) {
+            order_ids.emplace_back(
+                backtest.SendLimitOrder(BID, 1000, backtest.GetBestBid(), account).value());
+            if (backtest.SendLimitOrder(BID, 1000, backtest.GetBestBid(), account)) {
+                throw std::logic_error("The call frequency budget is shared.");
+            }
+        }
+        backtest.ProcessTimeInterval(backtest.GetPostLatency());
+        // the order of the shared account stands behind the first one, the isolated doesn't
+        auto position = backtest.GetOrderPosition(order_ids[0]);
+        if (backtest.GetOrderAccount(order_ids[2]) != isolated ||
+            backtest.GetUserLimitBid().size() != 2 ||
+            backtest.GetActiveOrders(isolated).size() != 1 ||
+            backtest.GetOrderPosition(order_ids[1]) != position + 1 ||
+            backtest.GetOrderPosition(order_ids[2]) != position) {
+            throw std::logic_error("Incorrect orders of the accounts.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for parameter sweep
+
+// GetTopPressurePrediction and GetCountTransactionsPredictoin of main.cpp agreed with the
+// parameters of a lane, 0 while the trade window isn't full instead of a random prediction
+double GetMainSignal(const BackTest& backtest, const TopPressureParameters& parameters) {
+    int64_t diff = 0;
+    uint64_t cur = 0;
+    for (const auto& order : backtest.GetAsk()) {
+        if (cur++ == parameters.cnt) {
+            break;
+        }
+        diff += order->GetVolume();
+    }
+    cur = 0;
+    for (const auto& order : backtest.GetBid()) {
+        if (cur++ == parameters.cnt) {
+            break;
+        }
+        diff -= order->GetVolume();
+    }
+    double signal = 0;
+    if (std::abs(diff) * parameters.threshold >= backtest.GetTotalMarketAsset()) {
+        signal = diff > 0 ? -1 : 1;
+    }
+    if (parameters.butch == 0) {
+        return signal;
+    }
+    const auto& window = backtest.GetFeatureStore().GetTradeCountWindow(parameters.butch);
+    int64_t balance = window.GetBuyerMakerImbalance();
+    if (window.count < parameters.butch ||
+        static_cast<uint64_t>(std::abs(balance)) < parameters.butch / 2 ||
+        (balance > 0 ? 1 : -1) != signal) {
+        return 0;
+    }
+    return signal;
+}
+
+// the sweep, which compares the signal of the last lane with main.cpp at every timer
+class CheckedSweep : public BaseStrategy {
+public:
+    explicit CheckedSweep(const std::vector<TopPressureParameters>& parameters)
+        : sweep(parameters) {
+    }
+    template <typename TBackTest>
+    void OnTrade(TBackTest& backtest, const CompletedTransaction& transaction) {
+        sweep.OnTrade(backtest, transaction);
+    }
+    template <typename TBackTest>
+    void OnTimer(TBackTest& backtest) {
+        sweep.OnTimer(backtest);
+        size_t lane = sweep.Size() - 1;
+        double signal = GetMainSignal(backtest, sweep.GetParameters(lane));
+        if (signal != sweep.GetSignal(lane)) {
+            throw std::logic_error("The last lane differs from the predictions of main.cpp.");
+        }
+        trades += signal != 0;
+    }
+    TopPressureSweep sweep;
+    uint64_t trades = 0;
+};
+
+std::vector<ForPNL> ReplaySweep(const std::vector<TopPressureParameters>& parameters,
+                                std::vector<uint64_t>& orders) {
+    BackTest backtest(path_orderbook, path_transactions);
+    backtest.ProcessTimeInterval(initial_time);
+    // the window sees the same transactions as the sweep
+    if (parameters.back().butch != 0) {
+        backtest.GetFeatureStore().AddTradeCountWindow(parameters.back().butch);
+    }
+    CheckedSweep checked(parameters);
+    backtest.Run(checked, initial_time + 1200000, 1000);
+    if (checked.trades == 0) {
+        throw std::logic_error("The last lane never trades.");
+    }
+    const auto& sweep = checked.sweep;
+    std::vector<ForPNL> results;
+    orders.clear();
+    for (size_t lane = 0; lane < sweep.Size(); ++lane) {
+        results.emplace_back(sweep.GetPNL(lane));
+        orders.emplace_back(sweep.GetOrdersCount(lane));
+    }
+    return results;
+}
+
+bool operator==(const ForPNL& first, const ForPNL& second) {
+    return first.total_cash == second.total_cash && first.total_asset == second.total_asset &&
+           first.timestamp == second.timestamp;
+}
+
+void TestParameterSweep() {
+    auto isa = GetKernelIsa();
+    try {
+        std::vector<TopPressureParameters> parameters;
+        size_t same_lane = 0;
+        for (const uint64_t cnt : {1, 2, 5, 10, 20}) {
+            for (const double threshold : {2, 4, 8, 16}) {
+                for (const uint64_t butch : {0, 10}) {
+                    if (cnt == 10 && threshold == 8 && butch == 10) {
+                        same_lane = parameters.size();
+                    }
+                    parameters.emplace_back(cnt, threshold, butch);
+                }
+            }
+        }
+        // the signals of the last lane are checked against main.cpp, but not its PnL: the lane
+        // fills regardless of the queue and pays no fees
+        parameters.emplace_back(10, 8, 10);
+        std::vector<uint64_t> orders, single_orders;
+        auto before = GetTime();
+        auto results = ReplaySweep(parameters, orders);
+        std::cerr << "time for a sweep of " << parameters.size()
+                  << " lanes: " << GetTime() - before;
+        before = GetTime();
+        auto single = ReplaySweep({parameters.back()}, single_orders);
+        std::cerr << ", one lane: " << GetTime() - before << std::endl;
+        if (!(results.back() == single[0]) || !(results[same_lane] == single[0]) ||
+            orders.back() != single_orders[0] || orders.back() == 0) {
+            throw std::logic_error("A lane depends on the other lanes.");
+        }
+        for (const auto& other_isa : {SCALAR, SSE2, AVX2}) {
+            if (!IsKernelIsaSupported(other_isa)) {
+                continue;
+            }
+            SetKernelIsa(other_isa);
+            std::vector<uint64_t> other_orders;
+            if (ReplaySweep(parameters, other_orders) != results || other_orders != orders) {
+                throw std::logic_error("The lane kernels depend on the isa.");
+            }
+        }
+        SetKernelIsa(isa);
+        for (const size_t lane : {size_t(0), same_lane - 1, parameters.size() - 1}) {
+            parameters[lane].Print(false);
+            results[lane].Print(false);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for trade history
+
+void TestTradeHistory() {
+    try {
+        TradeHistory history({3, 1000, ""});
+        for (const uint64_t timestamp : {100, 200, 300, 400, 1350}) {
+            history.Add(std::make_shared<CompletedTransaction>(timestamp, 1, 1, true));
+        }
+        if (history.Size() != 2 || history.GetFirstIndex() != 3 ||
+            history.Get(3)->GetTransactionTimestamp() != 400) {
+            throw std::logic_error("Incorrect retention of the trade history.");
+        }
+
+        BackTest full(path_orderbook, path_transactions);
+        BackTest bounded(path_orderbook, path_transactions);
+        bounded.SetTradeRetention({100, -1ull, "trade_log_test.bin"});
+        for (auto* backtest : {&full, &bounded}) {
+            backtest->ProcessTimeInterval(initial_time);
+            for (uint64_t step = 0; step < 60; ++step) {
+                backtest->ProcessBeforeUnlock();
+                backtest->SendLimitOrder(step % 2 == 0 ? ASK : BID, 1000,
+                                         step % 2 == 0 ? backtest->GetBestAsk()
+                                                       : backtest->GetBestBid());
+                backtest->ProcessTimeInterval(10000);
+            }
+        }
+        bounded.FlushTradeLog();
+        auto records = ReadTradeLog("trade_log_test.bin");
+        std::cerr << "Logged " << records.size() << " transactions, "
+                  << bounded.GetCompletedTrades().Size() << " are in memory" << std::endl;
+        if (bounded.GetCompletedTrades().Size() > 100 ||
+            records.size() != full.GetCompletedTrades().Size() ||
+            bounded.GetCompletedTrades().GetTotalCount() != records.size()) {
+            throw std::logic_error("Incorrect number of transactions in the trade log.");
+        }
+        uint64_t user_fills = 0;
+        for (size_t i = 0; i < records.size(); ++i) {
+            const auto& transaction = *full.GetCompletedTrades().Get(i);
+            if (!(records[i] == TradeLogRecord(transaction, records[i].order_id))) {
+                throw std::logic_error("Incorrect transaction in the trade log.");
+            }
+            user_fills += records[i].order_id != -1;
+        }
+        std::cerr << "User fills in the log: " << user_fills << std::endl;
+        std::remove("trade_log_test.bin");
+
+        for (const auto* trades : {&full.GetCompletedTrades(), &bounded.GetCompletedTrades()}) {
+            uint64_t total = trades->GetTotalCount();
+            for (const uint64_t length : {0, 1, 10, 50, 100}) {
+                uint64_t from = total - length;
+                TradeWindowStats expected;
+                for (uint64_t i = from; i < total; ++i) {
+                    const auto& transaction = *trades->Get(i);
+                    int64_t sign = transaction.GetIsBuyerMaker() ? 1 : -1;
+                    ++expected.count;
+                    expected.volume += transaction.GetVolume();
+                    expected.signed_volume += sign * transaction.GetVolume();
+                    expected.notional += transaction.GetPrice() * transaction.GetVolume();
+                    expected.buyer_maker_count += transaction.GetIsBuyerMaker();
+                }
+                auto stats = trades->GetStats(from, total);
+                if (stats.count != expected.count || stats.volume != expected.volume ||
+                    stats.signed_volume != expected.signed_volume ||
+                    stats.notional != expected.notional ||
+                    stats.buyer_maker_count != expected.buyer_maker_count ||
+                    trades->GetVWAP(from, total) != expected.GetVWAP() ||
+                    trades->GetSignedVolume(from, total) != expected.signed_volume) {
+                    throw std::logic_error("Incorrect range stats of the trade history.");
+                }
+            }
+            uint64_t to_timestamp = trades->Get(total - 1)->GetTransactionTimestamp();
+            uint64_t from_index = trades->GetIndexByTime(to_timestamp - 5000);
+            if (trades->GetTimeStats(to_timestamp - 5000, to_timestamp + 1).count !=
+                    total - from_index ||
+                (from_index > trades->GetFirstIndex() &&
+                 trades->Get(from_index - 1)->GetTransactionTimestamp() >= to_timestamp - 5000)) {
+                throw std::logic_error("Incorrect time range of the trade history.");
+            }
+        }
+        bool has_thrown = false;
+        try {
+            bounded.GetCompletedTrades().GetStats(0, 1);
+        } catch (const std::runtime_error&) {
+            has_thrown = true;
+        }
+        if (!has_thrown) {
+            throw std::logic_error("Range stats of dropped transactions were returned.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for results sink
+
+void TestResultsSink() {
+    try {
+        SpscQueue<uint64_t> queue(100);
+        const uint64_t count = 1000000;
+        std::thread producer([&queue]() {
+            for (uint64_t value = 0; value < count; ++value) {
+                while (!queue.TryPush(value)) {
+                }
+            }
+        });
+        for (uint64_t expected = 0, value = 0; expected < count; ++expected) {
+            while (!queue.TryPop(value)) {
+            }
+            if (value != expected) {
+                producer.join();
+                throw std::logic_error("Incorrect order of the SpscQueue values.");
+            }
+        }
+        producer.join();
+
+        // ProcessBeforeUnlock may add intervals
+        uint64_t intervals = 0, orders = 0, cancels = 0, fills = 0;
+        ForPNL pnl;
+        {
+            ResultsSink sink("results_test_", 16);
+            BackTest backtest(path_orderbook, path_transactions);
+            backtest.SetResultsSink(&sink);
+            backtest.ProcessTimeInterval(initial_time);
+            ++intervals;
+            for (uint64_t step = 0; step < 60; ++step) {
+                backtest.ProcessBeforeUnlock();
+                std::optional<uint64_t> order_id;
+                if (step % 10 == 0) {
+                    order_id = backtest.SendMarketOrder(BID, 100);
+                } else {
+                    order_id = backtest.SendLimitOrder(step % 2 == 0 ? ASK : BID, 1000,
+                                                       step % 2 == 0 ? backtest.GetBestAsk()
+                                                                     : backtest.GetBestBid());
+                }
+                orders += order_id.has_value();
+                backtest.ProcessTimeInterval(5000);
+                if (order_id && step % 3 == 0) {
+                    cancels += backtest.WithdrawLimitOrder(*order_id);
+                }
+                backtest.ProcessTimeInterval(5000);
+                intervals += 2;
+            }
+            backtest.ProcessBeforeUnlock();
+            for (const auto& user_orders :
+                 {backtest.GetUserLimitAsk(), backtest.GetUserLimitBid()}) {
+                for (const auto& order : user_orders) {
+                    fills += order->GetFilling().size();
+                }
+            }
+            for (const auto& user_orders :
+                 {backtest.GetUserMarketAsk(), backtest.GetUserMarketBid()}) {
+                for (const auto& order : user_orders) {
+                    fills += order->GetFilling().size();
+                }
+            }
+            pnl = backtest.GetPNL();
+            sink.Flush();
+            std::cerr << "Queue stalls: " << sink.GetStalls() << std::endl;
+        }
+        std::string last_row;
+        auto count_rows = [&last_row](const std::string& path) {
+            std::ifstream in(path);
+            std::string line;
+            uint64_t rows = 0;
+            for (std::getline(in, line); std::getline(in, line); ++rows) {
+                last_row = line;
+            }
+            std::remove(path.c_str());
+            return rows;
+        };
+        uint64_t pnl_rows = count_rows("results_test_pnl.csv");
+        std::string last_pnl_row = last_row;
+        std::string pnl_row = std::to_string(pnl.timestamp) + ',' +
+                              std::to_string(pnl.total_cash) + ',' +
+                              std::to_string(pnl.total_asset) + ',';
+        uint64_t order_rows = count_rows("results_test_orders.csv");
+        uint64_t fill_rows = count_rows("results_test_fills.csv");
+        std::cerr << "Written " << pnl_rows << " pnl rows, " << order_rows << " order rows, "
+                  << fill_rows << " fill rows" << std::endl;
+        if (pnl_rows < intervals || last_pnl_row.rfind(pnl_row, 0) != 0 ||
+            order_rows != 2 * (orders + cancels) || fill_rows != fills) {
+            throw std::logic_error("Incorrect number of rows in the results.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for event log
+
+void TestEventLog() {
+    try {
+        OpenEventLog("event_log_test.bin");
+        uint64_t orders = 0, fills = 0;
+        {
+            BackTest backtest(path_orderbook, path_transactions);
+            backtest.ProcessTimeInterval(initial_time);
+            for (uint64_t step = 0; step < 30; ++step) {
+                backtest.ProcessBeforeUnlock();
+                orders += backtest
+                              .SendLimitOrder(step % 2 == 0 ? ASK : BID, 1000,
+                                              step % 2 == 0 ? backtest.GetBestAsk()
+                                                            : backtest.GetBestBid())
+                              .has_value();
+                backtest.ProcessTimeInterval(10000);
+            }
+            for (const auto& user_orders :
+                 {backtest.GetUserLimitAsk(), backtest.GetUserLimitBid()}) {
+                for (const auto& order : user_orders) {
+                    fills += order->GetFilling().size();
+                }
+            }
+        }
+        // the buffer of another thread is written when it exits
+        std::thread([]() { BACKTEST_LOG(LOG_CANCEL_ACK, 1, 2); }).join();
+
+        const uint64_t count = 1000000;
+        auto before = GetTime();
+        for (uint64_t i = 0; i < count; ++i) {
+            BACKTEST_LOG(LOG_MARKET_TRADE, i, i, 1, 0, 0);
+        }
+        std::cerr << "time for " << count << " records: " << GetTime() - before << std::endl;
+        CloseEventLog();
+        BACKTEST_LOG(LOG_CANCEL_ACK, 1, 3);
+
+        auto records = ReadEventLog("event_log_test.bin");
+        std::remove("event_log_test.bin");
+        std::vector<uint64_t> counts(LOG_EVENTS_COUNT, 0);
+        std::set<uint32_t> threads;
+        for (const auto& record : records) {
+            ++counts[record.event];
+            threads.insert(record.thread);
+        }
+        std::cerr << "Logged " << records.size() << " records, the first one: "
+                  << Format(records.front()) << std::endl;
+        if (counts[LOG_ORDER_SUBMIT] != orders || counts[LOG_ORDER_ACK] != orders ||
+            counts[LOG_FILL] != fills || counts[LOG_BOOK_UPDATE] == 0 ||
+            counts[LOG_CANCEL_ACK] != 1 || threads.size() != 2 ||
+            counts[LOG_MARKET_TRADE] < count) {
+            throw std::logic_error("Incorrect number of records in the event log.");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+// tests for coroutine strategies
+
+#ifdef BACKTEST_COROUTINES
+
+StrategyTask SleepTwice(CoroutineEngine<>& engine, std::vector<uint64_t>& wakes) {
+    for (size_t i = 0; i < 2; ++i) {
+        co_await engine.Sleep(1500);
+        wakes.push_back(engine.GetBackTest().GetCurrentTimestamp());
+    }
+}
+
+StrategyTask SendOrders(CoroutineEngine<>& engine, std::vector<uint64_t>& sends,
+                        uint64_t& rejected) {
+    auto& backtest = engine.GetBackTest();
+    // a sleep of another coroutine can't make the replay step over the call time
+    co_await SleepTwice(engine, sends);
+    sends.clear();
+    for (size_t i = 0; i < 5; ++i) {
+        co_await engine.CanCall();
+        rejected += !backtest.SendMarketOrder(i % 2 == 0 ? BID : ASK, 100).has_value();
+        sends.push_back(backtest.GetCurrentTimestamp());
+    }
+}
+
+StrategyTask CollectTrades(CoroutineEngine<>& engine, uint64_t& trades, uint64_t& late) {
+    while (true) {
+        auto transaction = co_await engine.NextTrade();
+        ++trades;
+        late += transaction.GetTransactionTimestamp() != engine.GetBackTest().GetCurrentTimestamp();
+    }
+}
+
+StrategyTask WaitFill(CoroutineEngine<>& engine, std::vector<std::optional<uint64_t>>& fills) {
+    auto& backtest = engine.GetBackTest();
+    for (const bool withdraw : {false, true}) {
+        co_await engine.CanCall();
+        // the withdrawn order is far from the market, so it can't be filled before the withdraw
+        uint64_t price = withdraw ? backtest.GetBestBid() / 2 : backtest.GetBestBid();
+        auto order_id = backtest.SendLimitOrder(BID, 100000, price).value();
+        if (withdraw) {
+            co_await engine.CanCall();
+            backtest.WithdrawLimitOrder(order_id);
+        }
+        auto fill = co_await engine.Fill(order_id);
+        fills.push_back(fill ? std::optional<uint64_t>(fill->GetTransactionTimestamp())
+                             : std::nullopt);
+        if (fill && fill->GetTransactionTimestamp() != backtest.GetCurrentTimestamp()) {
+            throw std::logic_error("A fill resumed the coroutine at another time.");
+        }
+    }
+}
+
+StrategyTask ThrowAfterSleep(CoroutineEngine<>& engine) {
+    co_await engine.Sleep(100);
+    throw std::runtime_error("strategy failure");
+}
+
+void TestCoroutines() {
+    try {
+        {
+            BackTest backtest(path_orderbook, path_transactions);
+            backtest.ProcessTimeInterval(initial_time);
+            CoroutineEngine<> engine(backtest);
+            std::vector<uint64_t> wakes, sends;
+            uint64_t rejected = 0, trades = 0, late = 0;
+            engine.Spawn(SleepTwice(engine, wakes));
+            engine.Spawn(SendOrders(engine, sends, rejected));
+            engine.Run(initial_time + 10000);
+            std::cerr << "Sends at";
+            for (const auto& timestamp : sends) {
+                std::cerr << " " << timestamp - initial_time;
+            }
+            std::cerr << std::endl;
+            if (wakes != std::vector<uint64_t>{initial_time + 1500, initial_time + 3000} ||
+                sends.size() != 5 || rejected != 0 || sends[0] != initial_time + 3000 ||
+                sends[1] != sends[0] + backtest.GetCallFrequency()) {
+                throw std::logic_error("Timers resumed the coroutines at wrong times.");
+            }
+
+            engine.Spawn(CollectTrades(engine, trades, late));
+            BackTest expected(path_orderbook, path_transactions);
+            expected.ProcessTimeInterval(initial_time + 10000);
+            CountingStrategy counting;
+            expected.ProcessTimeInterval(60000, counting);
+            engine.Run(initial_time + 70000);
+            std::cerr << "Coroutine saw " << trades << " trades" << std::endl;
+            if (trades != counting.trades || late != 0) {
+                throw std::logic_error("Incorrect trades of the coroutine.");
+            }
+        }
+        {
+            BackTest backtest(path_orderbook, path_transactions);
+            backtest.ProcessTimeInterval(initial_time);
+            CoroutineEngine<> engine(backtest);
+            std::vector<std::optional<uint64_t>> fills;
+            engine.Spawn(WaitFill(engine, fills));
+            engine.Run(initial_time + 600000);
+            if (fills.size() != 2 || !fills[0] || fills[1]) {
+                throw std::logic_error("Incorrect fill waits.");
+            }
+        }
+        {
+            BackTest backtest(path_orderbook, path_transactions);
+            backtest.ProcessTimeInterval(initial_time);
+            CoroutineEngine<> engine(backtest);
+            engine.Spawn(ThrowAfterSleep(engine));
+            bool has_thrown = false;
+            try {
+                engine.Run(initial_time + 1000);
+            } catch (const std::runtime_error&) {
+                has_thrown = true;
+            }
+            if (!has_thrown) {
+                throw std::logic_error("Exception of a coroutine was lost.");
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
+#endif
+
+// tests for feature export
+
+void TestFeatureExport() {
+    try {
+        Scanner scanner;
+        scanner.ReadAll(path_orderbook, path_transactions);
+        std::cerr << "Compare ReplayBook with the BackTest orderbook" << std::endl;
+        BackTest backtest(path_orderbook, path_transactions);
+        ReplayBook book;
+        std::vector<CompletedTransaction> completed;
+        size_t orders_position = 0, transactions_position = 0, total_completed = 0;
+        BookLevels ask, bid;
+        for (uint64_t timestamp = initial_time; timestamp < initial_time + 600000;
+             timestamp += 1000) {
+            backtest.ProcessTimeInterval(timestamp - backtest.GetCurrentTimestamp());
+            while (true) {
+                uint64_t orders_time =
+                    orders_position < scanner.GetAsk().size()
+                        ? scanner.GetAsk()[orders_position][0]->GetSubmitTimestamp()
+                        : -1;
+                uint64_t transactions_time =
+                    transactions_position < scanner.GetTransactions().size()
+                        ? scanner.GetTransactions()[transactions_position]
+                              .GetTransactionTimestamp()
+                        : -1;
+                if (std::min(orders_time, transactions_time) > timestamp) {
+                    break;
+                }
+                if (orders_time <= transactions_time) {
+                    book.UpdateOrderBook(scanner.GetAsk()[orders_position],
+                                         scanner.GetBid()[orders_position]);
+                    ++orders_position;
+                } else {
+                    completed.clear();
+                    book.CompleteMarketTransaction(
+                        scanner.GetTransactions()[transactions_position++], completed);
+                    total_completed += completed.size();
+                }
+            }
+            FillBookLevels(backtest.GetAsk(), -1, ask);
+            FillBookLevels(backtest.GetBid(), -1, bid);
+            if (ask.prices != book.GetAsk().prices || ask.volumes != book.GetAsk().volumes ||
+                bid.prices != book.GetBid().prices || bid.volumes != book.GetBid().volumes ||
+                total_completed != backtest.GetCompletedTrades().Size()) {
+                throw std::logic_error("ReplayBook differs from the BackTest orderbook.");
+            }
+        }
+
+        std::cerr << "Export features with 1 and 3 threads" << std::endl;
+        ExportConfig config;
+        config.start_timestamp = initial_time;
+        config.end_timestamp = initial_time + 600000;
+        config.shard_duration = 100000;
+        FeatureExporter exporter(scanner, config);
+        auto rows = exporter.Export("features_test_1.bin");
+        config.threads = 3;
+        if (FeatureExporter(scanner, config).Export("features_test_3.bin") != rows ||
+            rows != 600) {
+            throw std::logic_error("Incorrect number of exported rows.");
+        }
+        std::ifstream first("features_test_1.bin", std::ios::binary);
+        std::ifstream second("features_test_3.bin", std::ios::binary);
+        if (std::string(std::istreambuf_iterator<char>(first), {}) !=
+            std::string(std::istreambuf_iterator<char>(second), {})) {
+            throw std::logic_error("Export depends on the number of threads.");
+        }
+
+        std::cerr << "Export features with different shard durations" << std::endl;
+        // the row groups depend on the shards, so the columns are joined before the comparison
+        auto read_columns = [](const std::string& path) {
+            std::ifstream in(path, std::ios::binary);
+            auto read_number = [&in]() {
+                uint64_t value = 0;
+                in.read(reinterpret_cast<char*>(&value), sizeof(value));
+                return value;
+            };
+            std::string header(8, '\0');
+            in.read(header.data(), header.size());
+            uint64_t column_count = read_number();
+            for (uint64_t i = 0; i < column_count; ++i) {
+                std::string name(read_number(), '\0');
+                in.read(name.data(), name.size());
+                header += name;
+            }
+            std::vector<std::string> columns(column_count);
+            for (uint64_t rows = read_number(); in; rows = read_number()) {
+                for (auto& column : columns) {
+                    std::string values(rows * sizeof(double), '\0');
+                    in.read(values.data(), values.size());
+                    column += values;
+                }
+            }
+            columns.emplace_back(header);
+            return columns;
+        };
+        config.features.emplace_back(WINDOW_VWAP, 1000);
+        config.features.emplace_back(WINDOW_VWAP, 30000, TIME);
+        config.shard_duration = 7000;
+        FeatureExporter(scanner, config).Export("features_test_1.bin");
+        config.shard_duration = 100000;
+        FeatureExporter(scanner, config).Export("features_test_3.bin");
+        if (read_columns("features_test_1.bin") != read_columns("features_test_3.bin")) {
+            throw std::logic_error("Export depends on the shard duration.");
+        }
+        std::remove("features_test_1.bin");
+        std::remove("features_test_3.bin");
+    } catch (const std::exception& e) {
+        std::cerr << "Failed with an exception: " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cerr << std::endl;
+}
+
 int main() {
+    if (test_allocation_tracker) {
+        TestAllocationTracker();
+    }
+
     if (test_completed_transactions) {
         TestCompletedTransactions();
     }
 
+    if (test_book_kernels) {
+        TestBookKernels();
+    }
+
+    if (test_feature_store) {
+        TestFeatureStore();
+    }
+
+    if (test_tree_ensemble) {
+        TestTreeEnsemble();
+    }
+
     if (test_orders) {
         TestOrders();
     }
@@ -206,10 +2076,82 @@ int main() {
         TestScanner();
     }
 
+    if (test_prefetcher) {
+        TestPrefetcher();
+    }
+
+    if (test_compact_data) {
+        TestCompactData();
+    }
+
+    if (test_market_generator) {
+        TestMarketGenerator();
+    }
+
     if (test_backtest) {
         TestBackTest();
     }
 
+    if (test_strategy) {
+        TestStrategy();
+    }
+
+    if (test_execution_models) {
+        TestExecutionModels();
+    }
+
+    if (test_lazy_book) {
+        TestLazyBook();
+    }
+    if (test_trade_coalescing) {
+        TestTradeCoalescing();
+    }
+    if (test_level_updates) {
+        TestLevelUpdates();
+    }
+
+    if (test_depth_view) {
+        TestDepthView();
+    }
+
+    if (test_queue_position) {
+        TestQueuePosition();
+    }
+
+    if (test_active_orders) {
+        TestActiveOrders();
+    }
+
+    if (test_accounts) {
+        TestAccounts();
+    }
+
+    if (test_parameter_sweep) {
+        TestParameterSweep();
+    }
+
+    if (test_trade_history) {
+        TestTradeHistory();
+    }
+
+    if (test_results_sink) {
+        TestResultsSink();
+    }
+
+    if (test_event_log) {
+        TestEventLog();
+    }
+
+#ifdef BACKTEST_COROUTINES
+    if (test_coroutines) {
+        TestCoroutines();
+    }
+#endif
+
+    if (test_feature_export) {
+        TestFeatureExport();
+    }
+
     std::cerr << "All tests passed!" << std::endl;
     return EXIT_SUCCESS;
 }
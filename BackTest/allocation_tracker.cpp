@@ -0,0 +1,171 @@
+#include "allocation_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+
+// the counters are touched from inside operator new, so they are plain constant initialized
+// objects: nothing here may allocate
+std::atomic<uint64_t> allocation_counts[EVENT_TYPES_COUNT + 1][SUBSYSTEMS_COUNT];
+std::atomic<uint64_t> allocation_bytes[EVENT_TYPES_COUNT + 1][SUBSYSTEMS_COUNT];
+thread_local EventTypes current_event_type = EVENT_TYPES_COUNT;
+thread_local Subsystems current_subsystem = NO_SUBSYSTEM;
+thread_local uint64_t thread_allocations = 0;
+
+void RecordAllocation(const size_t& size) {
+    allocation_counts[current_event_type][current_subsystem].fetch_add(
+        1, std::memory_order_relaxed);
+    allocation_bytes[current_event_type][current_subsystem].fetch_add(
+        size, std::memory_order_relaxed);
+    ++thread_allocations;
+}
+
+#ifdef BACKTEST_ALLOCATION_TRACKING
+
+void* operator new(size_t size) {
+    RecordAllocation(size);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t /*size*/) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t /*size*/) noexcept {
+    std::free(pointer);
+}
+
+#endif
+
+// Subsystems
+
+std::string ToString(const Subsystems& subsystem) {
+    switch (subsystem) {
+        case NO_SUBSYSTEM:
+            return "untagged";
+        case SCANNER:
+            return "scanner";
+        case ORDERBOOK_UPDATE:
+            return "book update";
+        case MATCHING:
+            return "matching";
+        case USER_ORDERS:
+            return "user orders";
+        case FEATURES:
+            return "features";
+        case STRATEGY:
+            return "strategy";
+        case SUBSYSTEMS_COUNT:
+            break;
+    }
+    throw std::runtime_error("ToString - Incorrect subsystem.");
+}
+
+// AllocationCounters
+
+AllocationCounters::AllocationCounters() : allocations(0), bytes(0) {
+}
+
+void AllocationCounters::Add(const AllocationCounters& other) {
+    allocations += other.allocations;
+    bytes += other.bytes;
+}
+
+// AllocationScope
+
+AllocationScope::AllocationScope(const Subsystems& subsystem)
+    : AllocationScope(current_event_type, subsystem) {
+}
+
+AllocationScope::AllocationScope(const EventTypes& event_type, const Subsystems& subsystem)
+    : previous_event_type_(current_event_type), previous_subsystem_(current_subsystem) {
+    current_event_type = event_type;
+    current_subsystem = subsystem;
+}
+
+AllocationScope::~AllocationScope() {
+    current_event_type = previous_event_type_;
+    current_subsystem = previous_subsystem_;
+}
+
+// functions
+
+AllocationCounters GetAllocations(const EventTypes& event_type, const Subsystems& subsystem) {
+    AllocationCounters counters;
+    counters.allocations = allocation_counts[event_type][subsystem].load();
+    counters.bytes = allocation_bytes[event_type][subsystem].load();
+    return counters;
+}
+
+AllocationCounters GetAllocations(const EventTypes& event_type) {
+    AllocationCounters counters;
+    for (size_t subsystem = 0; subsystem < SUBSYSTEMS_COUNT; ++subsystem) {
+        counters.Add(GetAllocations(event_type, static_cast<Subsystems>(subsystem)));
+    }
+    return counters;
+}
+
+AllocationCounters GetAllocations(const Subsystems& subsystem) {
+    AllocationCounters counters;
+    for (size_t event_type = 0; event_type <= EVENT_TYPES_COUNT; ++event_type) {
+        counters.Add(GetAllocations(static_cast<EventTypes>(event_type), subsystem));
+    }
+    return counters;
+}
+
+uint64_t GetThreadAllocations() {
+    return thread_allocations;
+}
+
+void ResetAllocations() {
+    for (size_t event_type = 0; event_type <= EVENT_TYPES_COUNT; ++event_type) {
+        for (size_t subsystem = 0; subsystem < SUBSYSTEMS_COUNT; ++subsystem) {
+            allocation_counts[event_type][subsystem] = 0;
+            allocation_bytes[event_type][subsystem] = 0;
+        }
+    }
+}
+
+void PrintAllocations(bool print_name) {
+    if (print_name) {
+        std::cerr << "Allocations:" << std::endl;
+    }
+    if (!IsAllocationTrackingEnabled()) {
+        std::cerr << "allocation tracking is compiled out, configure with "
+                     "-DBACKTEST_ALLOCATION_TRACKING=ON"
+                  << std::endl;
+        return;
+    }
+    auto print = [](const std::string& name, const AllocationCounters& counters) {
+        std::cerr << "  " << name << ": " << counters.allocations << " allocations, "
+                  << counters.bytes << " bytes" << std::endl;
+    };
+    std::cerr << "per event type:" << std::endl;
+    for (size_t event_type = 0; event_type <= EVENT_TYPES_COUNT; ++event_type) {
+        auto type = static_cast<EventTypes>(event_type);
+        print(type == EVENT_TYPES_COUNT ? "outside of events" : ToString(type),
+              GetAllocations(type));
+    }
+    std::cerr << "per subsystem:" << std::endl;
+    for (size_t subsystem = 0; subsystem < SUBSYSTEMS_COUNT; ++subsystem) {
+        auto tag = static_cast<Subsystems>(subsystem);
+        print(ToString(tag), GetAllocations(tag));
+    }
+}
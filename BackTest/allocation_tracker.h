@@ -0,0 +1,71 @@
+#pragma once
+
+#include "instrumentation.h"
+
+#include <cstdint>
+#include <string>
+
+// With -DBACKTEST_ALLOCATION_TRACKING=ON the global operator new and delete are replaced and
+// every allocation is counted under the event and the subsystem of the innermost
+// BACKTEST_ALLOCATION_SCOPE of its thread. Without the option the scopes are removed by the
+// preprocessor and the default allocator is used.
+#ifdef BACKTEST_ALLOCATION_TRACKING
+#define BACKTEST_ALLOCATION_SCOPE_NAME(line) allocation_scope_##line
+#define BACKTEST_ALLOCATION_SCOPE_LINE(line, ...) \
+    AllocationScope BACKTEST_ALLOCATION_SCOPE_NAME(line)(__VA_ARGS__)
+#define BACKTEST_ALLOCATION_SCOPE(...) BACKTEST_ALLOCATION_SCOPE_LINE(__LINE__, __VA_ARGS__)
+#else
+#define BACKTEST_ALLOCATION_SCOPE(...)
+#endif
+
+constexpr bool IsAllocationTrackingEnabled() {
+#ifdef BACKTEST_ALLOCATION_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+enum Subsystems {
+    NO_SUBSYSTEM,
+    SCANNER,
+    ORDERBOOK_UPDATE,
+    MATCHING,
+    USER_ORDERS,
+    FEATURES,
+    // everything inside an event which isn't done by the other subsystems
+    STRATEGY,
+    SUBSYSTEMS_COUNT
+};
+
+std::string ToString(const Subsystems& subsystem);
+
+struct AllocationCounters {
+    uint64_t allocations;
+    uint64_t bytes;
+    AllocationCounters();
+    void Add(const AllocationCounters& other);
+};
+
+// sets the tags of the allocations of the current thread until the end of the scope
+class AllocationScope {
+public:
+    explicit AllocationScope(const Subsystems& subsystem);
+    AllocationScope(const EventTypes& event_type, const Subsystems& subsystem);
+    ~AllocationScope();
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+private:
+    EventTypes previous_event_type_;
+    Subsystems previous_subsystem_;
+};
+
+// all threads, EVENT_TYPES_COUNT is for the allocations outside of the events
+AllocationCounters GetAllocations(const EventTypes& event_type, const Subsystems& subsystem);
+AllocationCounters GetAllocations(const EventTypes& event_type);
+AllocationCounters GetAllocations(const Subsystems& subsystem);
+// number of allocations made by the current thread, never reset
+uint64_t GetThreadAllocations();
+void ResetAllocations();
+void PrintAllocations(bool print_name = true);
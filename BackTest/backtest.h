@@ -1,11 +1,24 @@
 #pragma once
 
+#include "allocation_tracker.h"
+#include "book_overlay.h"
+#include "event_log.h"
+#include "execution_models.h"
+#include "feature_store.h"
+#include "instrumentation.h"
+#include "order_tracker.h"
 #include "orderbook.h"
+#include "prefetcher.h"
+#include "results_sink.h"
 #include "scanner.h"
 
+#include <algorithm>
+#include <memory>
 #include <optional>
 #include <queue>
+#include <stdexcept>
 #include <utility>
+#include <vector>
 
 struct ForRemove {
     uint64_t remove_timestamp;
@@ -23,66 +36,943 @@ struct ForPNL {
     void Print(bool print_name = true) const;
 };
 
-class BackTest {
+// The orders, the requests in flight and the PnL of one strategy. Every account has its own
+// connection and call frequency budget, an isolated account also has its own overlay of the
+// historical orderbook.
+struct Account {
+    uint64_t last_call;
+    uint64_t last_arrival;
+    std::queue<LimitOrder> queue_limit_orders;
+    std::queue<MarketOrder> queue_market_orders;
+    std::queue<ForRemove> queue_remove_orders;
+    OrderTracker order_tracker;
+    // the fills are settled as they happen, so the fees can depend on their order
+    int64_t total_cash;
+    int64_t total_asset;
+    // nullptr if the account trades in the shared orderbook
+    std::unique_ptr<BookOverlay> overlay;
+    explicit Account(std::unique_ptr<BookOverlay> overlay = nullptr);
+};
+
+// Default hooks for strategies driven by BasicBackTest::Run. A strategy derives from it and hides
+// only the hooks it needs: all calls are resolved at compile time, so unused hooks cost nothing.
+class BaseStrategy {
 public:
-    BackTest() = default;
+    // a new orderbook snapshot was applied
+    template <typename TBackTest>
+    void OnBookUpdate(TBackTest& /*backtest*/) {
+    }
+    // a historical level update was applied, see BasicBackTest::SetLevelUpdates
+    template <typename TBackTest>
+    void OnLevelUpdate(TBackTest& /*backtest*/, const LevelUpdate& /*update*/) {
+    }
+    // a historical market transaction was matched against the orderbook
+    template <typename TBackTest>
+    void OnTrade(TBackTest& /*backtest*/, const CompletedTransaction& /*transaction*/) {
+    }
+    // a user order received a fill
+    template <typename TBackTest>
+    void OnFill(TBackTest& /*backtest*/, const BaseOrder& /*order*/,
+                const CompletedTransaction& /*transaction*/) {
+    }
+    // a user limit order was placed into the orderbook or a market order was executed
+    template <typename TBackTest>
+    void OnOrderAck(TBackTest& /*backtest*/, const uint64_t& /*order_id*/) {
+    }
+    // a withdraw request reached the orderbook
+    template <typename TBackTest>
+    void OnCancelAck(TBackTest& /*backtest*/, const uint64_t& /*order_id*/) {
+    }
+    // called by BasicBackTest::Run every timer_step ms
+    template <typename TBackTest>
+    void OnTimer(TBackTest& /*backtest*/) {
+    }
+};
+
+// The replay engine. TLatency and TFee are the latency and fee models from execution_models.h,
+// the calls to them are resolved at compile time. One replay can host several strategy accounts:
+// the calls which place orders or read the PnL take the account, 0 by default, and the calls
+// which take an order id find its account. The accounts in the shared orderbook stand in the same
+// queues and take the market volume from each other. The isolated accounts share one more book
+// of the historical orders only and each of them keeps its orders and the volumes they change in
+// an overlay of it, so the orders of an isolated account don't change the fills of the others.
+template <typename TLatency = ConstantLatency, typename TFee = MakerTakerFee>
+class BasicBackTest {
+public:
+    BasicBackTest() = default;
     // time in ms
-    // comission is price * value * comission / 10^4
-    BackTest(const std::string& path_orderbook, const std::string& path_transactions,
-             uint64_t limit_order_fee = 0, uint64_t market_order_fee = 0,
-             uint64_t post_latency = 100, uint64_t cancel_latency = 100,
-             uint64_t call_frequency = 100);
+    // comission is price * value * comission / 10^4, limit orders pay limit_order_fee and
+    // market orders pay market_order_fee
+    BasicBackTest(const std::string& path_orderbook, const std::string& path_transactions,
+                  uint64_t limit_order_fee = 0, uint64_t market_order_fee = 0,
+                  uint64_t post_latency = 100, uint64_t cancel_latency = 100,
+                  uint64_t call_frequency = 100);
+    BasicBackTest(const std::string& path_orderbook, const std::string& path_transactions,
+                  const TLatency& latency, const TFee& fee, uint64_t call_frequency = 100);
 
     uint64_t ProcessTimeInterval(const uint64_t& step);
-    uint64_t ProcessBeforeUnlock();
+    template <typename TStrategy>
+    uint64_t ProcessTimeInterval(const uint64_t& step, TStrategy& strategy);
+    // replays the market until end_timestamp, calling strategy.OnTimer every timer_step ms
+    template <typename TStrategy>
+    uint64_t Run(TStrategy& strategy, const uint64_t& end_timestamp, const uint64_t& timer_step);
+    // returns the index of the new account, account 0 always exists. Has to be called before the
+    // replay. The first isolated account adds one more orderbook update per historical event,
+    // every isolated account adds only a walk of the levels its orders change
+    size_t AddAccount(const bool& is_isolated = false);
+    size_t GetAccountsCount() const;
+    // the account which sent the order
+    size_t GetOrderAccount(const uint64_t& order_id) const;
+    uint64_t ProcessBeforeUnlock(const size_t& account = 0);
     TBase GetOrderInfo(const uint64_t& order_id) const;
+    // the order ids are unique over all accounts
     std::optional<uint64_t> SendLimitOrder(const OrderTypes& order_type, const uint64_t& volume,
-                                           const uint64_t& price_limit);
+                                           const uint64_t& price_limit,
+                                           const size_t& account = 0);
+    // uses the call frequency budget of the account of the order
     bool WithdrawLimitOrder(uint64_t order_id);
-    std::optional<uint64_t> SendMarketOrder(const OrderTypes& order_type, const uint64_t& volume);
+    std::optional<uint64_t> SendMarketOrder(const OrderTypes& order_type, const uint64_t& volume,
+                                            const size_t& account = 0);
     uint64_t GetCurrentTimestamp() const;
+    // replays the file of level updates read by Scanner::ReadLevelUpdates together with the
+    // snapshots, has to be called before the replay. Each update changes one level of the books
+    // of all accounts in O(log n) and calls OnLevelUpdate, a snapshot still replaces the whole
+    // book, so sparse snapshots resynchronize a book kept by the updates. At one time the
+    // snapshot goes first, then the updates, the transactions and the user requests
+    void SetLevelUpdates(const std::string& path_level_updates);
+    // the time of the next historical event or user request, -1 if there are none
+    uint64_t GetNextEventTimestamp();
+    // the shared orderbook, it holds the orders of the accounts which aren't isolated
     const TAskLimitSet& GetAsk() const;
     const TBidLimitSet& GetBid() const;
     const TLimitVector& GetUserLimitAsk() const;
     const TLimitVector& GetUserLimitBid() const;
     const TMarketVector& GetUserMarketAsk() const;
     const TMarketVector& GetUserMarketBid() const;
-    const TTransactionVector& GetCompletedTrades() const;
+    // the user orders which are pending, open, partially filled or pending cancel, by order id
+    const TActiveOrders& GetActiveOrders(const size_t& account = 0) const;
+    // nullptr once the order is filled or canceled
+    const ActiveOrder* FindActiveOrder(const uint64_t& order_id) const;
+    // the acks, fills, cancels and closes of the user orders during the last ProcessTimeInterval,
+    // a ProcessBeforeUnlock which doesn't have to wait keeps them
+    const TOrderChanges& GetOrderChanges(const size_t& account = 0) const;
+    // the transactions of the shared orderbook
+    const TradeHistory& GetCompletedTrades() const;
+    // has to be called before the replay, by default every transaction is kept in memory
+    void SetTradeRetention(const RetentionConfig& config);
+    void FlushTradeLog();
+    // while the user has no resting limit orders and there are no level updates the orderbook
+    // sets are built only when they are read, on by default, the results are the same
+    void SetLazyBook(bool is_lazy);
+    // replays consecutive transactions with equal timestamp, price and aggressor side as one
+    // market trade, off by default. The user orders get the same fills as without it, one per
+    // print, but OnTrade, the fills of the historical orders in GetCompletedTrades and the count
+    // windows of the features see the merged transactions. Has to be called before the replay
+    void SetTradeCoalescing(bool is_coalescing);
+    // number of rows of the transactions file replayed so far and number of them merged away
+    uint64_t GetTransactionRows() const;
+    uint64_t GetCoalescedTransactions() const;
+    // records the order events, the fills and the PnL of account 0 after every
+    // ProcessTimeInterval into the sink, which has to outlive the replay; nullptr stops the
+    // recording
+    void SetResultsSink(ResultsSink* results_sink);
+    // rolling features over GetCompletedTrades(), windows have to be registered before the replay
+    FeatureStore& GetFeatureStore();
+    const FeatureStore& GetFeatureStore() const;
+    // copies both sets, GetDepth and GetQuote read the book without copying
     std::pair<TAskLimitSet, TBidLimitSet> GetOrderBook() const;
+    // the levels aggregated by price, the references and the view are valid until the next call
+    // which changes the book or reads more levels. GetQuote builds only the best level of each
+    // side and GetDepth only the first depth levels
+    const BookLevels& GetAskLevels() const;
+    const BookLevels& GetBidLevels() const;
+    DepthView GetDepth(const size_t& depth = -1) const;
+    const Quote& GetQuote() const;
+    // both are O(log n), -1 if the order isn't in the orderbook of its account
     uint64_t GetOrderPosition(const uint64_t& order_id) const;
-    ForPNL GetPNL() const;
+    uint64_t GetVolumeAhead(const uint64_t& order_id) const;
+    ForPNL GetPNL(const size_t& account = 0) const;
+    // the price of the first order of the side even if it is filled, throws on an empty side
     uint64_t GetBestBid() const;
     uint64_t GetBestAsk() const;
-    uint64_t GetLimitOrderFee() const;
-    uint64_t GetMarketOrderFee() const;
+    const TLatency& GetLatencyModel() const;
+    const TFee& GetFeeModel() const;
+    // every order, or withdraw, sent before is in the orderbook after these times
     uint64_t GetPostLatency() const;
     uint64_t GetCancelLatency() const;
     uint64_t GetCallFrequency() const;
-    uint64_t GetLastCall() const;
+    uint64_t GetLastCall(const size_t& account = 0) const;
     uint64_t GetTotalMarketCash() const;
     uint64_t GetTotalMarketAsset() const;
     void PrintOrderBook(bool print_name = true) const;
+    // event counters and stage timers, empty unless built with BACKTEST_INSTRUMENTATION
+    EngineStats GetStats() const;
 
 private:
-    bool ProcessQueue();
-
-    template <typename TSet, typename TValue>
-    uint64_t GetOrder(const TSet& orders, const TValue& order) const;
+    template <typename TStrategy>
+    bool ProcessQueue(TStrategy& strategy);
+    // the limit order, market order or withdraw of the account which is due at timestamp
+    template <typename TStrategy>
+    void ProcessRequest(TStrategy& strategy, Account& account, const uint64_t& timestamp);
+    // orderbook is the shared orderbook or the overlay of an isolated account
+    template <typename TStrategy, typename TOrderBook>
+    void ProcessRequest(TStrategy& strategy, Account& account, TOrderBook& orderbook,
+                        const uint64_t& timestamp);
+    template <typename TStrategy>
+    void NotifyUserFills(TStrategy& strategy, const TUserFillVector& fills);
+    Account& GetAccount(const size_t& account);
+    const Account& GetAccount(const size_t& account) const;
+    // the time of the first request of the account in flight, -1 if there are none
+    static uint64_t GetRequestTimestamp(const Account& account);
+    // the historical orderbook can't share the order objects with the shared one, the trades
+    // change them
+    static TLimitVector CopyOrders(const TLimitVector& orders);
+    uint64_t GetArrival(Account& account, const uint64_t& latency);
+    void SettleUserFills(const TUserFillVector& fills, const Liquidity& liquidity);
+    void UpdateFeatureStore();
+    void RecordOrder(const uint64_t& timestamp, const uint64_t& order_id,
+                     const OrderEvents& order_event, const BaseOrder* order = nullptr);
+    void RecordPNL();
 
-    uint64_t limit_order_fee_;
-    uint64_t market_order_fee_;
-    uint64_t post_latency_;
-    uint64_t cancel_latency_;
+    TLatency latency_;
+    TFee fee_;
     uint64_t call_frequency_;
     OrderBook orderbook_;
+    // the historical orders without user orders under the overlays of the isolated accounts,
+    // nullptr without isolated accounts
+    std::unique_ptr<OrderBook> historical_orderbook_;
+    std::vector<Account> accounts_;
+    // the account of every order id
+    std::vector<size_t> order_accounts_;
+    bool is_lazy_book_;
     uint64_t current_timestamp_;
-    uint64_t last_call_;
-    std::vector<TLimitVector> historical_ask_, historical_bid_;
-    std::vector<CompletedTransaction> historical_transactions_;
-    std::queue<LimitOrder> queue_limit_orders_;
-    std::queue<MarketOrder> queue_market_orders_;
-    std::queue<ForRemove> queue_remove_orders_;
-    uint64_t orders_position_;
-    uint64_t transactions_position_;
+    // the historical data is parsed in the background while the replay goes on
+    std::unique_ptr<Prefetcher> historical_data_;
+    FeatureStore feature_store_;
+    uint64_t feature_store_position_;
+    EngineStats stats_;
+    ResultsSink* results_sink_;
     static const uint64_t percent_base_ = 10000;
-};
\ No newline at end of file
+};
+
+using BackTest = BasicBackTest<>;
+
+extern template class BasicBackTest<ConstantLatency, MakerTakerFee>;
+
+// BasicBackTest
+
+template <typename TLatency, typename TFee>
+BasicBackTest<TLatency, TFee>::BasicBackTest(const std::string& path_orderbook,
+                                             const std::string& path_transactions,
+                                             uint64_t limit_order_fee, uint64_t market_order_fee,
+                                             uint64_t post_latency, uint64_t cancel_latency,
+                                             uint64_t call_frequency)
+    : BasicBackTest(path_orderbook, path_transactions, TLatency(post_latency, cancel_latency),
+                    TFee(limit_order_fee, market_order_fee), call_frequency) {
+}
+
+template <typename TLatency, typename TFee>
+BasicBackTest<TLatency, TFee>::BasicBackTest(const std::string& path_orderbook,
+                                             const std::string& path_transactions,
+                                             const TLatency& latency, const TFee& fee,
+                                             uint64_t call_frequency)
+    : latency_(latency),
+      fee_(fee),
+      call_frequency_(call_frequency),
+      orderbook_(),
+      historical_orderbook_(),
+      accounts_(1),
+      order_accounts_(),
+      is_lazy_book_(true),
+      current_timestamp_(0),
+      historical_data_(std::make_unique<Prefetcher>(path_orderbook, path_transactions)),
+      feature_store_(),
+      feature_store_position_(0),
+      stats_(),
+      results_sink_(nullptr) {
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::ProcessTimeInterval(const uint64_t& step) {
+    BaseStrategy no_strategy;
+    return ProcessTimeInterval(step, no_strategy);
+}
+
+template <typename TLatency, typename TFee>
+size_t BasicBackTest<TLatency, TFee>::AddAccount(const bool& is_isolated) {
+    if (current_timestamp_ != 0) {
+        throw std::runtime_error("BackTest::AddAccount - Accounts have to be added before replay.");
+    }
+    std::unique_ptr<BookOverlay> overlay;
+    if (is_isolated) {
+        if (!historical_orderbook_) {
+            historical_orderbook_ = std::make_unique<OrderBook>();
+            historical_orderbook_->SetLazyMode(is_lazy_book_);
+            // only the shared orderbook feeds GetCompletedTrades and the features
+            historical_orderbook_->SetTradeRetention({1, static_cast<uint64_t>(-1), ""});
+        }
+        overlay = std::make_unique<BookOverlay>(*historical_orderbook_);
+    }
+    accounts_.emplace_back(std::move(overlay));
+    return accounts_.size() - 1;
+}
+
+template <typename TLatency, typename TFee>
+size_t BasicBackTest<TLatency, TFee>::GetAccountsCount() const {
+    return accounts_.size();
+}
+
+template <typename TLatency, typename TFee>
+size_t BasicBackTest<TLatency, TFee>::GetOrderAccount(const uint64_t& order_id) const {
+    if (order_id >= order_accounts_.size()) {
+        throw std::runtime_error("BackTest::GetOrderAccount - Incorrect order_id.");
+    }
+    return order_accounts_[order_id];
+}
+
+template <typename TLatency, typename TFee>
+Account& BasicBackTest<TLatency, TFee>::GetAccount(const size_t& account) {
+    if (account >= accounts_.size()) {
+        throw std::runtime_error("BackTest::GetAccount - Incorrect account.");
+    }
+    return accounts_[account];
+}
+
+template <typename TLatency, typename TFee>
+const Account& BasicBackTest<TLatency, TFee>::GetAccount(const size_t& account) const {
+    if (account >= accounts_.size()) {
+        throw std::runtime_error("BackTest::GetAccount - Incorrect account.");
+    }
+    return accounts_[account];
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::ProcessBeforeUnlock(const size_t& account) {
+    uint64_t last_call = GetAccount(account).last_call;
+    if (last_call + call_frequency_ <= current_timestamp_) {
+        return current_timestamp_;
+    } else {
+        return ProcessTimeInterval(last_call + call_frequency_ - current_timestamp_);
+    }
+}
+
+template <typename TLatency, typename TFee>
+TBase BasicBackTest<TLatency, TFee>::GetOrderInfo(const uint64_t& order_id) const {
+    const auto& account = accounts_[GetOrderAccount(order_id)];
+    return account.overlay ? account.overlay->GetOrderInfo(order_id)
+                           : orderbook_.GetOrderInfo(order_id);
+}
+
+template <typename TLatency, typename TFee>
+std::optional<uint64_t> BasicBackTest<TLatency, TFee>::SendLimitOrder(
+    const OrderTypes& order_type, const uint64_t& volume, const uint64_t& price_limit,
+    const size_t& account) {
+    auto& current_account = GetAccount(account);
+    if (current_account.last_call + call_frequency_ > current_timestamp_) {
+        return std::nullopt;
+    }
+    current_account.last_call = current_timestamp_;
+    uint64_t order_id = orderbook_.AddNewOrder();
+    if (current_account.overlay) {
+        current_account.overlay->ReserveOrderId(order_id);
+    }
+    order_accounts_.emplace_back(account);
+    current_account.queue_limit_orders.push(LimitOrder(
+        order_id, GetArrival(current_account, latency_.GetLimitOrderLatency(order_type)),
+        order_type, volume, price_limit));
+    current_account.order_tracker.AddOrder(order_id, order_type, volume, price_limit, false);
+    RecordOrder(current_timestamp_, order_id, ORDER_SUBMIT,
+                &current_account.queue_limit_orders.back());
+    return order_id;
+}
+
+template <typename TLatency, typename TFee>
+bool BasicBackTest<TLatency, TFee>::WithdrawLimitOrder(uint64_t order_id) {
+    auto& account = accounts_[GetOrderAccount(order_id)];
+    if (account.last_call + call_frequency_ > current_timestamp_) {
+        return false;
+    }
+    account.last_call = current_timestamp_;
+    account.queue_remove_orders.push(
+        ForRemove(GetArrival(account, latency_.GetCancelLatency()), order_id));
+    account.order_tracker.RequestCancel(order_id);
+    RecordOrder(current_timestamp_, order_id, CANCEL_REQUEST);
+    return true;
+}
+
+template <typename TLatency, typename TFee>
+std::optional<uint64_t> BasicBackTest<TLatency, TFee>::SendMarketOrder(
+    const OrderTypes& order_type, const uint64_t& volume, const size_t& account) {
+    auto& current_account = GetAccount(account);
+    if (current_account.last_call + call_frequency_ > current_timestamp_) {
+        return std::nullopt;
+    }
+    current_account.last_call = current_timestamp_;
+    uint64_t order_id = orderbook_.AddNewOrder();
+    if (current_account.overlay) {
+        current_account.overlay->ReserveOrderId(order_id);
+    }
+    order_accounts_.emplace_back(account);
+    current_account.queue_market_orders.push(MarketOrder(
+        order_id, GetArrival(current_account, latency_.GetMarketOrderLatency(order_type)),
+        order_type, volume));
+    current_account.order_tracker.AddOrder(order_id, order_type, volume, 0, true);
+    RecordOrder(current_timestamp_, order_id, ORDER_SUBMIT,
+                &current_account.queue_market_orders.back());
+    return order_id;
+}
+
+// the requests of an account reach the orderbook in the order they were sent, as over one
+// connection, so a withdraw never overtakes its order even if the latency model would allow it
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetArrival(Account& account, const uint64_t& latency) {
+    account.last_arrival = std::max(account.last_arrival, current_timestamp_ + latency);
+    return account.last_arrival;
+}
+
+template <typename TLatency, typename TFee>
+const TAskLimitSet& BasicBackTest<TLatency, TFee>::GetAsk() const {
+    return orderbook_.GetAsk();
+}
+
+template <typename TLatency, typename TFee>
+const TBidLimitSet& BasicBackTest<TLatency, TFee>::GetBid() const {
+    return orderbook_.GetBid();
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetCurrentTimestamp() const {
+    return current_timestamp_;
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetNextEventTimestamp() {
+    uint64_t timestamp = -1;
+    if (historical_data_->HasSnapshot()) {
+        timestamp = std::min(timestamp, historical_data_->GetSnapshotTimestamp());
+    }
+    if (historical_data_->HasLevelUpdate()) {
+        timestamp = std::min(timestamp, historical_data_->GetLevelUpdate().timestamp);
+    }
+    if (historical_data_->HasTransaction()) {
+        timestamp = std::min(timestamp,
+                             historical_data_->GetTransaction().GetTransactionTimestamp());
+    }
+    for (const auto& account : accounts_) {
+        timestamp = std::min(timestamp, GetRequestTimestamp(account));
+    }
+    return timestamp;
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetRequestTimestamp(const Account& account) {
+    uint64_t limit = !account.queue_limit_orders.empty()
+                         ? account.queue_limit_orders.front().GetSubmitTimestamp()
+                         : -1;
+    uint64_t market = !account.queue_market_orders.empty()
+                          ? account.queue_market_orders.front().GetSubmitTimestamp()
+                          : -1;
+    uint64_t remove = !account.queue_remove_orders.empty()
+                          ? account.queue_remove_orders.front().remove_timestamp
+                          : -1;
+    return std::min({limit, market, remove});
+}
+
+template <typename TLatency, typename TFee>
+TLimitVector BasicBackTest<TLatency, TFee>::CopyOrders(const TLimitVector& orders) {
+    TLimitVector copy;
+    copy.reserve(orders.size());
+    for (const auto& order : orders) {
+        copy.emplace_back(std::make_shared<LimitOrder>(
+            order->GetOrderId(), order->GetSubmitTimestamp(), order->GetOrderType(),
+            order->GetVolume(), order->GetPriceLimit()));
+    }
+    return copy;
+}
+
+template <typename TLatency, typename TFee>
+const TLimitVector& BasicBackTest<TLatency, TFee>::GetUserLimitAsk() const {
+    return orderbook_.GetUserLimitAsk();
+}
+
+template <typename TLatency, typename TFee>
+const TLimitVector& BasicBackTest<TLatency, TFee>::GetUserLimitBid() const {
+    return orderbook_.GetUserLimitBid();
+}
+
+template <typename TLatency, typename TFee>
+const TMarketVector& BasicBackTest<TLatency, TFee>::GetUserMarketAsk() const {
+    return orderbook_.GetUserMarketAsk();
+}
+
+template <typename TLatency, typename TFee>
+const TMarketVector& BasicBackTest<TLatency, TFee>::GetUserMarketBid() const {
+    return orderbook_.GetUserMarketBid();
+}
+
+template <typename TLatency, typename TFee>
+const TActiveOrders& BasicBackTest<TLatency, TFee>::GetActiveOrders(
+    const size_t& account) const {
+    return GetAccount(account).order_tracker.GetActiveOrders();
+}
+
+template <typename TLatency, typename TFee>
+const ActiveOrder* BasicBackTest<TLatency, TFee>::FindActiveOrder(
+    const uint64_t& order_id) const {
+    return accounts_[GetOrderAccount(order_id)].order_tracker.FindActiveOrder(order_id);
+}
+
+template <typename TLatency, typename TFee>
+const TOrderChanges& BasicBackTest<TLatency, TFee>::GetOrderChanges(
+    const size_t& account) const {
+    return GetAccount(account).order_tracker.GetChanges();
+}
+
+template <typename TLatency, typename TFee>
+const TradeHistory& BasicBackTest<TLatency, TFee>::GetCompletedTrades() const {
+    return orderbook_.GetMarketTransactions();
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::SetTradeRetention(const RetentionConfig& config) {
+    orderbook_.SetTradeRetention(config);
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::FlushTradeLog() {
+    orderbook_.FlushTradeLog();
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::SetLazyBook(bool is_lazy) {
+    is_lazy_book_ = is_lazy;
+    orderbook_.SetLazyMode(is_lazy);
+    if (historical_orderbook_) {
+        historical_orderbook_->SetLazyMode(is_lazy);
+    }
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::SetLevelUpdates(const std::string& path_level_updates) {
+    if (current_timestamp_ != 0) {
+        throw std::runtime_error(
+            "BackTest::SetLevelUpdates - Level updates have to be set before replay.");
+    }
+    historical_data_->OpenLevelUpdates(path_level_updates);
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::SetTradeCoalescing(bool is_coalescing) {
+    historical_data_->SetTradeCoalescing(is_coalescing);
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetTransactionRows() const {
+    return historical_data_->GetTransactionRows();
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetCoalescedTransactions() const {
+    return historical_data_->GetCoalescedTransactions();
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::SetResultsSink(ResultsSink* results_sink) {
+    results_sink_ = results_sink;
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::RecordOrder(const uint64_t& timestamp,
+                                                const uint64_t& order_id,
+                                                const OrderEvents& order_event,
+                                                const BaseOrder* order) {
+    if (!results_sink_ && !IsEventLogOpen()) {
+        return;
+    }
+    OrderRecord record{timestamp, order_id, order_event, ASK, 0, 0};
+    if (order) {
+        record.order_type = order->GetOrderType();
+        record.volume = order->GetVolume();
+        if (auto limit_order = dynamic_cast<const LimitOrder*>(order)) {
+            record.price_limit = limit_order->GetPriceLimit();
+        }
+    }
+    if (results_sink_) {
+        results_sink_->AddOrder(record);
+    }
+    static_assert(LOG_CANCEL_ACK - LOG_ORDER_SUBMIT == CANCEL_ACK - ORDER_SUBMIT);
+    auto log_event = static_cast<LogEvents>(LOG_ORDER_SUBMIT + static_cast<int>(order_event));
+    BACKTEST_LOG(log_event, timestamp, order_id, record.order_type, record.volume,
+                 record.price_limit);
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::RecordPNL() {
+    if (!results_sink_) {
+        return;
+    }
+    auto pnl = GetPNL();
+    results_sink_->AddPnl({pnl.timestamp, pnl.total_cash, pnl.total_asset,
+                           orderbook_.GetBid().empty() ? 0 : GetBestBid(),
+                           orderbook_.GetAsk().empty() ? 0 : GetBestAsk()});
+}
+
+template <typename TLatency, typename TFee>
+FeatureStore& BasicBackTest<TLatency, TFee>::GetFeatureStore() {
+    return feature_store_;
+}
+
+template <typename TLatency, typename TFee>
+const FeatureStore& BasicBackTest<TLatency, TFee>::GetFeatureStore() const {
+    return feature_store_;
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::UpdateFeatureStore() {
+    BACKTEST_ALLOCATION_SCOPE(FEATURES);
+    const auto& transactions = orderbook_.GetMarketTransactions();
+    // with a short retention a large event can drop transactions before they are read
+    feature_store_position_ = std::max(feature_store_position_, transactions.GetFirstIndex());
+    for (; feature_store_position_ < transactions.GetTotalCount(); ++feature_store_position_) {
+        feature_store_.AddTransaction(*transactions.Get(feature_store_position_));
+    }
+}
+
+template <typename TLatency, typename TFee>
+std::pair<TAskLimitSet, TBidLimitSet> BasicBackTest<TLatency, TFee>::GetOrderBook() const {
+    return {orderbook_.GetAsk(), orderbook_.GetBid()};
+}
+
+template <typename TLatency, typename TFee>
+const BookLevels& BasicBackTest<TLatency, TFee>::GetAskLevels() const {
+    return orderbook_.GetAskLevels();
+}
+
+template <typename TLatency, typename TFee>
+const BookLevels& BasicBackTest<TLatency, TFee>::GetBidLevels() const {
+    return orderbook_.GetBidLevels();
+}
+
+template <typename TLatency, typename TFee>
+DepthView BasicBackTest<TLatency, TFee>::GetDepth(const size_t& depth) const {
+    return orderbook_.GetDepth(depth);
+}
+
+template <typename TLatency, typename TFee>
+const Quote& BasicBackTest<TLatency, TFee>::GetQuote() const {
+    return orderbook_.GetQuote();
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetOrderPosition(const uint64_t& order_id) const {
+    const auto& account = accounts_[GetOrderAccount(order_id)];
+    return account.overlay ? account.overlay->GetOrderPosition(order_id)
+                           : orderbook_.GetOrderPosition(order_id);
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetVolumeAhead(const uint64_t& order_id) const {
+    const auto& account = accounts_[GetOrderAccount(order_id)];
+    return account.overlay ? account.overlay->GetVolumeAhead(order_id)
+                           : orderbook_.GetVolumeAhead(order_id);
+}
+
+template <typename TLatency, typename TFee>
+ForPNL BasicBackTest<TLatency, TFee>::GetPNL(const size_t& account) const {
+    const auto& current_account = GetAccount(account);
+    return ForPNL(current_account.total_cash, current_account.total_asset,
+                  GetCurrentTimestamp());
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::SettleUserFills(const TUserFillVector& fills,
+                                                    const Liquidity& liquidity) {
+    for (const auto& fill : fills) {
+        const auto& transaction = *fill.transaction;
+        auto& account = accounts_[order_accounts_[fill.order->GetOrderId()]];
+        account.order_tracker.Fill(fill.order->GetOrderId(), transaction);
+        uint64_t fee = fee_.GetFee(liquidity, *fill.order, transaction);
+        uint64_t cash = transaction.GetPrice() * transaction.GetVolume();
+        // the fee is always paid: a seller receives less and a buyer pays more
+        if (fill.order->GetOrderType() == ASK) {
+            account.total_cash += cash * (percent_base_ - fee) / percent_base_;
+            account.total_asset -= transaction.GetVolume();
+        } else {
+            account.total_cash -= cash * (percent_base_ + fee) / percent_base_;
+            account.total_asset += transaction.GetVolume();
+        }
+        if (results_sink_) {
+            results_sink_->AddFill({transaction.GetTransactionTimestamp(),
+                                    fill.order->GetOrderId(), fill.order->GetOrderType(),
+                                    transaction.GetVolume(), transaction.GetPrice(),
+                                    transaction.GetIsBuyerMaker()});
+        }
+        BACKTEST_LOG(LOG_FILL, transaction.GetTransactionTimestamp(), fill.order->GetOrderId(),
+                     fill.order->GetOrderType(), transaction.GetPrice(), transaction.GetVolume());
+    }
+}
+
+template <typename TLatency, typename TFee>
+void BasicBackTest<TLatency, TFee>::PrintOrderBook(bool print_name) const {
+    orderbook_.Print(print_name);
+}
+
+template <typename TLatency, typename TFee>
+EngineStats BasicBackTest<TLatency, TFee>::GetStats() const {
+    EngineStats stats = stats_;
+    stats.orderbook = orderbook_.GetStats();
+    return stats;
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetBestBid() const {
+    if (GetBid().empty()) {
+        throw std::runtime_error("BackTest::GetBestBid - orderbook_.bid_ have to be non empty.");
+    }
+    return (*GetBid().begin())->GetPriceLimit();
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetBestAsk() const {
+    if (GetAsk().empty()) {
+        throw std::runtime_error("BackTest::GetBestAsk - orderbook_.ask_ have to be non empty.");
+    }
+    return (*GetAsk().begin())->GetPriceLimit();
+}
+
+template <typename TLatency, typename TFee>
+const TLatency& BasicBackTest<TLatency, TFee>::GetLatencyModel() const {
+    return latency_;
+}
+
+template <typename TLatency, typename TFee>
+const TFee& BasicBackTest<TLatency, TFee>::GetFeeModel() const {
+    return fee_;
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetPostLatency() const {
+    return latency_.GetMaxPostLatency();
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetCancelLatency() const {
+    return latency_.GetMaxCancelLatency();
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetCallFrequency() const {
+    return call_frequency_;
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetLastCall(const size_t& account) const {
+    return GetAccount(account).last_call;
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetTotalMarketCash() const {
+    uint64_t cash = 0;
+    for (const auto& order : GetBid()) {
+        cash += order->GetRemainingVolume() * order->GetPriceLimit();
+    }
+    return cash;
+}
+
+template <typename TLatency, typename TFee>
+uint64_t BasicBackTest<TLatency, TFee>::GetTotalMarketAsset() const {
+    uint64_t asset = 0;
+    for (const auto& order : GetAsk()) {
+        asset += order->GetRemainingVolume();
+    }
+    return asset;
+}
+
+template <typename TLatency, typename TFee>
+template <typename TStrategy>
+bool BasicBackTest<TLatency, TFee>::ProcessQueue(TStrategy& strategy) {
+    uint64_t orders_time =
+        historical_data_->HasSnapshot() ? historical_data_->GetSnapshotTimestamp() : -1;
+    uint64_t level_updates_time =
+        historical_data_->HasLevelUpdate() ? historical_data_->GetLevelUpdate().timestamp : -1;
+    uint64_t transactions_time = historical_data_->HasTransaction()
+                                     ? historical_data_->GetTransaction().GetTransactionTimestamp()
+                                     : -1;
+    // the first account wins a tie of the requests
+    Account* request_account = nullptr;
+    uint64_t request_time = -1;
+    for (auto& account : accounts_) {
+        uint64_t time = GetRequestTimestamp(account);
+        if (time < request_time) {
+            request_time = time;
+            request_account = &account;
+        }
+    }
+
+    uint64_t min_value =
+        std::min({orders_time, level_updates_time, transactions_time, request_time});
+    if (min_value > current_timestamp_) {
+        return false;
+    }
+    if (min_value == orders_time) {
+        BACKTEST_ALLOCATION_SCOPE(BOOK_UPDATE, STRATEGY);
+        if (historical_orderbook_) {
+            historical_orderbook_->UpdateOrderBook(CopyOrders(historical_data_->GetAsk()),
+                                                   CopyOrders(historical_data_->GetBid()));
+            for (auto& account : accounts_) {
+                if (account.overlay) {
+                    account.overlay->UpdateOrderBook();
+                }
+            }
+        }
+        orderbook_.UpdateOrderBook(historical_data_->GetAsk(), historical_data_->GetBid());
+        historical_data_->PopSnapshot();
+        BACKTEST_STATS(++stats_.events[BOOK_UPDATE]);
+        BACKTEST_LOG(LOG_BOOK_UPDATE, min_value, GetAsk().empty() ? 0 : GetBestAsk(),
+                     GetBid().empty() ? 0 : GetBestBid(), GetAsk().size(), GetBid().size());
+        strategy.OnBookUpdate(*this);
+    } else if (min_value == level_updates_time) {
+        BACKTEST_ALLOCATION_SCOPE(LEVEL_UPDATE, STRATEGY);
+        const auto update = historical_data_->GetLevelUpdate();
+        historical_data_->PopLevelUpdate();
+        orderbook_.UpdateLevel(update);
+        if (historical_orderbook_) {
+            historical_orderbook_->UpdateLevel(update);
+            for (auto& account : accounts_) {
+                if (account.overlay) {
+                    account.overlay->UpdateLevel(update);
+                }
+            }
+        }
+        BACKTEST_STATS(++stats_.events[LEVEL_UPDATE]);
+        BACKTEST_LOG(LOG_LEVEL_UPDATE, min_value, update.order_type, update.price, update.volume);
+        strategy.OnLevelUpdate(*this, update);
+    } else if (min_value == transactions_time) {
+        BACKTEST_ALLOCATION_SCOPE(MARKET_TRADE, STRATEGY);
+        const auto transaction = historical_data_->GetTransaction();
+        const auto& print_ends = historical_data_->GetPrintEnds();
+        orderbook_.CompleteMarketTransaction(transaction, print_ends);
+        SettleUserFills(orderbook_.GetLastUserFills(), MAKER);
+        if (historical_orderbook_) {
+            // the overlays walk the historical orders before the transaction changes them
+            for (auto& account : accounts_) {
+                if (account.overlay) {
+                    account.overlay->CompleteMarketTransaction(transaction, print_ends);
+                    SettleUserFills(account.overlay->GetLastUserFills(), MAKER);
+                }
+            }
+            historical_orderbook_->CompleteMarketTransaction(transaction);
+        }
+        historical_data_->PopTransaction();
+        BACKTEST_STATS(++stats_.events[MARKET_TRADE]);
+        BACKTEST_LOG(LOG_MARKET_TRADE, min_value, transaction.GetPrice(), transaction.GetVolume(),
+                     transaction.GetIsBuyerMaker(), orderbook_.GetLastUserFills().size());
+        UpdateFeatureStore();
+        strategy.OnTrade(*this, transaction);
+        NotifyUserFills(strategy, orderbook_.GetLastUserFills());
+        for (const auto& account : accounts_) {
+            if (account.overlay) {
+                NotifyUserFills(strategy, account.overlay->GetLastUserFills());
+            }
+        }
+    } else {
+        ProcessRequest(strategy, *request_account, min_value);
+    }
+    return true;
+}
+
+template <typename TLatency, typename TFee>
+template <typename TStrategy>
+void BasicBackTest<TLatency, TFee>::ProcessRequest(TStrategy& strategy, Account& account,
+                                                   const uint64_t& timestamp) {
+    if (account.overlay) {
+        ProcessRequest(strategy, account, *account.overlay, timestamp);
+    } else {
+        ProcessRequest(strategy, account, orderbook_, timestamp);
+    }
+}
+
+template <typename TLatency, typename TFee>
+template <typename TStrategy, typename TOrderBook>
+void BasicBackTest<TLatency, TFee>::ProcessRequest(TStrategy& strategy, Account& account,
+                                                   TOrderBook& orderbook,
+                                                   const uint64_t& timestamp) {
+    if (!account.queue_limit_orders.empty() &&
+        account.queue_limit_orders.front().GetSubmitTimestamp() == timestamp) {
+        BACKTEST_ALLOCATION_SCOPE(USER_LIMIT_ORDER, STRATEGY);
+        auto order = account.queue_limit_orders.front();
+        account.queue_limit_orders.pop();
+        orderbook.AddUserLimitOrder(order.GetOrderId(), order.GetSubmitTimestamp(),
+                                    order.GetOrderType(), order.GetVolume(),
+                                    order.GetPriceLimit());
+        account.order_tracker.Acknowledge(timestamp, order.GetOrderId());
+        BACKTEST_STATS(++stats_.events[USER_LIMIT_ORDER]);
+        RecordOrder(timestamp, order.GetOrderId(), ORDER_ACK, &order);
+        strategy.OnOrderAck(*this, order.GetOrderId());
+    } else if (!account.queue_market_orders.empty() &&
+               account.queue_market_orders.front().GetSubmitTimestamp() == timestamp) {
+        BACKTEST_ALLOCATION_SCOPE(USER_MARKET_ORDER, STRATEGY);
+        auto order = account.queue_market_orders.front();
+        account.queue_market_orders.pop();
+        orderbook.CompleteUserMarketOrder(order.GetOrderId(), order.GetSubmitTimestamp(),
+                                          order.GetOrderType(), order.GetVolume());
+        account.order_tracker.Acknowledge(timestamp, order.GetOrderId());
+        SettleUserFills(orderbook.GetLastUserFills(), TAKER);
+        account.order_tracker.CloseMarketOrder(timestamp, order.GetOrderId());
+        BACKTEST_STATS(++stats_.events[USER_MARKET_ORDER]);
+        RecordOrder(timestamp, order.GetOrderId(), ORDER_ACK, &order);
+        UpdateFeatureStore();
+        strategy.OnOrderAck(*this, order.GetOrderId());
+        NotifyUserFills(strategy, orderbook.GetLastUserFills());
+    } else {
+        BACKTEST_ALLOCATION_SCOPE(USER_CANCEL, STRATEGY);
+        auto order_id = account.queue_remove_orders.front().order_id;
+        account.queue_remove_orders.pop();
+        orderbook.RemoveOrder(order_id);
+        account.order_tracker.Cancel(timestamp, order_id);
+        BACKTEST_STATS(++stats_.events[USER_CANCEL]);
+        RecordOrder(timestamp, order_id, CANCEL_ACK);
+        strategy.OnCancelAck(*this, order_id);
+    }
+}
+
+template <typename TLatency, typename TFee>
+template <typename TStrategy>
+void BasicBackTest<TLatency, TFee>::NotifyUserFills(TStrategy& strategy,
+                                                    const TUserFillVector& fills) {
+    for (const auto& fill : fills) {
+        strategy.OnFill(*this, *fill.order, *fill.transaction);
+    }
+}
+
+template <typename TLatency, typename TFee>
+template <typename TStrategy>
+uint64_t BasicBackTest<TLatency, TFee>::ProcessTimeInterval(const uint64_t& step,
+                                                            TStrategy& strategy) {
+    current_timestamp_ += step;
+    for (auto& account : accounts_) {
+        account.order_tracker.ClearChanges();
+    }
+    {
+        BACKTEST_STATS(ScopedTimer timer(stats_.event_loop));
+        while (ProcessQueue(strategy)) {
+        }
+    }
+    feature_store_.AdvanceTo(current_timestamp_);
+    RecordPNL();
+    return current_timestamp_;
+}
+
+template <typename TLatency, typename TFee>
+template <typename TStrategy>
+uint64_t BasicBackTest<TLatency, TFee>::Run(TStrategy& strategy, const uint64_t& end_timestamp,
+                                            const uint64_t& timer_step) {
+    if (timer_step == 0) {
+        throw std::runtime_error("BackTest::Run - timer_step have to be positive.");
+    }
+    while (current_timestamp_ < end_timestamp) {
+        ProcessTimeInterval(std::min(timer_step, end_timestamp - current_timestamp_), strategy);
+        strategy.OnTimer(*this);
+    }
+    return current_timestamp_;
+}
@@ -1,7 +1,32 @@
 #pragma once
 
+#include "allocation_tracker.h"
+#include "book_kernels.h"
+#include "book_overlay.h"
+#include "compact_data.h"
 #include "completed_transaction.h"
+#include "event_log.h"
+#include "execution_models.h"
+#include "feature_export.h"
+#include "feature_set.h"
+#include "feature_store.h"
+#include "instrumentation.h"
+#include "level_index.h"
+#include "level_update.h"
+#include "market_generator.h"
 #include "order.h"
+#include "order_tracker.h"
 #include "orderbook.h"
+#include "prefetcher.h"
+#include "replay_book.h"
+#include "results_sink.h"
 #include "scanner.h"
-#include "backtest.h"
\ No newline at end of file
+#include "spsc_queue.h"
+#include "trade_history.h"
+#include "tree_ensemble.h"
+#include "backtest.h"
+#include "parameter_sweep.h"
+
+#ifdef BACKTEST_COROUTINES
+#include "coroutine_engine.h"
+#endif
@@ -0,0 +1,573 @@
+#include "book_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// BookLevels
+
+size_t BookLevels::Size() const {
+    return prices.size();
+}
+
+void BookLevels::Clear() {
+    prices.clear();
+    volumes.clear();
+}
+
+// KernelIsa
+
+std::string ToString(const KernelIsa& isa) {
+    if (isa == SCALAR) {
+        return "SCALAR";
+    } else if (isa == SSE2) {
+        return "SSE2";
+    } else if (isa == AVX2) {
+        return "AVX2";
+    } else {
+        throw std::runtime_error("ToString - Incorrect isa.");
+    }
+}
+
+bool IsKernelIsaSupported(const KernelIsa& isa) {
+#if defined(__x86_64__)
+    if (isa == AVX2) {
+        return __builtin_cpu_supports("avx2");
+    }
+    return true;
+#else
+    return isa == SCALAR;
+#endif
+}
+
+namespace {
+
+KernelIsa DetectKernelIsa() {
+    for (const auto& isa : {AVX2, SSE2}) {
+        if (IsKernelIsaSupported(isa)) {
+            return isa;
+        }
+    }
+    return SCALAR;
+}
+
+KernelIsa current_isa = DetectKernelIsa();
+
+// scalar kernels
+
+uint64_t SumScalar(const uint64_t* values, const size_t& n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+void ImbalanceScalar(const uint64_t* ask, const uint64_t* bid, const size_t& n, double& diff,
+                     double& total) {
+    for (size_t i = 0; i < n; ++i) {
+        double weight = 1.0 / (i + 1);
+        diff += weight * (static_cast<double>(bid[i]) - static_cast<double>(ask[i]));
+        total += weight * (static_cast<double>(bid[i]) + static_cast<double>(ask[i]));
+    }
+}
+
+double NotionalScalar(const uint64_t* prices, const uint64_t* volumes, const size_t& n,
+                      const double& mid, const double& band) {
+    double notional = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double price = static_cast<double>(prices[i]);
+        if (price - mid <= band && mid - price <= band) {
+            notional += price * static_cast<double>(volumes[i]);
+        }
+    }
+    return notional;
+}
+
+void LaneSignalsScalar(const double* ask_cumulative, const double* bid_cumulative,
+                       const uint64_t* depths, const double* thresholds, const double& total,
+                       const size_t& lanes, double* signals) {
+    for (size_t i = 0; i < lanes; ++i) {
+        double pressure = ask_cumulative[depths[i]] - bid_cumulative[depths[i]];
+        if (std::abs(pressure) * thresholds[i] < total) {
+            signals[i] = 0;
+        } else {
+            signals[i] = pressure > 0 ? -1 : 1;
+        }
+    }
+}
+
+void LaneConfirmationsScalar(const double* imbalances, const uint64_t* butches,
+                             const double* half_butches, const size_t& lanes, double* signals) {
+    for (size_t i = 0; i < lanes; ++i) {
+        double imbalance = imbalances[butches[i]];
+        double confirmation = 0;
+        if (std::abs(imbalance) >= half_butches[i] && imbalance != 0) {
+            confirmation = imbalance > 0 ? 1 : -1;
+        }
+        if (butches[i] != 0 && confirmation != signals[i]) {
+            signals[i] = 0;
+        }
+    }
+}
+
+void LaneFillsScalar(const double* prices, const double* sides, const double* remaining,
+                     const double& price, const double& volume, const double& side,
+                     const size_t& lanes, double* fills) {
+    for (size_t i = 0; i < lanes; ++i) {
+        bool is_filled = sides[i] == side && (prices[i] - price) * side >= 0;
+        fills[i] = is_filled ? std::min(remaining[i], volume) : 0;
+    }
+}
+
+#if defined(__x86_64__)
+
+// SSE2 kernels, 2 lanes of 64 bits
+
+uint64_t SumSse2(const uint64_t* values, const size_t& n) {
+    __m128i sum = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        sum = _mm_add_epi64(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+    return lanes[0] + lanes[1] + SumScalar(values + i, n - i);
+}
+
+// exact for values less than 2^52
+__m128d ToDoubleSse2(const __m128i& values) {
+    const __m128i magic_bits = _mm_set1_epi64x(0x4330000000000000);
+    const __m128d magic = _mm_set1_pd(4503599627370496.0);
+    return _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(values, magic_bits)), magic);
+}
+
+void ImbalanceSse2(const uint64_t* ask, const uint64_t* bid, const size_t& n, double& diff,
+                   double& total) {
+    __m128d sum_diff = _mm_setzero_pd();
+    __m128d sum_total = _mm_setzero_pd();
+    __m128d index = _mm_set_pd(2, 1);
+    const __m128d step = _mm_set1_pd(2);
+    const __m128d one = _mm_set1_pd(1);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d ask_volume =
+            ToDoubleSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ask + i)));
+        __m128d bid_volume =
+            ToDoubleSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bid + i)));
+        __m128d weight = _mm_div_pd(one, index);
+        sum_diff = _mm_add_pd(sum_diff, _mm_mul_pd(weight, _mm_sub_pd(bid_volume, ask_volume)));
+        sum_total = _mm_add_pd(sum_total, _mm_mul_pd(weight, _mm_add_pd(bid_volume, ask_volume)));
+        index = _mm_add_pd(index, step);
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, sum_diff);
+    diff += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sum_total);
+    total += lanes[0] + lanes[1];
+    for (; i < n; ++i) {
+        double weight = 1.0 / (i + 1);
+        diff += weight * (static_cast<double>(bid[i]) - static_cast<double>(ask[i]));
+        total += weight * (static_cast<double>(bid[i]) + static_cast<double>(ask[i]));
+    }
+}
+
+double NotionalSse2(const uint64_t* prices, const uint64_t* volumes, const size_t& n,
+                    const double& mid, const double& band) {
+    __m128d sum = _mm_setzero_pd();
+    const __m128d mid_vector = _mm_set1_pd(mid);
+    const __m128d band_vector = _mm_set1_pd(band);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d price =
+            ToDoubleSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(prices + i)));
+        __m128d volume =
+            ToDoubleSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(volumes + i)));
+        __m128d inside = _mm_and_pd(_mm_cmple_pd(_mm_sub_pd(price, mid_vector), band_vector),
+                                    _mm_cmple_pd(_mm_sub_pd(mid_vector, price), band_vector));
+        sum = _mm_add_pd(sum, _mm_and_pd(inside, _mm_mul_pd(price, volume)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, sum);
+    return lanes[0] + lanes[1] + NotionalScalar(prices + i, volumes + i, n - i, mid, band);
+}
+
+void LaneSignalsSse2(const double* ask_cumulative, const double* bid_cumulative,
+                     const uint64_t* depths, const double* thresholds, const double& total,
+                     const size_t& lanes, double* signals) {
+    const __m128d total_vector = _mm_set1_pd(total);
+    const __m128d sign_mask = _mm_set1_pd(-0.0);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1);
+    const __m128d two = _mm_set1_pd(2);
+    size_t i = 0;
+    for (; i + 2 <= lanes; i += 2) {
+        // no gather in SSE2
+        __m128d ask = _mm_set_pd(ask_cumulative[depths[i + 1]], ask_cumulative[depths[i]]);
+        __m128d bid = _mm_set_pd(bid_cumulative[depths[i + 1]], bid_cumulative[depths[i]]);
+        __m128d pressure = _mm_sub_pd(ask, bid);
+        __m128d strength = _mm_mul_pd(_mm_andnot_pd(sign_mask, pressure),
+                                      _mm_loadu_pd(thresholds + i));
+        __m128d is_wait = _mm_cmplt_pd(strength, total_vector);
+        __m128d is_sell = _mm_cmpgt_pd(pressure, zero);
+        __m128d signal = _mm_sub_pd(one, _mm_and_pd(is_sell, two));
+        _mm_storeu_pd(signals + i, _mm_andnot_pd(is_wait, signal));
+    }
+    LaneSignalsScalar(ask_cumulative, bid_cumulative, depths + i, thresholds + i, total,
+                      lanes - i, signals + i);
+}
+
+void LaneConfirmationsSse2(const double* imbalances, const uint64_t* butches,
+                           const double* half_butches, const size_t& lanes, double* signals) {
+    const __m128d sign_mask = _mm_set1_pd(-0.0);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1);
+    size_t i = 0;
+    for (; i + 2 <= lanes; i += 2) {
+        __m128d imbalance = _mm_set_pd(imbalances[butches[i + 1]], imbalances[butches[i]]);
+        __m128d butch = _mm_set_pd(static_cast<double>(butches[i + 1]),
+                                   static_cast<double>(butches[i]));
+        __m128d is_strong = _mm_cmpge_pd(_mm_andnot_pd(sign_mask, imbalance),
+                                         _mm_loadu_pd(half_butches + i));
+        __m128d direction = _mm_sub_pd(_mm_and_pd(_mm_cmpgt_pd(imbalance, zero), one),
+                                       _mm_and_pd(_mm_cmplt_pd(imbalance, zero), one));
+        __m128d confirmation = _mm_and_pd(is_strong, direction);
+        __m128d signal = _mm_loadu_pd(signals + i);
+        __m128d is_kept =
+            _mm_or_pd(_mm_cmpeq_pd(butch, zero), _mm_cmpeq_pd(confirmation, signal));
+        _mm_storeu_pd(signals + i, _mm_and_pd(is_kept, signal));
+    }
+    LaneConfirmationsScalar(imbalances, butches + i, half_butches + i, lanes - i, signals + i);
+}
+
+void LaneFillsSse2(const double* prices, const double* sides, const double* remaining,
+                   const double& price, const double& volume, const double& side,
+                   const size_t& lanes, double* fills) {
+    const __m128d price_vector = _mm_set1_pd(price);
+    const __m128d volume_vector = _mm_set1_pd(volume);
+    const __m128d side_vector = _mm_set1_pd(side);
+    const __m128d zero = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= lanes; i += 2) {
+        __m128d distance =
+            _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(prices + i), price_vector), side_vector);
+        __m128d is_filled = _mm_and_pd(_mm_cmpeq_pd(_mm_loadu_pd(sides + i), side_vector),
+                                       _mm_cmpge_pd(distance, zero));
+        __m128d fill = _mm_min_pd(_mm_loadu_pd(remaining + i), volume_vector);
+        _mm_storeu_pd(fills + i, _mm_and_pd(is_filled, fill));
+    }
+    LaneFillsScalar(prices + i, sides + i, remaining + i, price, volume, side, lanes - i,
+                    fills + i);
+}
+
+// AVX2 kernels, 4 lanes of 64 bits
+
+__attribute__((target("avx2"))) uint64_t SumAvx2(const uint64_t* values, const size_t& n) {
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        sum = _mm256_add_epi64(sum,
+                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumScalar(values + i, n - i);
+}
+
+__attribute__((target("avx2"))) __m256d ToDoubleAvx2(const __m256i& values) {
+    const __m256i magic_bits = _mm256_set1_epi64x(0x4330000000000000);
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0);
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(values, magic_bits)), magic);
+}
+
+__attribute__((target("avx2"))) void ImbalanceAvx2(const uint64_t* ask, const uint64_t* bid,
+                                                   const size_t& n, double& diff,
+                                                   double& total) {
+    __m256d sum_diff = _mm256_setzero_pd();
+    __m256d sum_total = _mm256_setzero_pd();
+    __m256d index = _mm256_set_pd(4, 3, 2, 1);
+    const __m256d step = _mm256_set1_pd(4);
+    const __m256d one = _mm256_set1_pd(1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d ask_volume =
+            ToDoubleAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ask + i)));
+        __m256d bid_volume =
+            ToDoubleAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bid + i)));
+        __m256d weight = _mm256_div_pd(one, index);
+        sum_diff =
+            _mm256_add_pd(sum_diff, _mm256_mul_pd(weight, _mm256_sub_pd(bid_volume, ask_volume)));
+        sum_total = _mm256_add_pd(sum_total,
+                                  _mm256_mul_pd(weight, _mm256_add_pd(bid_volume, ask_volume)));
+        index = _mm256_add_pd(index, step);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum_diff);
+    diff += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_pd(lanes, sum_total);
+    total += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) {
+        double weight = 1.0 / (i + 1);
+        diff += weight * (static_cast<double>(bid[i]) - static_cast<double>(ask[i]));
+        total += weight * (static_cast<double>(bid[i]) + static_cast<double>(ask[i]));
+    }
+}
+
+__attribute__((target("avx2"))) double NotionalAvx2(const uint64_t* prices,
+                                                    const uint64_t* volumes, const size_t& n,
+                                                    const double& mid, const double& band) {
+    __m256d sum = _mm256_setzero_pd();
+    const __m256d mid_vector = _mm256_set1_pd(mid);
+    const __m256d band_vector = _mm256_set1_pd(band);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d price =
+            ToDoubleAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(prices + i)));
+        __m256d volume =
+            ToDoubleAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(volumes + i)));
+        __m256d inside = _mm256_and_pd(
+            _mm256_cmp_pd(_mm256_sub_pd(price, mid_vector), band_vector, _CMP_LE_OQ),
+            _mm256_cmp_pd(_mm256_sub_pd(mid_vector, price), band_vector, _CMP_LE_OQ));
+        sum = _mm256_add_pd(sum, _mm256_and_pd(inside, _mm256_mul_pd(price, volume)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           NotionalScalar(prices + i, volumes + i, n - i, mid, band);
+}
+
+__attribute__((target("avx2"))) void LaneSignalsAvx2(const double* ask_cumulative,
+                                                     const double* bid_cumulative,
+                                                     const uint64_t* depths,
+                                                     const double* thresholds,
+                                                     const double& total, const size_t& lanes,
+                                                     double* signals) {
+    const __m256d total_vector = _mm256_set1_pd(total);
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1);
+    const __m256d two = _mm256_set1_pd(2);
+    size_t i = 0;
+    for (; i + 4 <= lanes; i += 4) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(depths + i));
+        __m256d pressure = _mm256_sub_pd(_mm256_i64gather_pd(ask_cumulative, index, 8),
+                                         _mm256_i64gather_pd(bid_cumulative, index, 8));
+        __m256d strength = _mm256_mul_pd(_mm256_andnot_pd(sign_mask, pressure),
+                                         _mm256_loadu_pd(thresholds + i));
+        __m256d is_wait = _mm256_cmp_pd(strength, total_vector, _CMP_LT_OQ);
+        __m256d is_sell = _mm256_cmp_pd(pressure, zero, _CMP_GT_OQ);
+        __m256d signal = _mm256_sub_pd(one, _mm256_and_pd(is_sell, two));
+        _mm256_storeu_pd(signals + i, _mm256_andnot_pd(is_wait, signal));
+    }
+    LaneSignalsScalar(ask_cumulative, bid_cumulative, depths + i, thresholds + i, total,
+                      lanes - i, signals + i);
+}
+
+__attribute__((target("avx2"))) void LaneConfirmationsAvx2(const double* imbalances,
+                                                           const uint64_t* butches,
+                                                           const double* half_butches,
+                                                           const size_t& lanes,
+                                                           double* signals) {
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1);
+    size_t i = 0;
+    for (; i + 4 <= lanes; i += 4) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(butches + i));
+        __m256d imbalance = _mm256_i64gather_pd(imbalances, index, 8);
+        __m256d is_strong = _mm256_cmp_pd(_mm256_andnot_pd(sign_mask, imbalance),
+                                          _mm256_loadu_pd(half_butches + i), _CMP_GE_OQ);
+        __m256d direction =
+            _mm256_sub_pd(_mm256_and_pd(_mm256_cmp_pd(imbalance, zero, _CMP_GT_OQ), one),
+                          _mm256_and_pd(_mm256_cmp_pd(imbalance, zero, _CMP_LT_OQ), one));
+        __m256d confirmation = _mm256_and_pd(is_strong, direction);
+        __m256d signal = _mm256_loadu_pd(signals + i);
+        __m256d is_off =
+            _mm256_castsi256_pd(_mm256_cmpeq_epi64(index, _mm256_setzero_si256()));
+        __m256d is_kept =
+            _mm256_or_pd(is_off, _mm256_cmp_pd(confirmation, signal, _CMP_EQ_OQ));
+        _mm256_storeu_pd(signals + i, _mm256_and_pd(is_kept, signal));
+    }
+    LaneConfirmationsScalar(imbalances, butches + i, half_butches + i, lanes - i, signals + i);
+}
+
+__attribute__((target("avx2"))) void LaneFillsAvx2(const double* prices, const double* sides,
+                                                   const double* remaining, const double& price,
+                                                   const double& volume, const double& side,
+                                                   const size_t& lanes, double* fills) {
+    const __m256d price_vector = _mm256_set1_pd(price);
+    const __m256d volume_vector = _mm256_set1_pd(volume);
+    const __m256d side_vector = _mm256_set1_pd(side);
+    const __m256d zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= lanes; i += 4) {
+        __m256d distance = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(prices + i), price_vector),
+                                         side_vector);
+        __m256d is_filled =
+            _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(sides + i), side_vector, _CMP_EQ_OQ),
+                          _mm256_cmp_pd(distance, zero, _CMP_GE_OQ));
+        __m256d fill = _mm256_min_pd(_mm256_loadu_pd(remaining + i), volume_vector);
+        _mm256_storeu_pd(fills + i, _mm256_and_pd(is_filled, fill));
+    }
+    LaneFillsScalar(prices + i, sides + i, remaining + i, price, volume, side, lanes - i,
+                    fills + i);
+}
+
+#endif
+
+uint64_t Sum(const uint64_t* values, const size_t& n) {
+#if defined(__x86_64__)
+    if (current_isa == AVX2) {
+        return SumAvx2(values, n);
+    } else if (current_isa == SSE2) {
+        return SumSse2(values, n);
+    }
+#endif
+    return SumScalar(values, n);
+}
+
+void Imbalance(const uint64_t* ask, const uint64_t* bid, const size_t& n, double& diff,
+               double& total) {
+#if defined(__x86_64__)
+    if (current_isa == AVX2) {
+        ImbalanceAvx2(ask, bid, n, diff, total);
+        return;
+    } else if (current_isa == SSE2) {
+        ImbalanceSse2(ask, bid, n, diff, total);
+        return;
+    }
+#endif
+    ImbalanceScalar(ask, bid, n, diff, total);
+}
+
+double Notional(const uint64_t* prices, const uint64_t* volumes, const size_t& n,
+                const double& mid, const double& band) {
+#if defined(__x86_64__)
+    if (current_isa == AVX2) {
+        return NotionalAvx2(prices, volumes, n, mid, band);
+    } else if (current_isa == SSE2) {
+        return NotionalSse2(prices, volumes, n, mid, band);
+    }
+#endif
+    return NotionalScalar(prices, volumes, n, mid, band);
+}
+
+void LaneSignals(const double* ask_cumulative, const double* bid_cumulative,
+                 const uint64_t* depths, const double* thresholds, const double& total,
+                 const size_t& lanes, double* signals) {
+#if defined(__x86_64__)
+    if (current_isa == AVX2) {
+        LaneSignalsAvx2(ask_cumulative, bid_cumulative, depths, thresholds, total, lanes,
+                        signals);
+        return;
+    } else if (current_isa == SSE2) {
+        LaneSignalsSse2(ask_cumulative, bid_cumulative, depths, thresholds, total, lanes,
+                        signals);
+        return;
+    }
+#endif
+    LaneSignalsScalar(ask_cumulative, bid_cumulative, depths, thresholds, total, lanes, signals);
+}
+
+void LaneConfirmations(const double* imbalances, const uint64_t* butches,
+                       const double* half_butches, const size_t& lanes, double* signals) {
+#if defined(__x86_64__)
+    if (current_isa == AVX2) {
+        LaneConfirmationsAvx2(imbalances, butches, half_butches, lanes, signals);
+        return;
+    } else if (current_isa == SSE2) {
+        LaneConfirmationsSse2(imbalances, butches, half_butches, lanes, signals);
+        return;
+    }
+#endif
+    LaneConfirmationsScalar(imbalances, butches, half_butches, lanes, signals);
+}
+
+void LaneFills(const double* prices, const double* sides, const double* remaining,
+               const double& price, const double& volume, const double& side, const size_t& lanes,
+               double* fills) {
+#if defined(__x86_64__)
+    if (current_isa == AVX2) {
+        LaneFillsAvx2(prices, sides, remaining, price, volume, side, lanes, fills);
+        return;
+    } else if (current_isa == SSE2) {
+        LaneFillsSse2(prices, sides, remaining, price, volume, side, lanes, fills);
+        return;
+    }
+#endif
+    LaneFillsScalar(prices, sides, remaining, price, volume, side, lanes, fills);
+}
+
+}  // namespace
+
+KernelIsa GetKernelIsa() {
+    return current_isa;
+}
+
+void SetKernelIsa(const KernelIsa& isa) {
+    if (!IsKernelIsaSupported(isa)) {
+        throw std::runtime_error("SetKernelIsa - The isa isn't supported by this cpu.");
+    }
+    current_isa = isa;
+}
+
+// kernels
+
+uint64_t GetCumulativeVolume(const BookLevels& levels, const size_t& depth) {
+    return Sum(levels.volumes.data(), std::min(depth, levels.Size()));
+}
+
+double GetDepthWeightedImbalance(const BookLevels& ask, const BookLevels& bid,
+                                 const size_t& depth) {
+    size_t n = std::min({depth, ask.Size(), bid.Size()});
+    double diff = 0, total = 0;
+    Imbalance(ask.volumes.data(), bid.volumes.data(), n, diff, total);
+    if (total == 0) {
+        return 0;
+    }
+    return diff / total;
+}
+
+double GetMicroPrice(const BookLevels& ask, const BookLevels& bid) {
+    if (ask.Size() == 0 || bid.Size() == 0) {
+        throw std::runtime_error("GetMicroPrice - Both sides have to be non empty.");
+    }
+    double ask_volume = ask.volumes[0], bid_volume = bid.volumes[0];
+    if (ask_volume + bid_volume == 0) {
+        return (static_cast<double>(ask.prices[0]) + static_cast<double>(bid.prices[0])) / 2;
+    }
+    return (ask.prices[0] * bid_volume + bid.prices[0] * ask_volume) / (ask_volume + bid_volume);
+}
+
+double GetNotionalNearMid(const BookLevels& ask, const BookLevels& bid, const uint64_t& bps) {
+    if (ask.Size() == 0 || bid.Size() == 0) {
+        throw std::runtime_error("GetNotionalNearMid - Both sides have to be non empty.");
+    }
+    static const double percent_base = 10000;
+    double mid = (static_cast<double>(ask.prices[0]) + static_cast<double>(bid.prices[0])) / 2;
+    double band = mid * bps / percent_base;
+    return Notional(ask.prices.data(), ask.volumes.data(), ask.Size(), mid, band) +
+           Notional(bid.prices.data(), bid.volumes.data(), bid.Size(), mid, band);
+}
+
+void GetLaneSignals(const double* ask_cumulative, const double* bid_cumulative,
+                    const uint64_t* depths, const double* thresholds, const double& total,
+                    const size_t& lanes, double* signals) {
+    LaneSignals(ask_cumulative, bid_cumulative, depths, thresholds, total, lanes, signals);
+}
+
+void GetLaneConfirmations(const double* imbalances, const uint64_t* butches,
+                          const double* half_butches, const size_t& lanes, double* signals) {
+    LaneConfirmations(imbalances, butches, half_butches, lanes, signals);
+}
+
+void GetLaneFills(const double* prices, const double* sides, const double* remaining,
+                  const double& price, const double& volume, const bool& is_buyer_maker,
+                  const size_t& lanes, double* fills) {
+    // a buyer maker transaction is a sell into the bids
+    LaneFills(prices, sides, remaining, price, volume, is_buyer_maker ? 1 : -1, lanes, fills);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "order.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One side of the orderbook as contiguous arrays aggregated by price, best level first.
+struct BookLevels {
+    std::vector<uint64_t> prices;
+    std::vector<uint64_t> volumes;
+    size_t Size() const;
+    void Clear();
+};
+
+// Collects at most max_depth price levels of the remaining (not closed) volume of the orders.
+template <typename TLimitSet>
+void FillBookLevels(const TLimitSet& orders, const size_t& max_depth, BookLevels& levels) {
+    levels.Clear();
+    for (const auto& order : orders) {
+        if (order->IsClosed()) {
+            continue;
+        }
+        if (levels.Size() == 0 || levels.prices.back() != order->GetPriceLimit()) {
+            if (levels.Size() == max_depth) {
+                break;
+            }
+            levels.prices.emplace_back(order->GetPriceLimit());
+            levels.volumes.emplace_back(0);
+        }
+        levels.volumes.back() += order->GetRemainingVolume();
+    }
+}
+
+// Instruction set used by the kernels below. The best supported one is chosen at startup,
+// the others are kept for testing and benchmarking.
+enum KernelIsa { SCALAR, SSE2, AVX2 };
+
+std::string ToString(const KernelIsa& isa);
+KernelIsa GetKernelIsa();
+bool IsKernelIsaSupported(const KernelIsa& isa);
+void SetKernelIsa(const KernelIsa& isa);
+
+// All kernels expect prices and volumes less than 2^52 to convert them into double exactly.
+
+// total volume of the first depth levels
+uint64_t GetCumulativeVolume(const BookLevels& levels, const size_t& depth);
+
+// sum of (bid - ask) / sum of (bid + ask) over the first depth levels,
+// level i has weight 1 / (i + 1)
+double GetDepthWeightedImbalance(const BookLevels& ask, const BookLevels& bid,
+                                 const size_t& depth);
+
+// best prices weighted by the opposite best volumes
+double GetMicroPrice(const BookLevels& ask, const BookLevels& bid);
+
+// total price * volume of the levels of both sides not further than bps / 10^4 * mid from mid
+double GetNotionalNearMid(const BookLevels& ask, const BookLevels& bid, const uint64_t& bps);
+
+// Lane kernels of the parameter sweeps, element i of every lane array belongs to lane i. The
+// lanes hold doubles, so the prices and volumes have to be less than 2^52 as well.
+
+// the top pressure signal of every lane: 1 to buy, -1 to sell and 0 to wait. The pressure of lane
+// i is ask_cumulative[depths[i]] - bid_cumulative[depths[i]], the lane waits while
+// |pressure| * thresholds[i] < total and sells if the pressure is positive
+void GetLaneSignals(const double* ask_cumulative, const double* bid_cumulative,
+                    const uint64_t* depths, const double* thresholds, const double& total,
+                    const size_t& lanes, double* signals);
+
+// the trade count confirmation of every lane, as GetCountTransactionsPredictoin in main.cpp.
+// imbalances[b] is the buyer maker imbalance of the last b transactions, 0 while there are fewer.
+// A lane keeps its signal if butches[i] is 0 or if the imbalance of its window has the same sign
+// and |imbalance| >= half_butches[i], otherwise the lane waits
+void GetLaneConfirmations(const double* imbalances, const uint64_t* butches,
+                          const double* half_butches, const size_t& lanes, double* signals);
+
+// the volume the resting order of every lane takes from a market transaction, sides are 1 for a
+// bid, -1 for an ask and 0 without an order. A buyer maker transaction fills the bids at its
+// price or higher, the other one fills the asks at its price or lower
+void GetLaneFills(const double* prices, const double* sides, const double* remaining,
+                  const double& price, const double& volume, const bool& is_buyer_maker,
+                  const size_t& lanes, double* fills);
@@ -0,0 +1,299 @@
+#include "book_overlay.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// BookOverlay
+
+BookOverlay::BookOverlay(const OrderBook& historical_book) : historical_book_(historical_book) {
+}
+
+void BookOverlay::CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                            const TPrintEnds& print_ends) {
+    BACKTEST_ALLOCATION_SCOPE(MATCHING);
+    last_user_fills_.clear();
+    // without user orders and changed volumes the side is the same as in the historical book
+    if (transaction.GetIsBuyerMaker()) {
+        if (user_bid_.empty() && bid_volumes_.empty()) {
+            return;
+        }
+        if (const auto* orders = historical_book_.GetLazyBid()) {
+            CompleteMarketTransaction(transaction, print_ends, *orders, user_bid_, bid_volumes_);
+        } else {
+            CompleteMarketTransaction(transaction, print_ends, historical_book_.GetBid(),
+                                      user_bid_, bid_volumes_);
+        }
+    } else {
+        if (user_ask_.empty() && ask_volumes_.empty()) {
+            return;
+        }
+        if (const auto* orders = historical_book_.GetLazyAsk()) {
+            CompleteMarketTransaction(transaction, print_ends, *orders, user_ask_, ask_volumes_);
+        } else {
+            CompleteMarketTransaction(transaction, print_ends, historical_book_.GetAsk(),
+                                      user_ask_, ask_volumes_);
+        }
+    }
+}
+
+template <typename TLimitSet, typename TOrders>
+void BookOverlay::CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                            const TPrintEnds& print_ends, const TOrders& orders,
+                                            TLimitSet& user_orders,
+                                            TVolumes<TLimitSet>& volumes) {
+    typename TLimitSet::key_compare comparator;
+    // the volume left for the account and for the historical book
+    uint64_t current_volume = transaction.GetVolume();
+    uint64_t historical_volume = transaction.GetVolume();
+    auto it = orders.begin();
+    auto user_it = user_orders.begin();
+    auto volume_it = volumes.begin();
+    while (current_volume > 0 || historical_volume > 0) {
+        if (user_it != user_orders.end() && (it == orders.end() || comparator(*user_it, *it))) {
+            const auto& user_order = *user_it++;
+            uint64_t order_volume = std::min(current_volume, user_order->GetRemainingVolume());
+            while (order_volume > 0) {
+                uint64_t transaction_volume = GetPrintPart(
+                    print_ends, transaction.GetVolume() - current_volume, order_volume);
+                TTransaction current_transaction = std::make_shared<CompletedTransaction>(
+                    transaction.GetTransactionTimestamp(), transaction_volume,
+                    user_order->GetPriceLimit(), transaction.GetIsBuyerMaker());
+                user_order->AddTransaction(current_transaction);
+                order_volume -= transaction_volume;
+                current_volume -= transaction_volume;
+                last_user_fills_.emplace_back(user_order, current_transaction);
+            }
+            continue;
+        }
+        if (it == orders.end()) {
+            break;
+        }
+        const auto& order = *it++;
+        while (volume_it != volumes.end() && comparator(volume_it->first, order)) {
+            ++volume_it;
+        }
+        uint64_t historical_remaining = order->GetRemainingVolume();
+        uint64_t remaining = volume_it != volumes.end() && volume_it->first == order
+                                 ? volume_it->second
+                                 : historical_remaining;
+        uint64_t transaction_volume = std::min(current_volume, remaining);
+        uint64_t historical_transaction_volume = std::min(historical_volume, historical_remaining);
+        current_volume -= transaction_volume;
+        historical_volume -= historical_transaction_volume;
+        SetVolume<TLimitSet>(volumes, volume_it, order, remaining - transaction_volume,
+                             historical_remaining - historical_transaction_volume);
+    }
+    if (current_volume > 0) {
+        throw std::runtime_error(
+            "BookOverlay::CompleteMarketTransaction - Transaction is too big.");
+    }
+}
+
+template <typename TLimitSet>
+void BookOverlay::SetVolume(TVolumes<TLimitSet>& volumes,
+                            typename TVolumes<TLimitSet>::iterator& position, const TLimit& order,
+                            const uint64_t& volume, const uint64_t& historical_volume) {
+    bool has_volume = position != volumes.end() && position->first == order;
+    if (volume == historical_volume) {
+        if (has_volume) {
+            position = volumes.erase(position);
+        }
+    } else if (has_volume) {
+        position->second = volume;
+        ++position;
+    } else {
+        volumes.emplace_hint(position, order, volume);
+    }
+}
+
+void BookOverlay::UpdateOrderBook() {
+    // the snapshot replaces every historical order
+    ask_volumes_.clear();
+    bid_volumes_.clear();
+    EraseClosed(user_ask_);
+    EraseClosed(user_bid_);
+}
+
+template <typename TLimitSet>
+void BookOverlay::EraseClosed(TLimitSet& user_orders) {
+    for (auto it = user_orders.begin(); it != user_orders.end();) {
+        if ((*it)->IsClosed()) {
+            it = user_orders.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BookOverlay::UpdateLevel(const LevelUpdate& update) {
+    if (update.order_type == ASK) {
+        EraseLevel<TAskLimitSet>(update, ask_volumes_);
+    } else if (update.order_type == BID) {
+        EraseLevel<TBidLimitSet>(update, bid_volumes_);
+    } else {
+        throw std::runtime_error("BookOverlay::UpdateLevel - Incorrect order_type.");
+    }
+}
+
+template <typename TLimitSet>
+void BookOverlay::EraseLevel(const LevelUpdate& update, TVolumes<TLimitSet>& volumes) {
+    // the first and the last possible orders of the level
+    LimitOrder first_order(0, 0, update.order_type, 0, update.price);
+    LimitOrder last_order(-1, -1, update.order_type, 0, update.price);
+    volumes.erase(volumes.lower_bound(TLimit(TLimit(), &first_order)),
+                  volumes.upper_bound(TLimit(TLimit(), &last_order)));
+}
+
+void BookOverlay::AddUserLimitOrder(const uint64_t& order_id, const uint64_t& submit_timestamp,
+                                    const OrderTypes& order_type, const uint64_t& volume,
+                                    const uint64_t& price_limit) {
+    BACKTEST_ALLOCATION_SCOPE(USER_ORDERS);
+    TLimit limit_order =
+        std::make_shared<LimitOrder>(order_id, submit_timestamp, order_type, volume, price_limit);
+    if (order_type == ASK) {
+        user_ask_.insert(limit_order);
+    } else if (order_type == BID) {
+        user_bid_.insert(limit_order);
+    } else {
+        throw std::runtime_error("BookOverlay::AddUserLimitOrder - Incorrect order_type.");
+    }
+    all_user_orders_[order_id] = limit_order;
+}
+
+void BookOverlay::CompleteUserMarketOrder(const uint64_t& order_id,
+                                          const uint64_t& submit_timestamp,
+                                          const OrderTypes& order_type, const uint64_t& volume) {
+    BACKTEST_ALLOCATION_SCOPE(MATCHING);
+    TMarket market_order =
+        std::make_shared<MarketOrder>(order_id, submit_timestamp, order_type, volume);
+    all_user_orders_[order_id] = market_order;
+    last_user_fills_.clear();
+    if (order_type == ASK) {
+        if (const auto* orders = historical_book_.GetLazyBid()) {
+            CompleteUserMarketOrder<TBidLimitSet>(market_order, *orders, bid_volumes_, true);
+        } else {
+            CompleteUserMarketOrder<TBidLimitSet>(market_order, historical_book_.GetBid(),
+                                                  bid_volumes_, true);
+        }
+    } else if (order_type == BID) {
+        if (const auto* orders = historical_book_.GetLazyAsk()) {
+            CompleteUserMarketOrder<TAskLimitSet>(market_order, *orders, ask_volumes_, false);
+        } else {
+            CompleteUserMarketOrder<TAskLimitSet>(market_order, historical_book_.GetAsk(),
+                                                  ask_volumes_, false);
+        }
+    } else {
+        throw std::runtime_error("BookOverlay::CompleteUserMarketOrder - Incorrect order_type.");
+    }
+    if (!market_order->IsClosed()) {
+        throw std::runtime_error("BookOverlay::CompleteUserMarketOrder - Order is too big.");
+    }
+}
+
+// the market order takes only the historical orders, like in OrderBook
+template <typename TLimitSet, typename TOrders>
+void BookOverlay::CompleteUserMarketOrder(TMarket market_order, const TOrders& orders,
+                                          TVolumes<TLimitSet>& volumes,
+                                          const bool is_buyer_maker) {
+    typename TLimitSet::key_compare comparator;
+    auto volume_it = volumes.begin();
+    for (auto it = orders.begin(); it != orders.end() && !market_order->IsClosed(); ++it) {
+        const auto& order = *it;
+        while (volume_it != volumes.end() && comparator(volume_it->first, order)) {
+            ++volume_it;
+        }
+        uint64_t historical_remaining = order->GetRemainingVolume();
+        uint64_t remaining = volume_it != volumes.end() && volume_it->first == order
+                                 ? volume_it->second
+                                 : historical_remaining;
+        if (remaining == 0) {
+            continue;
+        }
+        uint64_t transaction_volume = std::min(market_order->GetRemainingVolume(), remaining);
+        TTransaction transaction = std::make_shared<CompletedTransaction>(
+            market_order->GetSubmitTimestamp(), transaction_volume, order->GetPriceLimit(),
+            is_buyer_maker);
+        market_order->AddTransaction(transaction);
+        last_user_fills_.emplace_back(market_order, transaction);
+        SetVolume<TLimitSet>(volumes, volume_it, order, remaining - transaction_volume,
+                             historical_remaining);
+    }
+}
+
+void BookOverlay::ReserveOrderId(const uint64_t& order_id) {
+    BACKTEST_ALLOCATION_SCOPE(USER_ORDERS);
+    if (order_id >= all_user_orders_.size()) {
+        all_user_orders_.resize(order_id + 1);
+    }
+}
+
+void BookOverlay::RemoveOrder(const uint64_t& order_id) {
+    BACKTEST_ALLOCATION_SCOPE(USER_ORDERS);
+    auto order = std::static_pointer_cast<LimitOrder>(GetOrderInfo(order_id));
+    if (order->IsClosed()) {
+        return;
+    }
+    order->CancelOrder();
+    if (order->GetOrderType() == ASK) {
+        user_ask_.erase(order);
+    } else if (order->GetOrderType() == BID) {
+        user_bid_.erase(order);
+    } else {
+        throw std::runtime_error("BookOverlay::RemoveOrder - Incorrect order_type.");
+    }
+}
+
+TBase BookOverlay::GetOrderInfo(const uint64_t& order_id) const {
+    if (order_id >= all_user_orders_.size()) {
+        throw std::runtime_error(
+            "BookOverlay::GetOrderInfo - It is forbidden to request a non-existent transaction.");
+    }
+    return all_user_orders_[order_id];
+}
+
+uint64_t BookOverlay::GetOrderPosition(const uint64_t& order_id) const {
+    return GetAhead(order_id).first;
+}
+
+uint64_t BookOverlay::GetVolumeAhead(const uint64_t& order_id) const {
+    return GetAhead(order_id).second;
+}
+
+std::pair<uint64_t, uint64_t> BookOverlay::GetAhead(const uint64_t& order_id) const {
+    auto order = std::dynamic_pointer_cast<LimitOrder>(GetOrderInfo(order_id));
+    if (!order) {
+        return {-1, -1};
+    }
+    if (order->GetOrderType() == ASK) {
+        return GetAhead(user_ask_, ask_volumes_, order);
+    } else if (order->GetOrderType() == BID) {
+        return GetAhead(user_bid_, bid_volumes_, order);
+    } else {
+        throw std::runtime_error("BookOverlay::GetAhead - Incorrect order_type.");
+    }
+}
+
+template <typename TLimitSet>
+std::pair<uint64_t, uint64_t> BookOverlay::GetAhead(const TLimitSet& user_orders,
+                                                    const TVolumes<TLimitSet>& volumes,
+                                                    const TLimit& order) const {
+    auto position = user_orders.find(order);
+    if (position == user_orders.end()) {
+        return {-1, -1};
+    }
+    auto [count, volume] = historical_book_.GetAhead(order);
+    // the differences are exact modulo 2^64, the total is not negative
+    typename TLimitSet::key_compare comparator;
+    for (auto it = volumes.begin(); it != volumes.end() && comparator(it->first, order); ++it) {
+        volume += it->second - it->first->GetRemainingVolume();
+    }
+    for (auto it = user_orders.begin(); it != position; ++it) {
+        ++count;
+        volume += (*it)->GetRemainingVolume();
+    }
+    return {count, volume};
+}
+
+const TUserFillVector& BookOverlay::GetLastUserFills() const {
+    return last_user_fills_;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "level_update.h"
+#include "order.h"
+#include "orderbook.h"
+
+#include <cstdint>
+#include <map>
+#include <utility>
+
+// The user orders of an isolated account over a historical orderbook shared by all isolated
+// accounts. The account sees the historical orders of the shared book, but an order keeps a
+// remaining volume of its own once the orders of the account change what the market took from it.
+// So a snapshot or a level update is applied once to the shared book, and the overlay keeps only
+// the user orders and the volumes which differ from the shared book. The fills, the positions and
+// the volumes ahead are the same as in an orderbook of the account's own.
+class BookOverlay {
+public:
+    // the historical book has to hold no user orders and outlive the overlay
+    explicit BookOverlay(const OrderBook& historical_book);
+    // has to be called before the historical book applies the same transaction, a user order
+    // gets one fill per print of a coalesced transaction
+    void CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                   const TPrintEnds& print_ends = TPrintEnds());
+    // have to be called after the historical book is updated, the snapshot replaces the
+    // historical orders and drops the closed user orders
+    void UpdateOrderBook();
+    void UpdateLevel(const LevelUpdate& update);
+    void AddUserLimitOrder(const uint64_t& order_id, const uint64_t& submit_timestamp,
+                           const OrderTypes& order_type, const uint64_t& volume,
+                           const uint64_t& price_limit);
+    void CompleteUserMarketOrder(const uint64_t& order_id, const uint64_t& submit_timestamp,
+                                 const OrderTypes& order_type, const uint64_t& volume);
+    void ReserveOrderId(const uint64_t& order_id);
+    void RemoveOrder(const uint64_t& order_id);
+    TBase GetOrderInfo(const uint64_t& order_id) const;
+    // the same as in OrderBook, OrderBook::GetAhead of the historical book plus a walk of the
+    // user orders and the changed volumes ahead
+    uint64_t GetOrderPosition(const uint64_t& order_id) const;
+    uint64_t GetVolumeAhead(const uint64_t& order_id) const;
+    const TUserFillVector& GetLastUserFills() const;
+
+private:
+    // the remaining volumes of the historical orders which differ from the historical book
+    template <typename TLimitSet>
+    using TVolumes = std::map<TLimit, uint64_t, typename TLimitSet::key_compare>;
+    // walks the historical orders and the user orders together, the account takes the volume
+    // the same way as the historical book, which hasn't applied the transaction yet
+    template <typename TLimitSet, typename TOrders>
+    void CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                   const TPrintEnds& print_ends, const TOrders& orders,
+                                   TLimitSet& user_orders, TVolumes<TLimitSet>& volumes);
+    template <typename TLimitSet, typename TOrders>
+    void CompleteUserMarketOrder(TMarket market_order, const TOrders& orders,
+                                 TVolumes<TLimitSet>& volumes, const bool is_buyer_maker);
+    // position is the first changed volume not before the order, it is moved past the order
+    template <typename TLimitSet>
+    static void SetVolume(TVolumes<TLimitSet>& volumes,
+                          typename TVolumes<TLimitSet>::iterator& position, const TLimit& order,
+                          const uint64_t& volume, const uint64_t& historical_volume);
+    template <typename TLimitSet>
+    static void EraseLevel(const LevelUpdate& update, TVolumes<TLimitSet>& volumes);
+    template <typename TLimitSet>
+    static void EraseClosed(TLimitSet& user_orders);
+    template <typename TLimitSet>
+    std::pair<uint64_t, uint64_t> GetAhead(const TLimitSet& user_orders,
+                                           const TVolumes<TLimitSet>& volumes,
+                                           const TLimit& order) const;
+    std::pair<uint64_t, uint64_t> GetAhead(const uint64_t& order_id) const;
+    const OrderBook& historical_book_;
+    TAskLimitSet user_ask_;
+    TBidLimitSet user_bid_;
+    TVolumes<TAskLimitSet> ask_volumes_;
+    TVolumes<TBidLimitSet> bid_volumes_;
+    TBaseVector all_user_orders_;
+    TUserFillVector last_user_fills_;
+};
@@ -0,0 +1,296 @@
+#include "compact_data.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+// PackedColumn
+
+void PackedColumn::Add(const uint64_t& value) {
+    if (!is_wide_ && value > std::numeric_limits<uint32_t>::max()) {
+        wide_.assign(narrow_.begin(), narrow_.end());
+        narrow_.clear();
+        narrow_.shrink_to_fit();
+        is_wide_ = true;
+    }
+    if (is_wide_) {
+        wide_.emplace_back(value);
+    } else {
+        narrow_.emplace_back(static_cast<uint32_t>(value));
+    }
+}
+
+size_t PackedColumn::Size() const {
+    return is_wide_ ? wide_.size() : narrow_.size();
+}
+
+bool PackedColumn::IsWide() const {
+    return is_wide_;
+}
+
+size_t PackedColumn::GetMemoryUsage() const {
+    return narrow_.capacity() * sizeof(uint32_t) + wide_.capacity() * sizeof(uint64_t);
+}
+
+// PackedTimestamps
+
+void PackedTimestamps::Add(const uint64_t& timestamp) {
+    size_t position = deltas_.Size();
+    if (position % block_size == 0) {
+        bases_.emplace_back(timestamp);
+    }
+    if (position > 0 && timestamp < (*this)[position - 1]) {
+        throw std::runtime_error("PackedTimestamps::Add - Timestamps have to be sorted.");
+    }
+    deltas_.Add(timestamp - bases_.back());
+}
+
+size_t PackedTimestamps::Size() const {
+    return deltas_.Size();
+}
+
+size_t PackedTimestamps::LowerBound(const uint64_t& timestamp) const {
+    size_t from = 0, to = Size();
+    while (from < to) {
+        size_t middle = from + (to - from) / 2;
+        if ((*this)[middle] < timestamp) {
+            from = middle + 1;
+        } else {
+            to = middle;
+        }
+    }
+    return from;
+}
+
+bool PackedTimestamps::IsWide() const {
+    return deltas_.IsWide();
+}
+
+size_t PackedTimestamps::GetMemoryUsage() const {
+    return bases_.capacity() * sizeof(uint64_t) + deltas_.GetMemoryUsage();
+}
+
+// PriceScale
+
+PriceScale::PriceScale(const uint64_t& reference_price, const uint64_t& tick_size,
+                       const uint64_t& lot_size)
+    : reference_price(reference_price), tick_size(tick_size), lot_size(lot_size) {
+    if (tick_size == 0 || lot_size == 0) {
+        throw std::runtime_error(
+            "PriceScale::PriceScale - Tick and lot sizes have to be positive.");
+    }
+}
+
+PriceScale PriceScale::FromData(const std::vector<TLimitVector>& ask,
+                                const std::vector<TLimitVector>& bid,
+                                const std::vector<CompletedTransaction>& transactions) {
+    uint64_t reference_price = std::numeric_limits<uint64_t>::max();
+    auto for_each_level = [&](const auto& callback) {
+        for (const auto* side : {&ask, &bid}) {
+            for (const auto& orders : *side) {
+                for (const auto& order : orders) {
+                    callback(order->GetPriceLimit(), order->GetVolume());
+                }
+            }
+        }
+        for (const auto& transaction : transactions) {
+            callback(transaction.GetPrice(), transaction.GetVolume());
+        }
+    };
+    for_each_level([&](const uint64_t& price, const uint64_t& /*volume*/) {
+        reference_price = std::min(reference_price, price);
+    });
+    if (reference_price == std::numeric_limits<uint64_t>::max()) {
+        return PriceScale();
+    }
+    uint64_t tick_size = 0, lot_size = 0;
+    for_each_level([&](const uint64_t& price, const uint64_t& volume) {
+        tick_size = std::gcd(tick_size, price - reference_price);
+        lot_size = std::gcd(lot_size, volume);
+    });
+    return PriceScale(reference_price, std::max<uint64_t>(tick_size, 1),
+                      std::max<uint64_t>(lot_size, 1));
+}
+
+void PriceScale::Print(bool print_name) const {
+    if (print_name) {
+        std::cerr << "PriceScale:" << std::endl;
+    }
+    std::cerr << "reference_price = " << reference_price << " tick_size = " << tick_size
+              << " lot_size = " << lot_size << std::endl;
+}
+
+// CompactSnapshots
+
+CompactSnapshots::CompactSnapshots(const std::vector<TLimitVector>& ask,
+                                   const std::vector<TLimitVector>& bid,
+                                   const PriceScale& scale)
+    : scale_(scale) {
+    if (ask.size() != bid.size()) {
+        throw std::runtime_error(
+            "CompactSnapshots::CompactSnapshots - Ask and bid have different sizes.");
+    }
+    ask_.begins.Add(0);
+    bid_.begins.Add(0);
+    for (size_t row = 0; row < ask.size(); ++row) {
+        if (ask[row].empty() && bid[row].empty()) {
+            throw std::runtime_error("CompactSnapshots::CompactSnapshots - Empty snapshot.");
+        }
+        timestamps_.Add(ask[row].empty() ? bid[row][0]->GetSubmitTimestamp()
+                                         : ask[row][0]->GetSubmitTimestamp());
+        AddSide(ask[row], ask_);
+        AddSide(bid[row], bid_);
+    }
+}
+
+size_t CompactSnapshots::Size() const {
+    return timestamps_.Size();
+}
+
+uint64_t CompactSnapshots::GetTimestamp(const size_t& row) const {
+    return timestamps_[row];
+}
+
+void CompactSnapshots::GetAsk(const size_t& row,
+                              std::vector<std::pair<uint64_t, uint64_t>>& levels) const {
+    GetLevels(ask_, row, levels);
+}
+
+void CompactSnapshots::GetBid(const size_t& row,
+                              std::vector<std::pair<uint64_t, uint64_t>>& levels) const {
+    GetLevels(bid_, row, levels);
+}
+
+TLimitVector CompactSnapshots::DecodeAsk(const size_t& row) const {
+    return Decode(ask_, ASK, row);
+}
+
+TLimitVector CompactSnapshots::DecodeBid(const size_t& row) const {
+    return Decode(bid_, BID, row);
+}
+
+bool CompactSnapshots::IsWide() const {
+    for (const auto* side : {&ask_, &bid_}) {
+        if (side->begins.IsWide() || side->prices.IsWide() || side->volumes.IsWide()) {
+            return true;
+        }
+    }
+    return timestamps_.IsWide();
+}
+
+size_t CompactSnapshots::GetMemoryUsage() const {
+    size_t usage = timestamps_.GetMemoryUsage();
+    for (const auto* side : {&ask_, &bid_}) {
+        usage += side->begins.GetMemoryUsage() + side->prices.GetMemoryUsage() +
+                 side->volumes.GetMemoryUsage();
+    }
+    return usage;
+}
+
+void CompactSnapshots::AddSide(const TLimitVector& orders, Side& side) {
+    for (const auto& order : orders) {
+        if (order->GetPriceLimit() < scale_.reference_price ||
+            (order->GetPriceLimit() - scale_.reference_price) % scale_.tick_size != 0 ||
+            order->GetVolume() % scale_.lot_size != 0) {
+            throw std::runtime_error(
+                "CompactSnapshots::AddSide - The order doesn't fit the price scale.");
+        }
+        side.prices.Add((order->GetPriceLimit() - scale_.reference_price) / scale_.tick_size);
+        side.volumes.Add(order->GetVolume() / scale_.lot_size);
+    }
+    side.begins.Add(side.prices.Size());
+}
+
+void CompactSnapshots::GetLevels(const Side& side, const size_t& row,
+                                 std::vector<std::pair<uint64_t, uint64_t>>& levels) const {
+    levels.clear();
+    for (size_t i = side.begins[row]; i < side.begins[row + 1]; ++i) {
+        levels.emplace_back(scale_.reference_price + side.prices[i] * scale_.tick_size,
+                            side.volumes[i] * scale_.lot_size);
+    }
+}
+
+TLimitVector CompactSnapshots::Decode(const Side& side, const OrderTypes& order_type,
+                                      const size_t& row) const {
+    TLimitVector orders;
+    for (size_t i = side.begins[row]; i < side.begins[row + 1]; ++i) {
+        orders.emplace_back(std::make_shared<LimitOrder>(
+            -1, timestamps_[row], order_type, side.volumes[i] * scale_.lot_size,
+            scale_.reference_price + side.prices[i] * scale_.tick_size));
+    }
+    return orders;
+}
+
+// CompactTransactions
+
+CompactTransactions::CompactTransactions(const std::vector<CompletedTransaction>& transactions,
+                                         const PriceScale& scale)
+    : scale_(scale) {
+    for (const auto& transaction : transactions) {
+        if (transaction.GetPrice() < scale_.reference_price ||
+            (transaction.GetPrice() - scale_.reference_price) % scale_.tick_size != 0 ||
+            transaction.GetVolume() % scale_.lot_size != 0) {
+            throw std::runtime_error(
+                "CompactTransactions::CompactTransactions - The transaction doesn't fit the "
+                "price scale.");
+        }
+        timestamps_.Add(transaction.GetTransactionTimestamp());
+        prices_.Add((transaction.GetPrice() - scale_.reference_price) / scale_.tick_size);
+        volumes_.Add(transaction.GetVolume() / scale_.lot_size);
+        is_buyer_maker_.emplace_back(transaction.GetIsBuyerMaker());
+    }
+}
+
+size_t CompactTransactions::Size() const {
+    return timestamps_.Size();
+}
+
+uint64_t CompactTransactions::GetTimestamp(const size_t& position) const {
+    return timestamps_[position];
+}
+
+CompletedTransaction CompactTransactions::Get(const size_t& position) const {
+    return CompletedTransaction(timestamps_[position], volumes_[position] * scale_.lot_size,
+                                scale_.reference_price + prices_[position] * scale_.tick_size,
+                                is_buyer_maker_[position]);
+}
+
+size_t CompactTransactions::LowerBound(const uint64_t& timestamp) const {
+    return timestamps_.LowerBound(timestamp);
+}
+
+bool CompactTransactions::IsWide() const {
+    return timestamps_.IsWide() || prices_.IsWide() || volumes_.IsWide();
+}
+
+size_t CompactTransactions::GetMemoryUsage() const {
+    return timestamps_.GetMemoryUsage() + prices_.GetMemoryUsage() +
+           volumes_.GetMemoryUsage() + is_buyer_maker_.capacity() / 8;
+}
+
+// CompactDataset
+
+CompactDataset::CompactDataset(const Scanner& scanner)
+    : scale_(PriceScale::FromData(scanner.GetAsk(), scanner.GetBid(),
+                                  scanner.GetTransactions())),
+      snapshots_(scanner.GetAsk(), scanner.GetBid(), scale_),
+      transactions_(scanner.GetTransactions(), scale_) {
+}
+
+const PriceScale& CompactDataset::GetScale() const {
+    return scale_;
+}
+
+const CompactSnapshots& CompactDataset::GetSnapshots() const {
+    return snapshots_;
+}
+
+const CompactTransactions& CompactDataset::GetTransactions() const {
+    return transactions_;
+}
+
+size_t CompactDataset::GetMemoryUsage() const {
+    return snapshots_.GetMemoryUsage() + transactions_.GetMemoryUsage();
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "completed_transaction.h"
+#include "order.h"
+#include "scanner.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// A read-only copy of the historical data in a fraction of the memory of the parsed rows.
+// Prices are stored as 32-bit numbers of ticks above a reference price of the dataset, volumes as
+// 32-bit numbers of lots and timestamps as 32-bit deltas from the first timestamp of their block.
+// A column which gets a value that doesn't fit into 32 bits is widened to 64 bits, so the decoded
+// data is always exactly the parsed one. Only the resident dataset of FeatureExporter and
+// ReplayBook is stored this way: BackTest streams the parsed rows through the bounded queues of
+// Prefetcher, and its OrderBook holds the 64-bit LimitOrder objects the strategies read.
+
+// a column of numbers, 32-bit until a value needs more
+class PackedColumn {
+public:
+    PackedColumn() = default;
+    void Add(const uint64_t& value);
+    uint64_t operator[](const size_t& position) const {
+        return is_wide_ ? wide_[position] : narrow_[position];
+    }
+    size_t Size() const;
+    bool IsWide() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    std::vector<uint32_t> narrow_;
+    std::vector<uint64_t> wide_;
+    bool is_wide_ = false;
+};
+
+// increasing timestamps in blocks of block_size with a 64-bit base per block
+class PackedTimestamps {
+public:
+    static const size_t block_size = 256;
+    PackedTimestamps() = default;
+    void Add(const uint64_t& timestamp);
+    uint64_t operator[](const size_t& position) const {
+        return bases_[position / block_size] + deltas_[position];
+    }
+    size_t Size() const;
+    // the first position with a timestamp not less than the given one
+    size_t LowerBound(const uint64_t& timestamp) const;
+    bool IsWide() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    std::vector<uint64_t> bases_;
+    PackedColumn deltas_;
+};
+
+// price = reference_price + ticks * tick_size, volume = lots * lot_size
+struct PriceScale {
+    uint64_t reference_price;
+    uint64_t tick_size;
+    uint64_t lot_size;
+    PriceScale(const uint64_t& reference_price = 0, const uint64_t& tick_size = 1,
+               const uint64_t& lot_size = 1);
+    // the lowest price, the greatest common divisors of the price differences and of the volumes
+    static PriceScale FromData(const std::vector<TLimitVector>& ask,
+                               const std::vector<TLimitVector>& bid,
+                               const std::vector<CompletedTransaction>& transactions);
+    void Print(bool print_name = true) const;
+};
+
+// the levels of every snapshot in the order of the file
+class CompactSnapshots {
+public:
+    CompactSnapshots(const std::vector<TLimitVector>& ask, const std::vector<TLimitVector>& bid,
+                     const PriceScale& scale);
+    size_t Size() const;
+    uint64_t GetTimestamp(const size_t& row) const;
+    // replace levels with the (price, volume) pairs of a side of the snapshot
+    void GetAsk(const size_t& row, std::vector<std::pair<uint64_t, uint64_t>>& levels) const;
+    void GetBid(const size_t& row, std::vector<std::pair<uint64_t, uint64_t>>& levels) const;
+    // allocates the orders the way Scanner does
+    TLimitVector DecodeAsk(const size_t& row) const;
+    TLimitVector DecodeBid(const size_t& row) const;
+    bool IsWide() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Side {
+        // levels of the row are [begins[row], begins[row + 1])
+        PackedColumn begins, prices, volumes;
+    };
+    void AddSide(const TLimitVector& orders, Side& side);
+    void GetLevels(const Side& side, const size_t& row,
+                   std::vector<std::pair<uint64_t, uint64_t>>& levels) const;
+    TLimitVector Decode(const Side& side, const OrderTypes& order_type, const size_t& row) const;
+    PriceScale scale_;
+    PackedTimestamps timestamps_;
+    Side ask_, bid_;
+};
+
+class CompactTransactions {
+public:
+    CompactTransactions(const std::vector<CompletedTransaction>& transactions,
+                        const PriceScale& scale);
+    size_t Size() const;
+    uint64_t GetTimestamp(const size_t& position) const;
+    CompletedTransaction Get(const size_t& position) const;
+    size_t LowerBound(const uint64_t& timestamp) const;
+    bool IsWide() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    PriceScale scale_;
+    PackedTimestamps timestamps_;
+    PackedColumn prices_, volumes_;
+    std::vector<bool> is_buyer_maker_;
+};
+
+class CompactDataset {
+public:
+    // the scanner is only read by the constructor
+    explicit CompactDataset(const Scanner& scanner);
+    const PriceScale& GetScale() const;
+    const CompactSnapshots& GetSnapshots() const;
+    const CompactTransactions& GetTransactions() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    PriceScale scale_;
+    CompactSnapshots snapshots_;
+    CompactTransactions transactions_;
+};
@@ -1,5 +1,6 @@
 #include "completed_transaction.h"
 
+#include <algorithm>
 #include <iostream>
 
 // CompletedTransaction
@@ -41,3 +42,12 @@ void CompletedTransaction::Print(bool print_name) const {
               << " volume = " << GetVolume() << " price = " << GetPrice()
               << " is_buyer_maker = " << GetIsBuyerMaker() << std::endl;
 }
+
+uint64_t GetPrintPart(const TPrintEnds& print_ends, const uint64_t& offset,
+                      const uint64_t& volume) {
+    auto print_end = std::upper_bound(print_ends.begin(), print_ends.end(), offset);
+    if (print_end == print_ends.end()) {
+        return volume;
+    }
+    return std::min(volume, *print_end - offset);
+}
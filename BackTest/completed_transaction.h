@@ -24,3 +24,13 @@ private:
 
 using TTransaction = std::shared_ptr<CompletedTransaction>;
 using TTransactionVector = std::vector<TTransaction>;
+
+// The ends of the prints a coalesced transaction was merged from, as offsets in its volume, see
+// Prefetcher::SetTradeCoalescing. Empty for a transaction which wasn't coalesced.
+using TPrintEnds = std::vector<uint64_t>;
+
+// the volume of the part of a coalesced transaction from offset on which belongs to one print, at
+// most volume. A walk of the orderbook takes the merged volume in the order of the prints, so the
+// volume an order takes split this way gives the same fills as the prints one by one
+uint64_t GetPrintPart(const TPrintEnds& print_ends, const uint64_t& offset,
+                      const uint64_t& volume);
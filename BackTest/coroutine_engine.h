@@ -0,0 +1,315 @@
+#pragma once
+
+#ifndef BACKTEST_COROUTINES
+#error "coroutine_engine.h needs the C++20 build: cmake -DBACKTEST_COROUTINES=ON"
+#endif
+
+#include "backtest.h"
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Strategies written as coroutines over BasicBackTest. A strategy co_awaits the conditions it
+// needs and CoroutineEngine::Run resumes it at the simulation time the condition fires: the
+// replay jumps straight to the next timer, or steps from event to event while a coroutine waits
+// for a trade or a fill, so no time is simulated just to poll the engine.
+//
+//     StrategyTask JoinBid(CoroutineEngine<>& engine) {
+//         auto& backtest = engine.GetBackTest();
+//         while (true) {
+//             co_await engine.CanCall();
+//             auto order_id = backtest.SendLimitOrder(BID, 1000, backtest.GetBestBid());
+//             co_await engine.Fill(*order_id);
+//         }
+//     }
+//
+// A coroutine resumed by a trade, a fill or a cancel runs inside the event loop like the
+// BaseStrategy hooks, an exception thrown by a coroutine leaves Run.
+
+// A coroutine which can be spawned on the engine or co_awaited by another one.
+class StrategyTask {
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation;
+        StrategyTask get_return_object() {
+            return StrategyTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() noexcept {
+                    return false;
+                }
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<promise_type> handle) noexcept {
+                    auto continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() noexcept {
+                }
+            };
+            return FinalAwaiter();
+        }
+        void return_void() {
+        }
+        void unhandled_exception() {
+            throw;
+        }
+    };
+
+    explicit StrategyTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+    }
+    StrategyTask(StrategyTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {
+    }
+    StrategyTask& operator=(StrategyTask&& other) noexcept {
+        if (this != &other) {
+            Destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~StrategyTask() {
+        Destroy();
+    }
+    bool IsDone() const {
+        return !handle_ || handle_.done();
+    }
+    // the task starts when the engine spawns it or when it is co_awaited
+    void Start() {
+        handle_.resume();
+    }
+
+    bool await_ready() const noexcept {
+        return IsDone();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+        handle_.promise().continuation = continuation;
+        return handle_;
+    }
+    void await_resume() const noexcept {
+    }
+
+private:
+    void Destroy() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename TBackTest = BackTest>
+class CoroutineEngine {
+public:
+    explicit CoroutineEngine(TBackTest& backtest) : backtest_(backtest), next_sequence_(0) {
+    }
+    CoroutineEngine(const CoroutineEngine&) = delete;
+    CoroutineEngine& operator=(const CoroutineEngine&) = delete;
+
+    TBackTest& GetBackTest() {
+        return backtest_;
+    }
+    // runs the task until its first co_await, the engine owns it until it is destroyed
+    void Spawn(StrategyTask task) {
+        tasks_.emplace_back(std::move(task));
+        tasks_.back().Start();
+    }
+    // replays the market until end_timestamp resuming the coroutines
+    uint64_t Run(const uint64_t& end_timestamp);
+
+    struct SleepAwaiter {
+        CoroutineEngine* engine;
+        uint64_t wake_timestamp;
+        bool await_ready() const {
+            return wake_timestamp <= engine->backtest_.GetCurrentTimestamp();
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            engine->AddTimer(wake_timestamp, handle, false);
+        }
+        void await_resume() const {
+        }
+    };
+    // resumes after milliseconds of the simulation time
+    SleepAwaiter Sleep(const uint64_t& milliseconds) {
+        return {this, backtest_.GetCurrentTimestamp() + milliseconds};
+    }
+
+    struct CallAwaiter {
+        CoroutineEngine* engine;
+        bool await_ready() const {
+            return engine->CanCallNow();
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            engine->AddTimer(engine->GetCallTimestamp(), handle, true);
+        }
+        void await_resume() const {
+        }
+    };
+    // resumes when the engine accepts the next order or withdraw
+    CallAwaiter CanCall() {
+        return {this};
+    }
+
+    struct TradeAwaiter {
+        CoroutineEngine* engine;
+        std::optional<CompletedTransaction> transaction;
+        bool await_ready() const {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            engine->trade_waiters_.emplace_back(handle, this);
+        }
+        CompletedTransaction await_resume() const {
+            return *transaction;
+        }
+    };
+    // resumes at the next historical market transaction
+    TradeAwaiter NextTrade() {
+        return {this, std::nullopt};
+    }
+
+    struct FillAwaiter {
+        CoroutineEngine* engine;
+        uint64_t order_id;
+        std::optional<CompletedTransaction> transaction;
+        bool await_ready() const {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            engine->fill_waiters_.emplace(order_id, std::make_pair(handle, this));
+        }
+        // nullopt if the order was withdrawn instead
+        std::optional<CompletedTransaction> await_resume() const {
+            return transaction;
+        }
+    };
+    // resumes at the next fill of the order or when its withdraw reaches the orderbook
+    FillAwaiter Fill(const uint64_t& order_id) {
+        return {this, order_id, std::nullopt};
+    }
+
+    // BasicBackTest hooks
+    void OnBookUpdate(TBackTest& /*backtest*/) {
+    }
+    void OnLevelUpdate(TBackTest& /*backtest*/, const LevelUpdate& /*update*/) {
+    }
+    void OnTrade(TBackTest& /*backtest*/, const CompletedTransaction& transaction);
+    void OnFill(TBackTest& /*backtest*/, const BaseOrder& order,
+                const CompletedTransaction& transaction);
+    void OnOrderAck(TBackTest& /*backtest*/, const uint64_t& /*order_id*/) {
+    }
+    void OnCancelAck(TBackTest& /*backtest*/, const uint64_t& order_id);
+    void OnTimer(TBackTest& /*backtest*/) {
+    }
+
+private:
+    struct Timer {
+        uint64_t wake_timestamp;
+        uint64_t sequence;
+        std::coroutine_handle<> handle;
+        // is rescheduled if another coroutine made a call at the same time
+        bool is_call;
+        bool operator>(const Timer& other) const {
+            return std::tie(wake_timestamp, sequence) >
+                   std::tie(other.wake_timestamp, other.sequence);
+        }
+    };
+    bool CanCallNow() const {
+        return GetCallTimestamp() <= backtest_.GetCurrentTimestamp();
+    }
+    uint64_t GetCallTimestamp() const {
+        return backtest_.GetLastCall() + backtest_.GetCallFrequency();
+    }
+    void AddTimer(const uint64_t& wake_timestamp, std::coroutine_handle<> handle,
+                  const bool& is_call) {
+        timers_.push({wake_timestamp, next_sequence_++, handle, is_call});
+    }
+    void ResumeFills(const uint64_t& order_id,
+                     const std::optional<CompletedTransaction>& transaction);
+
+    TBackTest& backtest_;
+    uint64_t next_sequence_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::vector<std::pair<std::coroutine_handle<>, TradeAwaiter*>> trade_waiters_;
+    std::unordered_multimap<uint64_t, std::pair<std::coroutine_handle<>, FillAwaiter*>>
+        fill_waiters_;
+    // the last member, so the suspended coroutines are destroyed first
+    std::vector<StrategyTask> tasks_;
+};
+
+// CoroutineEngine
+
+template <typename TBackTest>
+uint64_t CoroutineEngine<TBackTest>::Run(const uint64_t& end_timestamp) {
+    while (backtest_.GetCurrentTimestamp() < end_timestamp) {
+        uint64_t next_timestamp = end_timestamp;
+        if (!timers_.empty()) {
+            next_timestamp = std::min(next_timestamp, timers_.top().wake_timestamp);
+        }
+        // only the coroutines waiting for events need the replay to stop at every event
+        if (!trade_waiters_.empty() || !fill_waiters_.empty()) {
+            next_timestamp = std::min(next_timestamp, backtest_.GetNextEventTimestamp());
+        }
+        next_timestamp = std::max(next_timestamp, backtest_.GetCurrentTimestamp());
+        backtest_.ProcessTimeInterval(next_timestamp - backtest_.GetCurrentTimestamp(), *this);
+        while (!timers_.empty() &&
+               timers_.top().wake_timestamp <= backtest_.GetCurrentTimestamp()) {
+            auto timer = timers_.top();
+            timers_.pop();
+            if (timer.is_call && !CanCallNow()) {
+                AddTimer(GetCallTimestamp(), timer.handle, true);
+                continue;
+            }
+            timer.handle.resume();
+        }
+    }
+    return backtest_.GetCurrentTimestamp();
+}
+
+template <typename TBackTest>
+void CoroutineEngine<TBackTest>::OnTrade(TBackTest& /*backtest*/,
+                                         const CompletedTransaction& transaction) {
+    // the resumed coroutines wait for the trades after this one
+    auto waiters = std::move(trade_waiters_);
+    trade_waiters_.clear();
+    for (auto& [handle, awaiter] : waiters) {
+        awaiter->transaction = transaction;
+        handle.resume();
+    }
+}
+
+template <typename TBackTest>
+void CoroutineEngine<TBackTest>::OnFill(TBackTest& /*backtest*/, const BaseOrder& order,
+                                        const CompletedTransaction& transaction) {
+    ResumeFills(order.GetOrderId(), transaction);
+}
+
+template <typename TBackTest>
+void CoroutineEngine<TBackTest>::OnCancelAck(TBackTest& /*backtest*/, const uint64_t& order_id) {
+    ResumeFills(order_id, std::nullopt);
+}
+
+template <typename TBackTest>
+void CoroutineEngine<TBackTest>::ResumeFills(
+    const uint64_t& order_id, const std::optional<CompletedTransaction>& transaction) {
+    auto [begin, end] = fill_waiters_.equal_range(order_id);
+    std::vector<std::pair<std::coroutine_handle<>, FillAwaiter*>> waiters;
+    for (auto it = begin; it != end; ++it) {
+        waiters.emplace_back(it->second);
+    }
+    fill_waiters_.erase(begin, end);
+    for (auto& [handle, awaiter] : waiters) {
+        awaiter->transaction = transaction;
+        handle.resume();
+    }
+}
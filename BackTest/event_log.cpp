@@ -0,0 +1,186 @@
+#include "event_log.h"
+
+#include "order.h"
+
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+static_assert(sizeof(LogRecord) == 48, "LogRecord is written to the file as it is.");
+
+std::atomic<bool> event_log_open(false);
+std::atomic<uint32_t> event_log_threads(0);
+// a buffer filled while another log was open is dropped
+std::atomic<uint64_t> event_log_generation(0);
+std::mutex event_log_mutex;
+std::ofstream event_log_out;
+
+// the records of one thread, written into the file when the buffer is full or the thread exits
+class ThreadLogBuffer {
+public:
+    ThreadLogBuffer() : records_(), generation_(0), thread_(event_log_threads++) {
+        records_.reserve(capacity_);
+    }
+
+    ~ThreadLogBuffer() {
+        Flush();
+    }
+
+    void Append(const LogEvents& event, const uint64_t& timestamp,
+                std::initializer_list<uint64_t> fields) {
+        if (records_.size() == capacity_) {
+            Flush();
+        }
+        if (records_.empty()) {
+            generation_ = event_log_generation.load();
+        }
+        LogRecord& record = records_.emplace_back();
+        record.timestamp = timestamp;
+        record.event = event;
+        record.thread = thread_;
+        size_t i = 0;
+        for (auto field : fields) {
+            if (i == 4) {
+                break;
+            }
+            record.fields[i++] = field;
+        }
+        for (; i < 4; ++i) {
+            record.fields[i] = 0;
+        }
+    }
+
+    void Flush() {
+        if (records_.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(event_log_mutex);
+            if (event_log_out.is_open() && generation_ == event_log_generation.load()) {
+                event_log_out.write(reinterpret_cast<const char*>(records_.data()),
+                                    records_.size() * sizeof(LogRecord));
+            }
+        }
+        records_.clear();
+    }
+
+private:
+    static const size_t capacity_ = 4096;
+    std::vector<LogRecord> records_;
+    uint64_t generation_;
+    uint32_t thread_;
+};
+
+ThreadLogBuffer& GetThreadLogBuffer() {
+    thread_local ThreadLogBuffer buffer;
+    return buffer;
+}
+
+// LogEvents
+
+std::string ToString(const LogEvents& event) {
+    switch (event) {
+        case LOG_BOOK_UPDATE:
+            return "book_update";
+        case LOG_MARKET_TRADE:
+            return "market_trade";
+        case LOG_ORDER_SUBMIT:
+            return "order_submit";
+        case LOG_ORDER_ACK:
+            return "order_ack";
+        case LOG_CANCEL_REQUEST:
+            return "cancel_request";
+        case LOG_CANCEL_ACK:
+            return "cancel_ack";
+        case LOG_FILL:
+            return "fill";
+        case LOG_LEVEL_UPDATE:
+            return "level_update";
+        case LOG_EVENTS_COUNT:
+            break;
+    }
+    throw std::runtime_error("ToString - Incorrect log event.");
+}
+
+// event log
+
+void OpenEventLog(const std::string& path) {
+    std::lock_guard<std::mutex> lock(event_log_mutex);
+    if (event_log_out.is_open()) {
+        throw std::runtime_error("OpenEventLog - The event log is already open.");
+    }
+    event_log_out.open(path, std::ios::binary | std::ios::trunc);
+    if (!event_log_out.is_open()) {
+        throw std::runtime_error("OpenEventLog - Failed to open the log file.");
+    }
+    event_log_out.write("BTLOG001", 8);
+    ++event_log_generation;
+    event_log_open = true;
+}
+
+void CloseEventLog() {
+    if (!IsEventLogOpen()) {
+        return;
+    }
+    GetThreadLogBuffer().Flush();
+    std::lock_guard<std::mutex> lock(event_log_mutex);
+    event_log_open = false;
+    ++event_log_generation;
+    event_log_out.close();
+    if (!event_log_out) {
+        throw std::runtime_error("CloseEventLog - Failed to write the log file.");
+    }
+}
+
+void FlushEventLog() {
+    GetThreadLogBuffer().Flush();
+}
+
+void AppendEventLog(const LogEvents& event, const uint64_t& timestamp,
+                    std::initializer_list<uint64_t> fields) {
+    GetThreadLogBuffer().Append(event, timestamp, fields);
+}
+
+std::vector<LogRecord> ReadEventLog(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[8];
+    if (!in.read(magic, sizeof(magic)) || std::string(magic, sizeof(magic)) != "BTLOG001") {
+        throw std::runtime_error("ReadEventLog - The file isn't an event log.");
+    }
+    std::vector<LogRecord> records;
+    LogRecord record;
+    while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        if (record.event >= static_cast<uint32_t>(LOG_EVENTS_COUNT)) {
+            throw std::runtime_error("ReadEventLog - Incorrect event of a record.");
+        }
+        records.emplace_back(record);
+    }
+    if (in.gcount() != 0) {
+        throw std::runtime_error("ReadEventLog - The last record is truncated.");
+    }
+    return records;
+}
+
+std::string Format(const LogRecord& record) {
+    static const std::vector<std::vector<std::string>> field_names = {
+        {"best_ask", "best_bid", "ask_levels", "bid_levels"},
+        {"price", "volume", "is_buyer_maker", "user_fills"},
+        {"order_id", "order_type", "volume", "price_limit"},
+        {"order_id", "order_type", "volume", "price_limit"},
+        {"order_id"},
+        {"order_id"},
+        {"order_id", "order_type", "price", "volume"},
+        {"order_type", "price", "volume"}};
+    auto event = static_cast<LogEvents>(record.event);
+    std::string line = std::to_string(record.timestamp) + " thread=" +
+                       std::to_string(record.thread) + ' ' + ToString(event);
+    for (size_t i = 0; i < field_names[event].size(); ++i) {
+        line += ' ' + field_names[event][i] + '=';
+        if (field_names[event][i] == "order_type") {
+            line += ToString(static_cast<OrderTypes>(record.fields[i]));
+        } else {
+            line += std::to_string(record.fields[i]);
+        }
+    }
+    return line;
+}
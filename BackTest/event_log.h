@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Records the engine events into a binary log instead of formatting them. A record is copied into
+// a buffer of its thread, the buffer is appended to the file under a mutex only when it is full,
+// so a record costs a few nanoseconds. The arguments of BACKTEST_LOG are evaluated only while a
+// log is open. Use event-log-decoder to render a log as text.
+#define BACKTEST_LOG(event, timestamp, ...)                      \
+    do {                                                         \
+        if (IsEventLogOpen()) {                                  \
+            AppendEventLog((event), (timestamp), {__VA_ARGS__}); \
+        }                                                        \
+    } while (false)
+
+enum LogEvents {
+    LOG_BOOK_UPDATE,     // best ask, best bid, ask levels, bid levels after the snapshot
+    LOG_MARKET_TRADE,    // price, volume, is buyer maker, number of user fills
+    // the order events are in the order of OrderEvents
+    LOG_ORDER_SUBMIT,    // order id, order type, volume, price limit
+    LOG_ORDER_ACK,       // order id, order type, volume, price limit
+    LOG_CANCEL_REQUEST,  // order id
+    LOG_CANCEL_ACK,      // order id
+    LOG_FILL,            // order id, order type, price, volume
+    LOG_LEVEL_UPDATE,    // order type, price, volume of the level
+    LOG_EVENTS_COUNT
+};
+
+std::string ToString(const LogEvents& event);
+
+// time in ms of the simulation
+struct LogRecord {
+    uint64_t timestamp;
+    uint32_t event;
+    // small number of the thread in the order of their first record
+    uint32_t thread;
+    uint64_t fields[4];
+};
+
+extern std::atomic<bool> event_log_open;
+
+inline bool IsEventLogOpen() {
+    return event_log_open.load(std::memory_order_relaxed);
+}
+
+void OpenEventLog(const std::string& path);
+// writes the buffer of the calling thread and closes the file, the other threads have to stop
+// logging before, their buffers are written when they are full or the thread exits
+void CloseEventLog();
+// writes the buffer of the calling thread
+void FlushEventLog();
+void AppendEventLog(const LogEvents& event, const uint64_t& timestamp,
+                    std::initializer_list<uint64_t> fields);
+
+std::vector<LogRecord> ReadEventLog(const std::string& path);
+// one line with the names of the fields
+std::string Format(const LogRecord& record);
@@ -0,0 +1,93 @@
+#include "execution_models.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// RequestLatency
+
+RequestLatency::RequestLatency(const uint64_t& limit_order_latency,
+                               const uint64_t& market_order_latency,
+                               const uint64_t& cancel_latency)
+    : limit_order_latency_(limit_order_latency),
+      market_order_latency_(market_order_latency),
+      cancel_latency_(cancel_latency) {
+}
+
+uint64_t RequestLatency::GetMaxPostLatency() const {
+    return std::max(limit_order_latency_, market_order_latency_);
+}
+
+uint64_t RequestLatency::GetMaxCancelLatency() const {
+    return cancel_latency_;
+}
+
+// SampledLatency
+
+SampledLatency::SampledLatency(const std::vector<uint64_t>& samples, const uint64_t& seed)
+    : samples_(samples), max_sample_(0), rnd_(seed) {
+    if (samples_.empty()) {
+        throw std::runtime_error("SampledLatency::SampledLatency - There have to be samples.");
+    }
+    max_sample_ = *std::max_element(samples_.begin(), samples_.end());
+}
+
+uint64_t SampledLatency::GetLimitOrderLatency(const OrderTypes& /*order_type*/) {
+    return Sample();
+}
+
+uint64_t SampledLatency::GetMarketOrderLatency(const OrderTypes& /*order_type*/) {
+    return Sample();
+}
+
+uint64_t SampledLatency::GetCancelLatency() {
+    return Sample();
+}
+
+uint64_t SampledLatency::GetMaxPostLatency() const {
+    return max_sample_;
+}
+
+uint64_t SampledLatency::GetMaxCancelLatency() const {
+    return max_sample_;
+}
+
+uint64_t SampledLatency::Sample() {
+    return samples_[std::uniform_int_distribution<size_t>(0, samples_.size() - 1)(rnd_)];
+}
+
+// MakerTakerFee
+
+uint64_t MakerTakerFee::GetMakerFee() const {
+    return maker_fee_;
+}
+
+uint64_t MakerTakerFee::GetTakerFee() const {
+    return taker_fee_;
+}
+
+// TieredFee
+
+TieredFee::TieredFee(const std::vector<FeeTier>& tiers)
+    : tiers_(tiers), tier_(0), traded_volume_(0) {
+    if (tiers_.empty() || tiers_[0].min_volume != 0) {
+        throw std::runtime_error("TieredFee::TieredFee - The first tier has to start from 0.");
+    }
+    for (size_t i = 1; i < tiers_.size(); ++i) {
+        if (tiers_[i - 1].min_volume >= tiers_[i].min_volume) {
+            throw std::runtime_error("TieredFee::TieredFee - Tiers have to be sorted.");
+        }
+    }
+}
+
+uint64_t TieredFee::GetFee(const Liquidity& liquidity, const BaseOrder& /*order*/,
+                           const CompletedTransaction& transaction) {
+    while (tier_ + 1 < tiers_.size() && tiers_[tier_ + 1].min_volume <= traded_volume_) {
+        ++tier_;
+    }
+    traded_volume_ += transaction.GetVolume();
+    return liquidity == MAKER ? tiers_[tier_].maker_fee : tiers_[tier_].taker_fee;
+}
+
+uint64_t TieredFee::GetTradedVolume() const {
+    return traded_volume_;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "completed_transaction.h"
+#include "order.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Latency and fee models are the policy types of BasicBackTest. They are called directly, so the
+// constant ones are inlined into the replay and cost the same as plain fields.
+//
+// A latency model provides
+//     uint64_t GetLimitOrderLatency(const OrderTypes& order_type);
+//     uint64_t GetMarketOrderLatency(const OrderTypes& order_type);
+//     uint64_t GetCancelLatency();
+//     uint64_t GetMaxPostLatency() const;
+//     uint64_t GetMaxCancelLatency() const;
+// and a fee model
+//     uint64_t GetFee(const Liquidity& liquidity, const BaseOrder& order,
+//                     const CompletedTransaction& transaction);
+// which is called once per fill in the order of the fills.
+
+// time in ms, fees are in 1 / 10^4 of the traded cash
+
+enum Liquidity {
+    MAKER,  // a limit order filled by a market transaction
+    TAKER   // a market order
+};
+
+class ConstantLatency {
+public:
+    explicit ConstantLatency(const uint64_t& post_latency = 100,
+                             const uint64_t& cancel_latency = 100)
+        : post_latency_(post_latency), cancel_latency_(cancel_latency) {
+    }
+    uint64_t GetLimitOrderLatency(const OrderTypes& /*order_type*/) const {
+        return post_latency_;
+    }
+    uint64_t GetMarketOrderLatency(const OrderTypes& /*order_type*/) const {
+        return post_latency_;
+    }
+    uint64_t GetCancelLatency() const {
+        return cancel_latency_;
+    }
+    uint64_t GetMaxPostLatency() const {
+        return post_latency_;
+    }
+    uint64_t GetMaxCancelLatency() const {
+        return cancel_latency_;
+    }
+
+private:
+    uint64_t post_latency_;
+    uint64_t cancel_latency_;
+};
+
+// a constant latency for every kind of request
+class RequestLatency {
+public:
+    RequestLatency(const uint64_t& limit_order_latency, const uint64_t& market_order_latency,
+                   const uint64_t& cancel_latency);
+    uint64_t GetLimitOrderLatency(const OrderTypes& /*order_type*/) const {
+        return limit_order_latency_;
+    }
+    uint64_t GetMarketOrderLatency(const OrderTypes& /*order_type*/) const {
+        return market_order_latency_;
+    }
+    uint64_t GetCancelLatency() const {
+        return cancel_latency_;
+    }
+    uint64_t GetMaxPostLatency() const;
+    uint64_t GetMaxCancelLatency() const;
+
+private:
+    uint64_t limit_order_latency_;
+    uint64_t market_order_latency_;
+    uint64_t cancel_latency_;
+};
+
+// every request takes a latency drawn uniformly from the samples, e.g. measured round trips
+class SampledLatency {
+public:
+    explicit SampledLatency(const std::vector<uint64_t>& samples, const uint64_t& seed = 0);
+    uint64_t GetLimitOrderLatency(const OrderTypes& order_type);
+    uint64_t GetMarketOrderLatency(const OrderTypes& order_type);
+    uint64_t GetCancelLatency();
+    uint64_t GetMaxPostLatency() const;
+    uint64_t GetMaxCancelLatency() const;
+
+private:
+    uint64_t Sample();
+    std::vector<uint64_t> samples_;
+    uint64_t max_sample_;
+    std::mt19937_64 rnd_;
+};
+
+class ConstantFee {
+public:
+    explicit ConstantFee(const uint64_t& fee = 0) : fee_(fee) {
+    }
+    uint64_t GetFee(const Liquidity& /*liquidity*/, const BaseOrder& /*order*/,
+                    const CompletedTransaction& /*transaction*/) const {
+        return fee_;
+    }
+
+private:
+    uint64_t fee_;
+};
+
+class MakerTakerFee {
+public:
+    explicit MakerTakerFee(const uint64_t& maker_fee = 0, const uint64_t& taker_fee = 0)
+        : maker_fee_(maker_fee), taker_fee_(taker_fee) {
+    }
+    uint64_t GetFee(const Liquidity& liquidity, const BaseOrder& /*order*/,
+                    const CompletedTransaction& /*transaction*/) const {
+        return liquidity == MAKER ? maker_fee_ : taker_fee_;
+    }
+    uint64_t GetMakerFee() const;
+    uint64_t GetTakerFee() const;
+
+private:
+    uint64_t maker_fee_;
+    uint64_t taker_fee_;
+};
+
+struct FeeTier {
+    // the tier applies once the traded volume of the user reaches min_volume
+    uint64_t min_volume;
+    uint64_t maker_fee;
+    uint64_t taker_fee;
+};
+
+// maker and taker fees which go down with the volume traded before the fill
+class TieredFee {
+public:
+    // the tiers have to start with min_volume 0 and be sorted by min_volume
+    explicit TieredFee(const std::vector<FeeTier>& tiers);
+    uint64_t GetFee(const Liquidity& liquidity, const BaseOrder& order,
+                    const CompletedTransaction& transaction);
+    uint64_t GetTradedVolume() const;
+
+private:
+    std::vector<FeeTier> tiers_;
+    size_t tier_;
+    uint64_t traded_volume_;
+};
@@ -0,0 +1,241 @@
+#include "feature_export.h"
+
+#include "replay_book.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+// FeatureExporter
+
+FeatureExporter::FeatureExporter(const Scanner& scanner, const ExportConfig& config)
+    : data_(scanner), config_(config) {
+    if (config_.step == 0 || config_.shard_duration == 0 || config_.threads == 0) {
+        throw std::runtime_error(
+            "FeatureExporter::FeatureExporter - step, shard_duration and threads have to be "
+            "positive.");
+    }
+    for (const auto& horizon : config_.horizons) {
+        if (horizon % config_.step != 0) {
+            throw std::runtime_error(
+                "FeatureExporter::FeatureExporter - Horizons have to be multiples of step.");
+        }
+    }
+    for (const auto& feature : config_.features) {
+        if (!feature.IsTradeFeature()) {
+            continue;
+        }
+        if (feature.window_type == TIME) {
+            max_time_window_ = std::max(max_time_window_, feature.parameter);
+        } else {
+            max_count_window_ = std::max(max_count_window_, feature.parameter);
+        }
+    }
+    // shards have to start at ticks
+    config_.shard_duration = (config_.shard_duration + config_.step - 1) / config_.step *
+                             config_.step;
+}
+
+const CompactDataset& FeatureExporter::GetData() const {
+    return data_;
+}
+
+std::vector<std::string> FeatureExporter::GetColumnNames() const {
+    std::vector<std::string> names = {"timestamp"};
+    for (const auto& name : FeatureSet(config_.features).GetNames()) {
+        names.emplace_back(name);
+    }
+    for (const auto& horizon : config_.horizons) {
+        names.emplace_back("return_" + std::to_string(horizon) + "ms");
+    }
+    return names;
+}
+
+uint64_t FeatureExporter::Export(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("FeatureExporter::Export - Failed to open the output file.");
+    }
+    auto write_number = [&out](const uint64_t& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    out.write("BTFEAT01", 8);
+    auto names = GetColumnNames();
+    write_number(names.size());
+    for (const auto& name : names) {
+        write_number(name.size());
+        out.write(name.data(), name.size());
+    }
+
+    std::vector<uint64_t> shard_starts;
+    for (uint64_t from = config_.start_timestamp; from < config_.end_timestamp;
+         from += config_.shard_duration) {
+        shard_starts.emplace_back(from);
+    }
+    std::vector<std::unique_ptr<TColumns>> shards(shard_starts.size());
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable shard_ready;
+    std::atomic<size_t> next_shard(0);
+
+    auto worker = [&]() {
+        for (size_t i = next_shard++; i < shard_starts.size(); i = next_shard++) {
+            std::unique_ptr<TColumns> columns;
+            try {
+                uint64_t to = std::min(shard_starts[i] + config_.shard_duration,
+                                       config_.end_timestamp);
+                columns = std::make_unique<TColumns>(ExportShard(shard_starts[i], to));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = std::current_exception();
+                next_shard = shard_starts.size();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            shards[i] = std::move(columns);
+            shard_ready.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (uint64_t i = 0; i < std::min<uint64_t>(config_.threads, shard_starts.size()); ++i) {
+        workers.emplace_back(worker);
+    }
+
+    uint64_t total_rows = 0;
+    for (size_t i = 0; i < shard_starts.size(); ++i) {
+        std::unique_ptr<TColumns> columns;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            shard_ready.wait(lock, [&]() { return shards[i] || error; });
+            if (error) {
+                break;
+            }
+            columns = std::move(shards[i]);
+        }
+        uint64_t rows = columns->front().size();
+        write_number(rows);
+        for (const auto& column : *columns) {
+            out.write(reinterpret_cast<const char*>(column.data()), rows * sizeof(double));
+        }
+        total_rows += rows;
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (!out) {
+        throw std::runtime_error("FeatureExporter::Export - Failed to write the output file.");
+    }
+    return total_rows;
+}
+
+FeatureExporter::TColumns FeatureExporter::ExportShard(const uint64_t& from,
+                                                       const uint64_t& to) const {
+    static const double nan = std::numeric_limits<double>::quiet_NaN();
+    static const double percent_base = 10000;
+    const auto& snapshots = data_.GetSnapshots();
+    const auto& transactions = data_.GetTransactions();
+
+    // the windows at the first tick have to match a replay from the start of the data:
+    // the time windows need the trades of the last max_time_window_ ms and the count windows
+    // need the last max_count_window_ trades, every raw transaction completes at least one
+    uint64_t replay_from = from - std::min(from, std::max(config_.warmup, max_time_window_));
+    size_t count_from = transactions.LowerBound(from + 1);
+    count_from -= std::min<size_t>(count_from, max_count_window_);
+    if (count_from < transactions.Size()) {
+        replay_from = std::min(replay_from, transactions.GetTimestamp(count_from));
+    }
+    // after a snapshot the book doesn't depend on the previous ones,
+    // so the replay starts from the last snapshot before replay_from
+    size_t orders_position = 0;
+    while (orders_position + 1 < snapshots.Size() &&
+           snapshots.GetTimestamp(orders_position + 1) <= replay_from) {
+        ++orders_position;
+    }
+    uint64_t transactions_from =
+        snapshots.Size() == 0 ? replay_from
+                              : std::min(replay_from, snapshots.GetTimestamp(orders_position));
+    size_t transactions_position = transactions.LowerBound(transactions_from);
+    uint64_t data_end = 0;
+    if (snapshots.Size() > 0) {
+        data_end = snapshots.GetTimestamp(snapshots.Size() - 1);
+    }
+    if (transactions.Size() > 0) {
+        data_end = std::max(data_end, transactions.GetTimestamp(transactions.Size() - 1));
+    }
+
+    FeatureSet feature_set(config_.features);
+    FeatureStore feature_store;
+    feature_set.RegisterWindows(feature_store);
+    ReplayBook book;
+    std::vector<CompletedTransaction> completed;
+
+    uint64_t max_horizon = 0;
+    for (const auto& horizon : config_.horizons) {
+        max_horizon = std::max(max_horizon, horizon);
+    }
+    TColumns columns(1 + feature_set.Size() + config_.horizons.size());
+    std::vector<double> features(feature_set.Size());
+    std::vector<double> mid_prices;
+
+    for (uint64_t timestamp = from; timestamp < to + max_horizon; timestamp += config_.step) {
+        while (true) {
+            uint64_t orders_time =
+                orders_position < snapshots.Size() ? snapshots.GetTimestamp(orders_position) : -1;
+            uint64_t transactions_time = transactions_position < transactions.Size()
+                                             ? transactions.GetTimestamp(transactions_position)
+                                             : -1;
+            if (std::min(orders_time, transactions_time) > timestamp) {
+                break;
+            }
+            if (orders_time <= transactions_time) {
+                book.UpdateOrderBook(snapshots, orders_position);
+                ++orders_position;
+            } else {
+                completed.clear();
+                book.CompleteMarketTransaction(transactions.Get(transactions_position++),
+                                               completed);
+                for (const auto& transaction : completed) {
+                    feature_store.AddTransaction(transaction);
+                }
+            }
+        }
+        feature_store.AdvanceTo(timestamp);
+
+        bool has_book = book.GetAsk().Size() > 0 && book.GetBid().Size() > 0;
+        mid_prices.emplace_back(
+            has_book && timestamp <= data_end
+                ? (static_cast<double>(book.GetAsk().prices[0]) + book.GetBid().prices[0]) / 2
+                : nan);
+        if (timestamp >= to) {
+            continue;
+        }
+        columns[0].emplace_back(timestamp);
+        if (has_book) {
+            feature_set.Compute(book.GetAsk(), book.GetBid(), feature_store, features.data());
+        } else {
+            std::fill(features.begin(), features.end(), nan);
+        }
+        for (size_t i = 0; i < features.size(); ++i) {
+            columns[1 + i].emplace_back(features[i]);
+        }
+    }
+
+    size_t rows = columns[0].size();
+    for (size_t i = 0; i < config_.horizons.size(); ++i) {
+        auto& labels = columns[1 + feature_set.Size() + i];
+        size_t shift = config_.horizons[i] / config_.step;
+        for (size_t row = 0; row < rows; ++row) {
+            labels.emplace_back((mid_prices[row + shift] - mid_prices[row]) / mid_prices[row] *
+                                percent_base);
+        }
+    }
+    return columns;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "compact_data.h"
+#include "feature_set.h"
+#include "scanner.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// time in ms
+struct ExportConfig {
+    uint64_t start_timestamp = 0;
+    uint64_t end_timestamp = 0;
+    // distance between two decision ticks, every tick is one row
+    uint64_t step = 1000;
+    // labels are mid price returns in bps after each horizon, horizons have to be multiples of step
+    std::vector<uint64_t> horizons = {1000, 10000, 60000};
+    // every shard replays at least this much data before its first tick, the replay also goes
+    // back far enough to fill the longest time window and the largest trade count window
+    uint64_t warmup = 0;
+    uint64_t shard_duration = 3600000;
+    uint64_t threads = 1;
+    std::vector<FeatureSpec> features = GetDefaultFeatures();
+};
+
+// Replays the data without a strategy and writes a row of features and labels per decision tick.
+// Shards of shard_duration ms are replayed independently by a pool of threads and written in
+// order, so the result doesn't depend on the number of threads.
+//
+// The file is columnar, all numbers are little endian:
+//   "BTFEAT01", uint64 column count, (uint64 name length, name) per column,
+//   then row groups until the end of file: uint64 row count, one double array per column.
+// The columns are timestamp, the features and return_<horizon>ms labels. Values which can't be
+// computed (an empty book side or a horizon after the end of the data) are NaN.
+class FeatureExporter {
+public:
+    // keeps a compact copy of the data, the scanner is only read by the constructor
+    FeatureExporter(const Scanner& scanner, const ExportConfig& config);
+    std::vector<std::string> GetColumnNames() const;
+    // returns the number of written rows
+    uint64_t Export(const std::string& path) const;
+    const CompactDataset& GetData() const;
+
+private:
+    using TColumns = std::vector<std::vector<double>>;
+    TColumns ExportShard(const uint64_t& from, const uint64_t& to) const;
+    CompactDataset data_;
+    ExportConfig config_;
+    uint64_t max_time_window_ = 0;
+    uint64_t max_count_window_ = 0;
+};
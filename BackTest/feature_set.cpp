@@ -0,0 +1,162 @@
+#include "feature_set.h"
+
+#include <stdexcept>
+
+// FeatureTypes
+
+std::string ToString(const FeatureTypes& feature_type) {
+    switch (feature_type) {
+        case MID_PRICE:
+            return "mid_price";
+        case SPREAD:
+            return "spread";
+        case MICRO_PRICE:
+            return "micro_price";
+        case DEPTH_IMBALANCE:
+            return "depth_imbalance";
+        case ASK_VOLUME:
+            return "ask_volume";
+        case BID_VOLUME:
+            return "bid_volume";
+        case NOTIONAL_NEAR_MID:
+            return "notional_near_mid";
+        case WINDOW_COUNT:
+            return "trade_count";
+        case WINDOW_VOLUME:
+            return "trade_volume";
+        case WINDOW_SIGNED_VOLUME:
+            return "signed_volume";
+        case WINDOW_VWAP:
+            return "vwap";
+        case WINDOW_BUYER_MAKER_IMBALANCE:
+            return "buyer_maker_imbalance";
+    }
+    throw std::runtime_error("ToString - Incorrect feature_type.");
+}
+
+// FeatureSpec
+
+FeatureSpec::FeatureSpec(const FeatureTypes& feature_type, const uint64_t& parameter,
+                         const WindowTypes& window_type)
+    : feature_type(feature_type), parameter(parameter), window_type(window_type) {
+}
+
+bool FeatureSpec::IsTradeFeature() const {
+    return feature_type >= WINDOW_COUNT;
+}
+
+std::string FeatureSpec::GetName() const {
+    std::string name = ToString(feature_type);
+    if (IsTradeFeature()) {
+        name += (window_type == TRADE_COUNT ? "_trades_" : "_ms_") + std::to_string(parameter);
+    } else if (parameter != 0) {
+        name += "_" + std::to_string(parameter);
+    }
+    return name;
+}
+
+// FeatureSet
+
+FeatureSet::FeatureSet(const std::vector<FeatureSpec>& features)
+    : features_(features), window_ids_() {
+}
+
+void FeatureSet::RegisterWindows(FeatureStore& feature_store) {
+    window_ids_.clear();
+    for (const auto& feature : features_) {
+        if (!feature.IsTradeFeature()) {
+            window_ids_.emplace_back(-1);
+        } else if (feature.window_type == TRADE_COUNT) {
+            window_ids_.emplace_back(feature_store.AddTradeCountWindow(feature.parameter));
+        } else {
+            window_ids_.emplace_back(feature_store.AddTimeWindow(feature.parameter));
+        }
+    }
+}
+
+size_t FeatureSet::Size() const {
+    return features_.size();
+}
+
+const std::vector<FeatureSpec>& FeatureSet::GetFeatures() const {
+    return features_;
+}
+
+std::vector<std::string> FeatureSet::GetNames() const {
+    std::vector<std::string> names;
+    for (const auto& feature : features_) {
+        names.emplace_back(feature.GetName());
+    }
+    return names;
+}
+
+void FeatureSet::Compute(const BookLevels& ask, const BookLevels& bid,
+                         const FeatureStore& feature_store, double* features) const {
+    if (window_ids_.size() != features_.size()) {
+        throw std::runtime_error("FeatureSet::Compute - Windows have to be registered.");
+    }
+    if (ask.Size() == 0 || bid.Size() == 0) {
+        throw std::runtime_error("FeatureSet::Compute - Both sides have to be non empty.");
+    }
+    double best_ask = ask.prices[0], best_bid = bid.prices[0];
+    for (size_t i = 0; i < features_.size(); ++i) {
+        const auto& feature = features_[i];
+        switch (feature.feature_type) {
+            case MID_PRICE:
+                features[i] = (best_ask + best_bid) / 2;
+                break;
+            case SPREAD:
+                features[i] = best_ask - best_bid;
+                break;
+            case MICRO_PRICE:
+                features[i] = GetMicroPrice(ask, bid);
+                break;
+            case DEPTH_IMBALANCE:
+                features[i] = GetDepthWeightedImbalance(ask, bid, feature.parameter);
+                break;
+            case ASK_VOLUME:
+                features[i] = GetCumulativeVolume(ask, feature.parameter);
+                break;
+            case BID_VOLUME:
+                features[i] = GetCumulativeVolume(bid, feature.parameter);
+                break;
+            case NOTIONAL_NEAR_MID:
+                features[i] = GetNotionalNearMid(ask, bid, feature.parameter);
+                break;
+            default: {
+                const auto& window = feature_store.GetWindow(window_ids_[i]);
+                if (feature.feature_type == WINDOW_COUNT) {
+                    features[i] = window.count;
+                } else if (feature.feature_type == WINDOW_VOLUME) {
+                    features[i] = window.volume;
+                } else if (feature.feature_type == WINDOW_SIGNED_VOLUME) {
+                    features[i] = window.signed_volume;
+                } else if (feature.feature_type == WINDOW_VWAP) {
+                    features[i] = window.GetVWAP();
+                } else {
+                    features[i] = window.GetBuyerMakerImbalance();
+                }
+            }
+        }
+    }
+}
+
+std::vector<FeatureSpec> GetDefaultFeatures() {
+    std::vector<FeatureSpec> features = {{MID_PRICE},
+                                         {SPREAD},
+                                         {MICRO_PRICE},
+                                         {DEPTH_IMBALANCE, 5},
+                                         {DEPTH_IMBALANCE, 50},
+                                         {ASK_VOLUME, 10},
+                                         {BID_VOLUME, 10},
+                                         {NOTIONAL_NEAR_MID, 10}};
+    for (const auto& feature_type :
+         {WINDOW_COUNT, WINDOW_VOLUME, WINDOW_SIGNED_VOLUME, WINDOW_VWAP,
+          WINDOW_BUYER_MAKER_IMBALANCE}) {
+        for (const uint64_t count : {10, 100}) {
+            features.emplace_back(feature_type, count, TRADE_COUNT);
+        }
+        features.emplace_back(feature_type, 10000, TIME);
+    }
+    return features;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "book_kernels.h"
+#include "feature_store.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum FeatureTypes {
+    MID_PRICE,
+    SPREAD,
+    MICRO_PRICE,
+    DEPTH_IMBALANCE,               // parameter is depth
+    ASK_VOLUME,                    // parameter is depth
+    BID_VOLUME,                    // parameter is depth
+    NOTIONAL_NEAR_MID,             // parameter is bps
+    WINDOW_COUNT,                  // parameter is the window limit
+    WINDOW_VOLUME,                 // parameter is the window limit
+    WINDOW_SIGNED_VOLUME,          // parameter is the window limit
+    WINDOW_VWAP,                   // parameter is the window limit
+    WINDOW_BUYER_MAKER_IMBALANCE,  // parameter is the window limit
+};
+
+std::string ToString(const FeatureTypes& feature_type);
+
+struct FeatureSpec {
+    FeatureTypes feature_type;
+    uint64_t parameter;
+    // only for the trade features
+    WindowTypes window_type;
+    FeatureSpec() = default;
+    FeatureSpec(const FeatureTypes& feature_type, const uint64_t& parameter = 0,
+                const WindowTypes& window_type = TRADE_COUNT);
+    bool IsTradeFeature() const;
+    std::string GetName() const;
+};
+
+// A fixed list of features computed from the book levels and the rolling trade windows. The same
+// set is used for the offline export and for the inference inside a strategy, so both of them
+// see exactly the same values.
+class FeatureSet {
+public:
+    FeatureSet() = default;
+    explicit FeatureSet(const std::vector<FeatureSpec>& features);
+    // registers all trade windows, has to be called before the transactions are added
+    void RegisterWindows(FeatureStore& feature_store);
+    size_t Size() const;
+    const std::vector<FeatureSpec>& GetFeatures() const;
+    std::vector<std::string> GetNames() const;
+    // writes Size() values into features, both sides have to be non empty
+    void Compute(const BookLevels& ask, const BookLevels& bid, const FeatureStore& feature_store,
+                 double* features) const;
+
+private:
+    std::vector<FeatureSpec> features_;
+    std::vector<uint64_t> window_ids_;
+};
+
+// a reasonable default for the export
+std::vector<FeatureSpec> GetDefaultFeatures();
@@ -0,0 +1,152 @@
+#include "feature_store.h"
+
+#include <iostream>
+#include <stdexcept>
+
+// TradeWindowStats
+
+TradeWindowStats::TradeWindowStats()
+    : count(0), volume(0), signed_volume(0), notional(0), buyer_maker_count(0) {
+}
+
+uint64_t TradeWindowStats::GetVWAP() const {
+    if (volume == 0) {
+        return 0;
+    }
+    return notional / volume;
+}
+
+int64_t TradeWindowStats::GetBuyerMakerImbalance() const {
+    return 2 * static_cast<int64_t>(buyer_maker_count) - static_cast<int64_t>(count);
+}
+
+void TradeWindowStats::Print(bool print_name) const {
+    if (print_name) {
+        std::cerr << "TradeWindowStats:" << std::endl;
+    }
+    std::cerr << "count = " << count << " volume = " << volume
+              << " signed_volume = " << signed_volume << " notional = " << notional
+              << " buyer_maker_count = " << buyer_maker_count << std::endl;
+}
+
+// RollingTradeWindow
+
+RollingTradeWindow::RollingTradeWindow(const WindowTypes& window_type, const uint64_t& limit)
+    : window_type_(window_type), limit_(limit), transactions_(), stats_() {
+    if (window_type_ == TRADE_COUNT && limit_ == 0) {
+        throw std::runtime_error(
+            "RollingTradeWindow::RollingTradeWindow - Trade count window have to be non empty.");
+    }
+}
+
+WindowTypes RollingTradeWindow::GetWindowType() const {
+    return window_type_;
+}
+
+uint64_t RollingTradeWindow::GetLimit() const {
+    return limit_;
+}
+
+void RollingTradeWindow::AddTransaction(const CompletedTransaction& transaction) {
+    transactions_.emplace_back(transaction);
+    Add(transaction, 1);
+    if (window_type_ == TRADE_COUNT) {
+        if (transactions_.size() > limit_) {
+            Add(transactions_.front(), -1);
+            transactions_.pop_front();
+        }
+    } else {
+        AdvanceTo(transaction.GetTransactionTimestamp());
+    }
+}
+
+void RollingTradeWindow::AdvanceTo(const uint64_t& timestamp) {
+    if (window_type_ != TIME) {
+        return;
+    }
+    while (!transactions_.empty() &&
+           transactions_.front().GetTransactionTimestamp() + limit_ < timestamp) {
+        Add(transactions_.front(), -1);
+        transactions_.pop_front();
+    }
+}
+
+const TradeWindowStats& RollingTradeWindow::GetStats() const {
+    return stats_;
+}
+
+void RollingTradeWindow::Add(const CompletedTransaction& transaction, const int64_t& sign) {
+    int64_t volume = transaction.GetVolume();
+    stats_.count += sign;
+    stats_.volume += sign * volume;
+    stats_.notional += sign * volume * static_cast<int64_t>(transaction.GetPrice());
+    if (transaction.GetIsBuyerMaker()) {
+        stats_.signed_volume += sign * volume;
+        stats_.buyer_maker_count += sign;
+    } else {
+        stats_.signed_volume -= sign * volume;
+    }
+}
+
+// FeatureStore
+
+uint64_t FeatureStore::AddTradeCountWindow(const uint64_t& count) {
+    return AddWindow(TRADE_COUNT, count);
+}
+
+uint64_t FeatureStore::AddTimeWindow(const uint64_t& milliseconds) {
+    return AddWindow(TIME, milliseconds);
+}
+
+uint64_t FeatureStore::AddWindow(const WindowTypes& window_type, const uint64_t& limit) {
+    for (size_t i = 0; i < windows_.size(); ++i) {
+        if (windows_[i].GetWindowType() == window_type && windows_[i].GetLimit() == limit) {
+            return i;
+        }
+    }
+    windows_.emplace_back(window_type, limit);
+    return windows_.size() - 1;
+}
+
+void FeatureStore::AddTransaction(const CompletedTransaction& transaction) {
+    ++total_transactions_;
+    for (auto& window : windows_) {
+        window.AddTransaction(transaction);
+    }
+}
+
+void FeatureStore::AdvanceTo(const uint64_t& timestamp) {
+    for (auto& window : windows_) {
+        window.AdvanceTo(timestamp);
+    }
+}
+
+const TradeWindowStats& FeatureStore::GetWindow(const uint64_t& window_id) const {
+    if (window_id >= windows_.size()) {
+        throw std::runtime_error(
+            "FeatureStore::GetWindow - It is forbidden to request a non-existent window.");
+    }
+    return windows_[window_id].GetStats();
+}
+
+const TradeWindowStats& FeatureStore::GetTradeCountWindow(const uint64_t& count) const {
+    return FindWindow(TRADE_COUNT, count);
+}
+
+const TradeWindowStats& FeatureStore::GetTimeWindow(const uint64_t& milliseconds) const {
+    return FindWindow(TIME, milliseconds);
+}
+
+const TradeWindowStats& FeatureStore::FindWindow(const WindowTypes& window_type,
+                                                 const uint64_t& limit) const {
+    for (const auto& window : windows_) {
+        if (window.GetWindowType() == window_type && window.GetLimit() == limit) {
+            return window.GetStats();
+        }
+    }
+    throw std::runtime_error("FeatureStore::FindWindow - The window wasn't registered.");
+}
+
+uint64_t FeatureStore::GetTotalTransactions() const {
+    return total_transactions_;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "completed_transaction.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Aggregates of the completed transactions which are currently inside a window.
+struct TradeWindowStats {
+    uint64_t count;
+    uint64_t volume;
+    // volume of transactions with is_buyer_maker minus volume of the other ones
+    int64_t signed_volume;
+    // sum of price * volume
+    uint64_t notional;
+    uint64_t buyer_maker_count;
+    TradeWindowStats();
+    uint64_t GetVWAP() const;
+    // count of transactions with is_buyer_maker minus count of the other ones
+    int64_t GetBuyerMakerImbalance() const;
+    void Print(bool print_name = true) const;
+};
+
+enum WindowTypes {
+    TRADE_COUNT,  // the last limit transactions
+    TIME          // transactions not older than limit ms
+};
+
+class RollingTradeWindow {
+public:
+    RollingTradeWindow(const WindowTypes& window_type, const uint64_t& limit);
+    WindowTypes GetWindowType() const;
+    uint64_t GetLimit() const;
+    void AddTransaction(const CompletedTransaction& transaction);
+    void AdvanceTo(const uint64_t& timestamp);
+    const TradeWindowStats& GetStats() const;
+
+private:
+    void Add(const CompletedTransaction& transaction, const int64_t& sign);
+    WindowTypes window_type_;
+    uint64_t limit_;
+    std::deque<CompletedTransaction> transactions_;
+    TradeWindowStats stats_;
+};
+
+// Rolling trade features over several windows. Every window is updated in O(1) amortized per
+// transaction, so signals can read them on each decision without rescanning the history.
+class FeatureStore {
+public:
+    FeatureStore() = default;
+    // windows only see transactions added after their registration,
+    // registering an existing window returns its id
+    uint64_t AddTradeCountWindow(const uint64_t& count);
+    uint64_t AddTimeWindow(const uint64_t& milliseconds);
+    void AddTransaction(const CompletedTransaction& transaction);
+    // evicts transactions which left the time windows by the timestamp
+    void AdvanceTo(const uint64_t& timestamp);
+    const TradeWindowStats& GetWindow(const uint64_t& window_id) const;
+    const TradeWindowStats& GetTradeCountWindow(const uint64_t& count) const;
+    const TradeWindowStats& GetTimeWindow(const uint64_t& milliseconds) const;
+    uint64_t GetTotalTransactions() const;
+
+private:
+    uint64_t AddWindow(const WindowTypes& window_type, const uint64_t& limit);
+    const TradeWindowStats& FindWindow(const WindowTypes& window_type,
+                                       const uint64_t& limit) const;
+    std::vector<RollingTradeWindow> windows_;
+    uint64_t total_transactions_ = 0;
+};
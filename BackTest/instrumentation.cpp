@@ -0,0 +1,130 @@
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+// EventTypes
+
+std::string ToString(const EventTypes& event_type) {
+    switch (event_type) {
+        case BOOK_UPDATE:
+            return "book update";
+        case LEVEL_UPDATE:
+            return "level update";
+        case MARKET_TRADE:
+            return "market trade";
+        case USER_LIMIT_ORDER:
+            return "user limit order";
+        case USER_MARKET_ORDER:
+            return "user market order";
+        case USER_CANCEL:
+            return "user cancel";
+        case EVENT_TYPES_COUNT:
+            break;
+    }
+    throw std::runtime_error("ToString - Incorrect event_type.");
+}
+
+// Stages
+
+std::string ToString(const Stages& stage) {
+    switch (stage) {
+        case UPDATE_ORDER_BOOK:
+            return "UpdateOrderBook";
+        case UPDATE_LEVEL:
+            return "UpdateLevel";
+        case COMPLETE_MARKET_TRANSACTION:
+            return "CompleteMarketTransaction";
+        case ADD_USER_LIMIT_ORDER:
+            return "AddUserLimitOrder";
+        case COMPLETE_USER_MARKET_ORDER:
+            return "CompleteUserMarketOrder";
+        case REMOVE_ORDER:
+            return "RemoveOrder";
+        case STAGES_COUNT:
+            break;
+    }
+    throw std::runtime_error("ToString - Incorrect stage.");
+}
+
+// Histogram
+
+Histogram::Histogram() : buckets(), count(0), total(0), max(0) {
+}
+
+void Histogram::Add(const uint64_t& value) {
+    ++buckets[value == 0 ? 0 : 64 - __builtin_clzll(value)];
+    ++count;
+    total += value;
+    max = std::max(max, value);
+}
+
+double Histogram::GetMean() const {
+    return count == 0 ? 0 : static_cast<double>(total) / count;
+}
+
+void Histogram::Print(const std::string& name) const {
+    std::cerr << name << ": count = " << count << " mean = " << GetMean() << " max = " << max
+              << std::endl;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i] == 0) {
+            continue;
+        }
+        uint64_t from = i == 0 ? 0 : uint64_t(1) << (i - 1);
+        uint64_t to = i == 0 ? 0 : from * 2 - 1;
+        std::cerr << "  [" << from << ", " << to << "]: " << buckets[i] << std::endl;
+    }
+}
+
+// StageTimer
+
+StageTimer::StageTimer() : calls(0), nanoseconds(0) {
+}
+
+// EngineStats
+
+EngineStats::EngineStats() : events(), event_loop(), orderbook() {
+}
+
+uint64_t EngineStats::GetTotalEvents() const {
+    uint64_t total = 0;
+    for (const auto& count : events) {
+        total += count;
+    }
+    return total;
+}
+
+void EngineStats::Print(bool print_name) const {
+    if (print_name) {
+        std::cerr << "Stats:" << std::endl;
+    }
+    if (!IsInstrumentationEnabled()) {
+        std::cerr << "instrumentation is compiled out, configure with "
+                     "-DBACKTEST_INSTRUMENTATION=ON"
+                  << std::endl;
+        return;
+    }
+    double seconds = event_loop.nanoseconds / 1e9;
+    std::cerr << "events = " << GetTotalEvents() << " event loop = " << seconds << " s";
+    if (event_loop.nanoseconds != 0) {
+        std::cerr << " events/sec = " << GetTotalEvents() / seconds;
+    }
+    std::cerr << std::endl;
+    for (size_t i = 0; i < events.size(); ++i) {
+        std::cerr << "  " << ToString(static_cast<EventTypes>(i)) << ": " << events[i]
+                  << std::endl;
+    }
+    for (size_t i = 0; i < orderbook.stages.size(); ++i) {
+        const auto& stage = orderbook.stages[i];
+        std::cerr << ToString(static_cast<Stages>(i)) << ": calls = " << stage.calls
+                  << " total = " << stage.nanoseconds / 1e6 << " ms";
+        if (stage.calls != 0) {
+            std::cerr << " per call = " << static_cast<double>(stage.nanoseconds) / stage.calls
+                      << " ns";
+        }
+        std::cerr << std::endl;
+    }
+    orderbook.book_size.Print("book size");
+    orderbook.fills.Print("fills per event");
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// The statistics are collected only if the library is configured with
+// -DBACKTEST_INSTRUMENTATION=ON, otherwise every BACKTEST_STATS statement is removed by the
+// preprocessor and the hot path is exactly the same as without the instrumentation.
+#ifdef BACKTEST_INSTRUMENTATION
+#define BACKTEST_STATS(...) __VA_ARGS__
+#else
+#define BACKTEST_STATS(...)
+#endif
+
+constexpr bool IsInstrumentationEnabled() {
+#ifdef BACKTEST_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+enum EventTypes {
+    BOOK_UPDATE,        // a historical orderbook snapshot
+    LEVEL_UPDATE,       // a historical update of one level of the orderbook
+    MARKET_TRADE,       // a historical market transaction
+    USER_LIMIT_ORDER,   // a user limit order reached the orderbook
+    USER_MARKET_ORDER,  // a user market order reached the orderbook
+    USER_CANCEL,        // a withdraw request reached the orderbook
+    EVENT_TYPES_COUNT
+};
+
+std::string ToString(const EventTypes& event_type);
+
+enum Stages {
+    UPDATE_ORDER_BOOK,
+    UPDATE_LEVEL,
+    COMPLETE_MARKET_TRANSACTION,
+    ADD_USER_LIMIT_ORDER,
+    COMPLETE_USER_MARKET_ORDER,
+    REMOVE_ORDER,
+    STAGES_COUNT
+};
+
+std::string ToString(const Stages& stage);
+
+// Bucket 0 counts zeros, bucket k counts the values in [2^(k - 1), 2^k).
+struct Histogram {
+    std::array<uint64_t, 65> buckets;
+    uint64_t count;
+    uint64_t total;
+    uint64_t max;
+    Histogram();
+    void Add(const uint64_t& value);
+    double GetMean() const;
+    void Print(const std::string& name) const;
+};
+
+struct StageTimer {
+    uint64_t calls;
+    uint64_t nanoseconds;
+    StageTimer();
+};
+
+// adds the lifetime of the scope to the timer
+class ScopedTimer {
+public:
+    explicit ScopedTimer(StageTimer& timer);
+    ~ScopedTimer();
+
+private:
+    StageTimer& timer_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+struct OrderBookStats {
+    std::array<StageTimer, STAGES_COUNT> stages;
+    // orders in both sides after a snapshot
+    Histogram book_size;
+    // transactions produced by one matching event
+    Histogram fills;
+};
+
+struct EngineStats {
+    std::array<uint64_t, EVENT_TYPES_COUNT> events;
+    // time spent in the event loop, strategy hooks included
+    StageTimer event_loop;
+    OrderBookStats orderbook;
+    EngineStats();
+    uint64_t GetTotalEvents() const;
+    void Print(bool print_name = true) const;
+};
+
+// ScopedTimer
+
+inline ScopedTimer::ScopedTimer(StageTimer& timer)
+    : timer_(timer), start_(std::chrono::steady_clock::now()) {
+}
+
+inline ScopedTimer::~ScopedTimer() {
+    ++timer_.calls;
+    timer_.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start_)
+                              .count();
+}
@@ -0,0 +1,110 @@
+#include "level_index.h"
+
+#include <stdexcept>
+
+// LevelIndex
+
+LevelIndex::LevelIndex(const OrderTypes& order_type)
+    : order_type_(order_type), is_valid_(true), base_(0), tick_(1), counts_(), volumes_() {
+}
+
+bool LevelIndex::Update(const uint64_t& price, const int64_t& count, const int64_t& volume) {
+    if (!is_valid_) {
+        return true;
+    }
+    size_t position;
+    if (!GetPosition(price, position)) {
+        return false;
+    }
+    for (++position; position <= counts_.size(); position += position & -position) {
+        counts_[position - 1] += count;
+        volumes_[position - 1] += volume;
+    }
+    return true;
+}
+
+bool LevelIndex::IsValid() const {
+    return is_valid_;
+}
+
+std::pair<uint64_t, uint64_t> LevelIndex::GetAhead(const uint64_t& price) const {
+    size_t position;
+    if (!is_valid_ || !GetPosition(price, position)) {
+        throw std::runtime_error("LevelIndex::GetAhead - The price doesn't fit the index.");
+    }
+    uint64_t count = 0, volume = 0;
+    for (; position > 0; position -= position & -position) {
+        count += counts_[position - 1];
+        volume += volumes_[position - 1];
+    }
+    return {count, volume};
+}
+
+uint64_t LevelIndex::GetKey(const uint64_t& price) const {
+    if (order_type_ == ASK) {
+        return price;
+    } else if (order_type_ == BID) {
+        return ~price;
+    } else {
+        throw std::runtime_error("LevelIndex::GetKey - Incorrect order_type.");
+    }
+}
+
+bool LevelIndex::GetPosition(const uint64_t& price, size_t& position) const {
+    uint64_t key = GetKey(price);
+    if (key < base_ || (key - base_) % tick_ != 0 || (key - base_) / tick_ >= counts_.size()) {
+        return false;
+    }
+    position = (key - base_) / tick_;
+    return true;
+}
+
+void LevelIndex::Build(const std::vector<std::pair<uint64_t, uint64_t>>& levels) {
+    is_valid_ = true;
+    counts_.assign(min_size_, 0);
+    volumes_.assign(min_size_, 0);
+    if (levels.empty()) {
+        base_ = 0;
+        tick_ = 1;
+        return;
+    }
+    uint64_t min_key = levels[0].first, max_key = levels[0].first;
+    for (const auto& [key, volume] : levels) {
+        min_key = std::min(min_key, key);
+        max_key = std::max(max_key, key);
+    }
+    uint64_t tick = 0;
+    for (const auto& [key, volume] : levels) {
+        tick = std::gcd(tick, key - min_key);
+    }
+    if (tick == 0) {
+        tick = tick_;
+    }
+    uint64_t range = (max_key - min_key) / tick + 1;
+    // free space on both sides for the orders which come before the next rebuild
+    uint64_t size = min_size_;
+    while (size < 2 * range && size < max_size_) {
+        size *= 2;
+    }
+    if (range > size) {
+        is_valid_ = false;
+        return;
+    }
+    tick_ = tick;
+    base_ = min_key - std::min((size - range) / 2, min_key / tick_) * tick_;
+    counts_.assign(size, 0);
+    volumes_.assign(size, 0);
+    for (const auto& [key, volume] : levels) {
+        size_t position = (key - base_) / tick_;
+        ++counts_[position];
+        volumes_[position] += volume;
+    }
+    // linear construction of the Fenwick trees
+    for (size_t position = 1; position <= size; ++position) {
+        size_t parent = position + (position & -position);
+        if (parent <= size) {
+            counts_[parent - 1] += counts_[position - 1];
+            volumes_[parent - 1] += volumes_[position - 1];
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "order.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// Number of orders and their remaining volume per price level of one side of the orderbook. The
+// levels are kept in Fenwick trees over a grid of price ticks, so the totals of all levels better
+// than a price are O(log n). The grid is chosen from the prices on every rebuild: a price which
+// doesn't fit it makes the owner rebuild the index, which is O(n).
+class LevelIndex {
+public:
+    explicit LevelIndex(const OrderTypes& order_type);
+    template <typename TLimitSet>
+    void Rebuild(const TLimitSet& orders);
+    // returns false if the price doesn't fit the grid and the index has to be rebuilt
+    bool Update(const uint64_t& price, const int64_t& count, const int64_t& volume);
+    // the prices are too sparse for the grid, the owner has to answer the queries by itself
+    bool IsValid() const;
+    // count and remaining volume of all orders at the levels strictly better than the price,
+    // the price has to fit the grid
+    std::pair<uint64_t, uint64_t> GetAhead(const uint64_t& price) const;
+
+private:
+    // better levels have smaller keys
+    uint64_t GetKey(const uint64_t& price) const;
+    bool GetPosition(const uint64_t& price, size_t& position) const;
+    void Build(const std::vector<std::pair<uint64_t, uint64_t>>& levels);
+    static const uint64_t min_size_ = 64;
+    static const uint64_t max_size_ = 1 << 20;
+    OrderTypes order_type_;
+    bool is_valid_;
+    uint64_t base_;
+    uint64_t tick_;
+    std::vector<uint64_t> counts_, volumes_;
+    std::vector<std::pair<uint64_t, uint64_t>> buffer_;
+};
+
+template <typename TLimitSet>
+void LevelIndex::Rebuild(const TLimitSet& orders) {
+    buffer_.clear();
+    for (const auto& order : orders) {
+        buffer_.emplace_back(GetKey(order->GetPriceLimit()), order->GetRemainingVolume());
+    }
+    Build(buffer_);
+}
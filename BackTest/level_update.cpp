@@ -0,0 +1,18 @@
+#include "level_update.h"
+
+#include <iostream>
+
+// LevelUpdate
+
+LevelUpdate::LevelUpdate(const uint64_t& timestamp, const OrderTypes& order_type,
+                         const uint64_t& price, const uint64_t& volume)
+    : timestamp(timestamp), order_type(order_type), price(price), volume(volume) {
+}
+
+void LevelUpdate::Print(bool print_name) const {
+    if (print_name) {
+        std::cerr << "LevelUpdate:" << std::endl;
+    }
+    std::cerr << "timestamp = " << timestamp << " order_type = " << ToString(order_type)
+              << " price = " << price << " volume = " << volume << std::endl;
+}
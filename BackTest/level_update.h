@@ -0,0 +1,23 @@
+#pragma once
+
+#include "order.h"
+
+#include <cstdint>
+#include <vector>
+
+// time in ms
+
+// A change of one price level of the historical orderbook: the volume at the price becomes
+// volume, 0 removes the level. The levels which aren't updated keep their volume.
+struct LevelUpdate {
+    uint64_t timestamp;
+    OrderTypes order_type;
+    uint64_t price;
+    uint64_t volume;
+    LevelUpdate() = default;
+    LevelUpdate(const uint64_t& timestamp, const OrderTypes& order_type, const uint64_t& price,
+                const uint64_t& volume);
+    void Print(bool print_name = true) const;
+};
+
+using TLevelUpdateVector = std::vector<LevelUpdate>;
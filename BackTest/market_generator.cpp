@@ -0,0 +1,172 @@
+#include "market_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// appends value / 10^decimals with exactly decimals digits after the dot
+void AppendNumber(std::string& buffer, uint64_t value, const uint64_t& decimals) {
+    char digits[24];
+    size_t size = 0;
+    do {
+        digits[size++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0 || size <= decimals);
+    for (size_t i = size; i > 0; --i) {
+        if (i == decimals) {
+            buffer += '.';
+        }
+        buffer += digits[i - 1];
+    }
+}
+
+// GeneratorStats
+
+GeneratorStats::GeneratorStats() : snapshots(0), transactions(0), bytes(0) {
+}
+
+uint64_t GeneratorStats::GetEvents() const {
+    return snapshots + transactions;
+}
+
+// MarketGenerator
+
+MarketGenerator::MarketGenerator(const GeneratorConfig& config)
+    : config_(config), rnd_(config.seed) {
+    if (config_.snapshot_interval == 0 || config_.depth == 0 || config_.level_step == 0 ||
+        config_.start_price == 0) {
+        throw std::runtime_error(
+            "MarketGenerator::MarketGenerator - snapshot_interval, depth, level_step and "
+            "start_price have to be positive.");
+    }
+    if (config_.min_level_volume == 0 || config_.min_level_volume > config_.max_level_volume) {
+        throw std::runtime_error(
+            "MarketGenerator::MarketGenerator - Incorrect range of the level volumes.");
+    }
+    if (config_.trades_per_second < 0 || config_.volatility < 0 ||
+        config_.trade_size_median <= 0 || config_.trade_size_sigma < 0) {
+        throw std::runtime_error(
+            "MarketGenerator::MarketGenerator - Incorrect parameters of the distributions.");
+    }
+}
+
+GeneratorStats MarketGenerator::Generate(const std::string& path_orderbook,
+                                         const std::string& path_transactions) {
+    static const size_t buffer_size = 1 << 20;
+    static const uint64_t price_decimals = 2;
+    static const uint64_t volume_decimals = 3;
+    std::ofstream orderbook_out(path_orderbook, std::ios::binary);
+    std::ofstream transactions_out(path_transactions, std::ios::binary);
+    if (!orderbook_out.is_open() || !transactions_out.is_open()) {
+        throw std::runtime_error("MarketGenerator::Generate - Failed to open the output files.");
+    }
+    GeneratorStats stats;
+    std::string orderbook_buffer, transactions_buffer;
+    orderbook_buffer.reserve(buffer_size * 2);
+    transactions_buffer.reserve(buffer_size * 2);
+    auto flush = [&stats](std::ofstream& out, std::string& buffer, bool force) {
+        if (force || buffer.size() >= buffer_size) {
+            out.write(buffer.data(), buffer.size());
+            stats.bytes += buffer.size();
+            buffer.clear();
+        }
+    };
+
+    orderbook_buffer += ",timestamp";
+    for (const auto& prefix : {"ap", "av", "bp", "bv"}) {
+        for (uint64_t i = 0; i < config_.depth; ++i) {
+            orderbook_buffer += ',' + std::string(prefix) + std::to_string(i);
+        }
+    }
+    orderbook_buffer += '\n';
+    transactions_buffer += ",server_timestamp,trade_price,trade_size,is_buyer_maker\n";
+
+    std::normal_distribution<double> standard_normal(0, 1);
+    std::uniform_int_distribution<uint64_t> level_volume(config_.min_level_volume,
+                                                         config_.max_level_volume);
+    std::lognormal_distribution<double> trade_size(std::log(config_.trade_size_median),
+                                                   config_.trade_size_sigma);
+    // per ms
+    std::exponential_distribution<double> trade_gap(
+        config_.trades_per_second > 0 ? config_.trades_per_second / 1000 : 1);
+    std::bernoulli_distribution is_buyer_maker(0.5);
+
+    double step_volatility = config_.volatility * std::sqrt(config_.snapshot_interval / 1000.0);
+    double log_price = std::log(config_.start_price);
+    uint64_t min_best_bid = (config_.depth - 1) * config_.level_step + 1;
+    uint64_t end_timestamp = config_.start_timestamp + config_.duration;
+    double next_trade = config_.trades_per_second > 0
+                            ? config_.start_timestamp + trade_gap(rnd_)
+                            : std::numeric_limits<double>::infinity();
+    std::vector<uint64_t> ask_volumes(config_.depth), bid_volumes(config_.depth);
+
+    for (uint64_t timestamp = config_.start_timestamp; timestamp < end_timestamp;
+         timestamp += config_.snapshot_interval) {
+        uint64_t best_bid = std::max<uint64_t>(std::llround(std::exp(log_price)), min_best_bid);
+        uint64_t best_ask = best_bid + config_.level_step;
+        uint64_t ask_volume = 0, bid_volume = 0;
+        for (uint64_t i = 0; i < config_.depth; ++i) {
+            ask_volumes[i] = level_volume(rnd_);
+            bid_volumes[i] = level_volume(rnd_);
+            ask_volume += ask_volumes[i];
+            bid_volume += bid_volumes[i];
+        }
+
+        AppendNumber(orderbook_buffer, stats.snapshots, 0);
+        orderbook_buffer += ',';
+        AppendNumber(orderbook_buffer, timestamp, 0);
+        for (uint64_t i = 0; i < config_.depth; ++i) {
+            orderbook_buffer += ',';
+            AppendNumber(orderbook_buffer, best_ask + i * config_.level_step, price_decimals);
+        }
+        for (const auto& volume : ask_volumes) {
+            orderbook_buffer += ',';
+            AppendNumber(orderbook_buffer, volume, volume_decimals);
+        }
+        for (uint64_t i = 0; i < config_.depth; ++i) {
+            orderbook_buffer += ',';
+            AppendNumber(orderbook_buffer, best_bid - i * config_.level_step, price_decimals);
+        }
+        for (const auto& volume : bid_volumes) {
+            orderbook_buffer += ',';
+            AppendNumber(orderbook_buffer, volume, volume_decimals);
+        }
+        orderbook_buffer += '\n';
+        ++stats.snapshots;
+        flush(orderbook_out, orderbook_buffer, false);
+
+        uint64_t next_snapshot = std::min(timestamp + config_.snapshot_interval, end_timestamp);
+        while (next_trade < next_snapshot) {
+            bool buyer_maker = is_buyer_maker(rnd_);
+            uint64_t& remaining = buyer_maker ? bid_volume : ask_volume;
+            uint64_t size = std::max<int64_t>(std::llround(trade_size(rnd_)), 1);
+            size = std::min(size, remaining);
+            if (size > 0) {
+                AppendNumber(transactions_buffer, stats.transactions, 0);
+                transactions_buffer += ',';
+                AppendNumber(transactions_buffer, static_cast<uint64_t>(next_trade), 0);
+                transactions_buffer += ',';
+                AppendNumber(transactions_buffer, buyer_maker ? best_bid : best_ask,
+                             price_decimals);
+                transactions_buffer += ',';
+                AppendNumber(transactions_buffer, size, volume_decimals);
+                transactions_buffer += buyer_maker ? ",True\n" : ",False\n";
+                remaining -= size;
+                ++stats.transactions;
+            }
+            next_trade += trade_gap(rnd_);
+        }
+        flush(transactions_out, transactions_buffer, false);
+
+        log_price += step_volatility * standard_normal(rnd_);
+    }
+    flush(orderbook_out, orderbook_buffer, true);
+    flush(transactions_out, transactions_buffer, true);
+    if (!orderbook_out || !transactions_out) {
+        throw std::runtime_error("MarketGenerator::Generate - Failed to write the output files.");
+    }
+    return stats;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+// time in ms, prices in cents, volumes in thousandths
+struct GeneratorConfig {
+    uint64_t seed = 1791791791;
+    uint64_t start_timestamp = 1603659600000;
+    uint64_t duration = 3600000;
+    // distance between two orderbook snapshots
+    uint64_t snapshot_interval = 500;
+    // mean of the poisson arrivals of the trades
+    double trades_per_second = 20;
+    // levels per side of a snapshot
+    uint64_t depth = 50;
+    // distance between two neighbouring levels
+    uint64_t level_step = 1;
+    uint64_t start_price = 40753;
+    // standard deviation of the log mid price change per second
+    double volatility = 0.0005;
+    // volumes of the levels are uniform in [min_level_volume, max_level_volume]
+    uint64_t min_level_volume = 5000;
+    uint64_t max_level_volume = 200000;
+    // trade sizes are lognormal
+    double trade_size_median = 100;
+    double trade_size_sigma = 1.5;
+};
+
+struct GeneratorStats {
+    uint64_t snapshots;
+    uint64_t transactions;
+    uint64_t bytes;
+    GeneratorStats();
+    uint64_t GetEvents() const;
+};
+
+// Writes an orderbook and a transactions file in the formats read by Scanner. The mid price is a
+// geometric random walk sampled at every snapshot, the trades hit the best level of the last
+// snapshot and never take more volume than is left in its side, so the files can be replayed by
+// BackTest. Both files are streamed through fixed size buffers, the memory doesn't depend on
+// the duration.
+class MarketGenerator {
+public:
+    explicit MarketGenerator(const GeneratorConfig& config);
+    GeneratorStats Generate(const std::string& path_orderbook,
+                            const std::string& path_transactions);
+
+private:
+    GeneratorConfig config_;
+    std::mt19937_64 rnd_;
+};
@@ -0,0 +1,165 @@
+#include "order_tracker.h"
+
+#include <iostream>
+#include <stdexcept>
+
+std::string ToString(const OrderStates& order_state) {
+    switch (order_state) {
+        case ORDER_PENDING:
+            return "pending";
+        case ORDER_OPEN:
+            return "open";
+        case ORDER_PARTIALLY_FILLED:
+            return "partially_filled";
+        case ORDER_PENDING_CANCEL:
+            return "pending_cancel";
+    }
+    throw std::runtime_error("ToString - Incorrect order_state.");
+}
+
+std::string ToString(const OrderChanges& order_change) {
+    switch (order_change) {
+        case CHANGE_ACK:
+            return "ack";
+        case CHANGE_FILL:
+            return "fill";
+        case CHANGE_CANCEL:
+            return "cancel";
+        case CHANGE_CLOSE:
+            return "close";
+    }
+    throw std::runtime_error("ToString - Incorrect order_change.");
+}
+
+// ActiveOrder
+
+ActiveOrder::ActiveOrder(const uint64_t& order_id, const OrderTypes& order_type,
+                         const uint64_t& volume, const uint64_t& price_limit,
+                         const bool& is_market)
+    : order_id(order_id),
+      order_type(order_type),
+      volume(volume),
+      remaining_volume(volume),
+      price_limit(price_limit),
+      is_market(is_market),
+      state(ORDER_PENDING) {
+}
+
+void ActiveOrder::Print(bool print_name) const {
+    if (print_name) {
+        std::cerr << "ActiveOrder:" << std::endl;
+    }
+    std::cerr << "order_id = " << order_id << " order_type = " << ToString(order_type)
+              << " volume = " << volume << " remaining_volume = " << remaining_volume
+              << " price_limit = " << price_limit << " is_market = " << is_market
+              << " state = " << ToString(state) << std::endl;
+}
+
+// OrderChange
+
+OrderChange::OrderChange(const uint64_t& timestamp, const uint64_t& order_id,
+                         const OrderChanges& order_change, const uint64_t& volume,
+                         const uint64_t& price)
+    : timestamp(timestamp),
+      order_id(order_id),
+      order_change(order_change),
+      volume(volume),
+      price(price) {
+}
+
+void OrderChange::Print(bool print_name) const {
+    if (print_name) {
+        std::cerr << "OrderChange:" << std::endl;
+    }
+    std::cerr << "timestamp = " << timestamp << " order_id = " << order_id
+              << " order_change = " << ToString(order_change) << " volume = " << volume
+              << " price = " << price << std::endl;
+}
+
+// OrderTracker
+
+void OrderTracker::AddOrder(const uint64_t& order_id, const OrderTypes& order_type,
+                            const uint64_t& volume, const uint64_t& price_limit,
+                            const bool& is_market) {
+    if (!active_orders_
+             .emplace(order_id, ActiveOrder(order_id, order_type, volume, price_limit, is_market))
+             .second) {
+        throw std::runtime_error("OrderTracker::AddOrder - The order is already active.");
+    }
+}
+
+void OrderTracker::RequestCancel(const uint64_t& order_id) {
+    auto it = active_orders_.find(order_id);
+    if (it != active_orders_.end() && !it->second.is_market) {
+        it->second.state = ORDER_PENDING_CANCEL;
+    }
+}
+
+void OrderTracker::Acknowledge(const uint64_t& timestamp, const uint64_t& order_id) {
+    auto it = active_orders_.find(order_id);
+    if (it == active_orders_.end()) {
+        throw std::runtime_error("OrderTracker::Acknowledge - The order isn't active.");
+    }
+    // a withdraw sent before the ack keeps the order pending cancel
+    if (it->second.state == ORDER_PENDING) {
+        it->second.state = ORDER_OPEN;
+    }
+    changes_.emplace_back(timestamp, order_id, CHANGE_ACK, it->second.remaining_volume);
+}
+
+void OrderTracker::Fill(const uint64_t& order_id, const CompletedTransaction& transaction) {
+    auto it = active_orders_.find(order_id);
+    if (it == active_orders_.end()) {
+        throw std::runtime_error("OrderTracker::Fill - The order isn't active.");
+    }
+    auto& order = it->second;
+    if (transaction.GetVolume() > order.remaining_volume) {
+        throw std::runtime_error("OrderTracker::Fill - The fill is larger than the order.");
+    }
+    order.remaining_volume -= transaction.GetVolume();
+    if (order.state != ORDER_PENDING_CANCEL) {
+        order.state = ORDER_PARTIALLY_FILLED;
+    }
+    changes_.emplace_back(transaction.GetTransactionTimestamp(), order_id, CHANGE_FILL,
+                          transaction.GetVolume(), transaction.GetPrice());
+    if (order.remaining_volume == 0) {
+        Close(it, transaction.GetTransactionTimestamp(), CHANGE_CLOSE);
+    }
+}
+
+void OrderTracker::Cancel(const uint64_t& timestamp, const uint64_t& order_id) {
+    auto it = active_orders_.find(order_id);
+    if (it != active_orders_.end()) {
+        Close(it, timestamp, CHANGE_CANCEL);
+    }
+}
+
+void OrderTracker::CloseMarketOrder(const uint64_t& timestamp, const uint64_t& order_id) {
+    auto it = active_orders_.find(order_id);
+    if (it != active_orders_.end()) {
+        Close(it, timestamp, CHANGE_CLOSE);
+    }
+}
+
+void OrderTracker::ClearChanges() {
+    changes_.clear();
+}
+
+const TActiveOrders& OrderTracker::GetActiveOrders() const {
+    return active_orders_;
+}
+
+const ActiveOrder* OrderTracker::FindActiveOrder(const uint64_t& order_id) const {
+    auto it = active_orders_.find(order_id);
+    return it == active_orders_.end() ? nullptr : &it->second;
+}
+
+const TOrderChanges& OrderTracker::GetChanges() const {
+    return changes_;
+}
+
+void OrderTracker::Close(const TActiveOrders::iterator& it, const uint64_t& timestamp,
+                         const OrderChanges& order_change) {
+    changes_.emplace_back(timestamp, it->first, order_change, it->second.remaining_volume);
+    active_orders_.erase(it);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "completed_transaction.h"
+#include "order.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// time in ms
+
+enum OrderStates {
+    ORDER_PENDING,           // the order was sent and hasn't reached the orderbook yet
+    ORDER_OPEN,              // the order is in the orderbook without fills
+    ORDER_PARTIALLY_FILLED,  // the order is in the orderbook and has fills
+    ORDER_PENDING_CANCEL     // a withdraw was sent and hasn't reached the orderbook yet
+};
+
+std::string ToString(const OrderStates& order_state);
+
+enum OrderChanges {
+    CHANGE_ACK,     // the order reached the orderbook
+    CHANGE_FILL,    // the order received a fill
+    CHANGE_CANCEL,  // the withdraw reached the orderbook, the order isn't active anymore
+    CHANGE_CLOSE    // the order was filled, or a market order ran out of liquidity
+};
+
+std::string ToString(const OrderChanges& order_change);
+
+// price_limit is 0 for market orders
+struct ActiveOrder {
+    uint64_t order_id;
+    OrderTypes order_type;
+    uint64_t volume;
+    uint64_t remaining_volume;
+    uint64_t price_limit;
+    bool is_market;
+    OrderStates state;
+    ActiveOrder() = default;
+    ActiveOrder(const uint64_t& order_id, const OrderTypes& order_type, const uint64_t& volume,
+                const uint64_t& price_limit, const bool& is_market);
+    void Print(bool print_name = true) const;
+};
+
+// volume is the filled volume for CHANGE_FILL and the remaining volume otherwise, price is 0
+// unless it is a fill
+struct OrderChange {
+    uint64_t timestamp;
+    uint64_t order_id;
+    OrderChanges order_change;
+    uint64_t volume;
+    uint64_t price;
+    OrderChange() = default;
+    OrderChange(const uint64_t& timestamp, const uint64_t& order_id,
+                const OrderChanges& order_change, const uint64_t& volume,
+                const uint64_t& price = 0);
+    void Print(bool print_name = true) const;
+};
+
+using TActiveOrders = std::map<uint64_t, ActiveOrder>;
+using TOrderChanges = std::vector<OrderChange>;
+
+// The user orders which can still change and the changes since the last ClearChanges. An order
+// leaves the active set as soon as it is filled or canceled, so reading either costs nothing for
+// the orders which are done, unlike GetUserLimitAsk and GetUserLimitBid which keep every order.
+class OrderTracker {
+public:
+    OrderTracker() = default;
+    void AddOrder(const uint64_t& order_id, const OrderTypes& order_type, const uint64_t& volume,
+                  const uint64_t& price_limit, const bool& is_market);
+    // a withdraw of an order which isn't active is ignored, the orderbook ignores it too
+    void RequestCancel(const uint64_t& order_id);
+    void Acknowledge(const uint64_t& timestamp, const uint64_t& order_id);
+    void Fill(const uint64_t& order_id, const CompletedTransaction& transaction);
+    void Cancel(const uint64_t& timestamp, const uint64_t& order_id);
+    // a market order is done after its matching even if it wasn't filled completely
+    void CloseMarketOrder(const uint64_t& timestamp, const uint64_t& order_id);
+    void ClearChanges();
+    const TActiveOrders& GetActiveOrders() const;
+    // nullptr if the order isn't active
+    const ActiveOrder* FindActiveOrder(const uint64_t& order_id) const;
+    const TOrderChanges& GetChanges() const;
+
+private:
+    void Close(const TActiveOrders::iterator& it, const uint64_t& timestamp,
+               const OrderChanges& order_change);
+    TActiveOrders active_orders_;
+    TOrderChanges changes_;
+};
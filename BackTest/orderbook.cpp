@@ -2,12 +2,109 @@
 
 #include <algorithm>
 #include <iostream>
+#include <tuple>
+
+// UserFill
+
+UserFill::UserFill(const TBase& order, const TTransaction& transaction)
+    : order(order), transaction(transaction) {
+}
+
+// Quote
+
+Quote::Quote() : bid_price(0), bid_volume(0), ask_price(0), ask_volume(0) {
+}
+
+bool Quote::HasBid() const {
+    return bid_volume > 0;
+}
+
+bool Quote::HasAsk() const {
+    return ask_volume > 0;
+}
+
+void Quote::Print(bool print_name) const {
+    if (print_name) {
+        std::cerr << "Quote:" << std::endl;
+    }
+    std::cerr << "bid_price = " << bid_price << " bid_volume = " << bid_volume
+              << " ask_price = " << ask_price << " ask_volume = " << ask_volume << std::endl;
+}
+
+// DepthView
+
+DepthView::DepthView(const BookLevels& ask, const BookLevels& bid, const size_t& depth)
+    : ask_prices(ask.prices.data()),
+      ask_volumes(ask.volumes.data()),
+      ask_depth(std::min(depth, ask.Size())),
+      bid_prices(bid.prices.data()),
+      bid_volumes(bid.volumes.data()),
+      bid_depth(std::min(depth, bid.Size())) {
+}
 
 // OrderBook
 
+OrderBook::OrderBook()
+    : ask_index_(ASK),
+      bid_index_(BID),
+      is_lazy_allowed_(true),
+      is_lazy_(true),
+      is_materialized_(true),
+      has_level_updates_(false),
+      levels_depth_(0) {
+}
+
+void OrderBook::SetLazyMode(bool is_lazy) {
+    is_lazy_allowed_ = is_lazy;
+    if (!is_lazy_allowed_ && is_lazy_) {
+        LeaveLazyMode();
+    } else if (is_lazy_allowed_ && !is_lazy_ && !has_level_updates_ && !HasUserOrders()) {
+        EnterLazyMode();
+    }
+}
+
+bool OrderBook::IsLazy() const {
+    return is_lazy_;
+}
+
 void OrderBook::UpdateOrderBook(const TLimitVector& new_ask, const TLimitVector& new_bid) {
-    UpdateOrders(new_ask, ask_, historical_ask_);
-    UpdateOrders(new_bid, bid_, historical_bid_);
+    BACKTEST_STATS(ScopedTimer timer(stats_.stages[UPDATE_ORDER_BOOK]));
+    BACKTEST_ALLOCATION_SCOPE(ORDERBOOK_UPDATE);
+    levels_depth_ = 0;
+    if (is_lazy_) {
+        UpdateLazyOrders<TAskLimitSet>(new_ask, lazy_ask_, historical_ask_);
+        UpdateLazyOrders<TBidLimitSet>(new_bid, lazy_bid_, historical_bid_);
+        is_materialized_ = false;
+        BACKTEST_STATS(stats_.book_size.Add(lazy_ask_.size() + lazy_bid_.size()));
+        return;
+    }
+    UpdateOrders(new_ask, ask_, ask_index_, historical_ask_);
+    UpdateOrders(new_bid, bid_, bid_index_, historical_bid_);
+    BACKTEST_STATS(stats_.book_size.Add(ask_.size() + bid_.size()));
+    // the snapshot drops the closed user orders
+    if (is_lazy_allowed_ && !has_level_updates_ && !HasUserOrders()) {
+        EnterLazyMode();
+    }
+}
+
+void OrderBook::UpdateLevel(const LevelUpdate& update) {
+    BACKTEST_STATS(ScopedTimer timer(stats_.stages[UPDATE_LEVEL]));
+    BACKTEST_ALLOCATION_SCOPE(ORDERBOOK_UPDATE);
+    if (update.order_type != ASK && update.order_type != BID) {
+        throw std::runtime_error("OrderBook::UpdateLevel - Incorrect order_type.");
+    }
+    levels_depth_ = 0;
+    // an update in the sorted vectors would shift the side, so the sets hold the orders from the
+    // first update on
+    has_level_updates_ = true;
+    if (is_lazy_) {
+        LeaveLazyMode();
+    }
+    if (update.order_type == ASK) {
+        UpdateLevel(update, ask_, ask_index_);
+    } else {
+        UpdateLevel(update, bid_, bid_index_);
+    }
 }
 
 auto find(const TLimitVector& orders, uint64_t price_limit) {
@@ -19,7 +116,7 @@ auto find(const TLimitVector& orders, uint64_t price_limit) {
 
 template <typename TLimitSet>
 void OrderBook::UpdateOrders(TLimitVector cur_orders, TLimitSet& old_orderbook,
-                             TLimitVector& historical_orders) {
+                             LevelIndex& index, TLimitVector& historical_orders) {
     TLimitSet new_orderbook;
     TLimitVector new_orders;
     for (const auto& order : old_orderbook) {
@@ -51,21 +148,130 @@ void OrderBook::UpdateOrders(TLimitVector cur_orders, TLimitSet& old_orderbook,
     }
     old_orderbook = new_orderbook;
     historical_orders = new_orders;
+    index.Rebuild(old_orderbook);
+}
+
+template <typename TLimitSet>
+void OrderBook::UpdateLazyOrders(TLimitVector cur_orders, TLimitVector& orders,
+                                 TLimitVector& historical_orders) {
+    TLimitVector new_orders;
+    // an order of the previous book is kept only on an empty level of the snapshot
+    bool has_empty_level = std::any_of(cur_orders.begin(), cur_orders.end(),
+                                       [](const TLimit& order) { return order->GetVolume() == 0; });
+    for (size_t i = 0; has_empty_level && i < orders.size(); ++i) {
+        const auto& order = orders[i];
+        if (order->IsClosed()) {
+            continue;
+        }
+        auto it = find(cur_orders, order->GetPriceLimit());
+        if (it == cur_orders.end() || (*it)->GetVolume() > 0) {
+            continue;
+        }
+        TLimit& cur_order = cur_orders[it - cur_orders.begin()];
+        uint64_t order_volume = std::min(cur_order->GetVolume(), order->GetVolume());
+        new_orders.emplace_back(
+            std::make_shared<LimitOrder>(-1, order->GetSubmitTimestamp(), order->GetOrderType(),
+                                         order_volume, order->GetPriceLimit()));
+        cur_order->SetVolume(cur_order->GetVolume() - order_volume);
+    }
+    for (const auto& order : cur_orders) {
+        if (!order->IsClosed()) {
+            new_orders.emplace_back(order);
+        }
+    }
+    // the same orders in the same order as in the set: it keeps the first of the equal orders
+    typename TLimitSet::key_compare comparator;
+    orders = new_orders;
+    if (!std::is_sorted(orders.begin(), orders.end(), comparator)) {
+        std::stable_sort(orders.begin(), orders.end(), comparator);
+    }
+    orders.erase(std::unique(orders.begin(), orders.end(),
+                             [&comparator](const TLimit& lhs, const TLimit& rhs) {
+                                 return !comparator(lhs, rhs) && !comparator(rhs, lhs);
+                             }),
+                 orders.end());
+    historical_orders = std::move(new_orders);
+}
+
+template <typename TLimitSet>
+void OrderBook::UpdateLevel(const LevelUpdate& update, TLimitSet& orders, LevelIndex& index) {
+    // the first and the last possible orders of the level
+    LimitOrder first_order(0, 0, update.order_type, 0, update.price);
+    LimitOrder last_order(-1, -1, update.order_type, 0, update.price);
+    auto it = orders.lower_bound(TLimit(TLimit(), &first_order));
+    auto level_end = orders.upper_bound(TLimit(TLimit(), &last_order));
+    int64_t count = 0, volume = 0;
+    while (it != level_end) {
+        if ((*it)->GetOrderId() == -1) {
+            --count;
+            volume -= (*it)->GetRemainingVolume();
+            it = orders.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (update.volume > 0) {
+        orders.insert(std::make_shared<LimitOrder>(-1, update.timestamp, update.order_type,
+                                                   update.volume, update.price));
+        ++count;
+        volume += update.volume;
+    }
+    UpdateIndex(orders, &index, update.price, count, volume);
+}
+
+bool OrderBook::HasUserOrders() const {
+    auto is_user_order = [](const TLimit& order) { return order->GetOrderId() != -1; };
+    return std::any_of(ask_.begin(), ask_.end(), is_user_order) ||
+           std::any_of(bid_.begin(), bid_.end(), is_user_order);
+}
+
+void OrderBook::EnterLazyMode() {
+    lazy_ask_.assign(ask_.begin(), ask_.end());
+    lazy_bid_.assign(bid_.begin(), bid_.end());
+    is_lazy_ = true;
+    is_materialized_ = true;
+}
+
+void OrderBook::LeaveLazyMode() {
+    Materialize();
+    lazy_ask_.clear();
+    lazy_bid_.clear();
+    is_lazy_ = false;
+}
+
+void OrderBook::Materialize() const {
+    if (!is_lazy_ || is_materialized_) {
+        return;
+    }
+    BACKTEST_ALLOCATION_SCOPE(ORDERBOOK_UPDATE);
+    ask_ = TAskLimitSet(lazy_ask_.begin(), lazy_ask_.end());
+    bid_ = TBidLimitSet(lazy_bid_.begin(), lazy_bid_.end());
+    ask_index_.Rebuild(ask_);
+    bid_index_.Rebuild(bid_);
+    is_materialized_ = true;
 }
 
 void OrderBook::AddUserLimitOrder(const uint64_t& order_id, const uint64_t& submit_timestamp,
                                   const OrderTypes& order_type, const uint64_t& volume,
                                   const uint64_t& price_limit) {
+    BACKTEST_STATS(ScopedTimer timer(stats_.stages[ADD_USER_LIMIT_ORDER]));
+    BACKTEST_ALLOCATION_SCOPE(USER_ORDERS);
     TLimit limit_order =
         std::make_shared<LimitOrder>(order_id, submit_timestamp, order_type, volume, price_limit);
     all_user_orders_[order_id] = limit_order;
+    levels_depth_ = 0;
+    if (is_lazy_) {
+        LeaveLazyMode();
+    }
     // Q: Add checker for incorrect price_limit?
     if (order_type == ASK) {
         user_limit_ask_.emplace_back(limit_order);
         ask_.insert(limit_order);
+        UpdateIndex(ask_, &ask_index_, price_limit, 1, volume);
     } else if (order_type == BID) {
         user_limit_bid_.emplace_back(limit_order);
         bid_.insert(limit_order);
+        UpdateIndex(bid_, &bid_index_, price_limit, 1, volume);
     } else {
         throw std::runtime_error("OrderBook::AddUserLimitOrder - Incorrect order_type.");
     }
@@ -73,14 +279,29 @@ void OrderBook::AddUserLimitOrder(const uint64_t& order_id, const uint64_t& subm
 
 void OrderBook::CompleteUserMarketOrder(const uint64_t& order_id, const uint64_t& submit_timestamp,
                                         const OrderTypes& order_type, const uint64_t& volume) {
+    BACKTEST_STATS(ScopedTimer timer(stats_.stages[COMPLETE_USER_MARKET_ORDER]));
+    BACKTEST_ALLOCATION_SCOPE(MATCHING);
+    BACKTEST_STATS(uint64_t transactions_before = market_transactions_.GetTotalCount());
     TMarket market_order =
         std::make_shared<MarketOrder>(order_id, submit_timestamp, order_type, volume);
     all_user_orders_[order_id] = market_order;
+    last_user_fills_.clear();
+    levels_depth_ = 0;
+    // a market order doesn't rest in the book, so the lazy mode goes on
+    bool is_lazy = is_lazy_ && !is_materialized_;
     if (order_type == ASK) {
-        CompleteUserMarketOrder(market_order, bid_, true);
+        if (is_lazy) {
+            CompleteUserMarketOrder(market_order, lazy_bid_, nullptr, true);
+        } else {
+            CompleteUserMarketOrder(market_order, bid_, &bid_index_, true);
+        }
         user_market_ask_.emplace_back(market_order);
     } else if (order_type == BID) {
-        CompleteUserMarketOrder(market_order, ask_, false);
+        if (is_lazy) {
+            CompleteUserMarketOrder(market_order, lazy_ask_, nullptr, false);
+        } else {
+            CompleteUserMarketOrder(market_order, ask_, &ask_index_, false);
+        }
         user_market_bid_.emplace_back(market_order);
     } else {
         throw std::runtime_error("OrderBook::CompleteUserMarketOrder - Incorrect order_type.");
@@ -88,10 +309,11 @@ void OrderBook::CompleteUserMarketOrder(const uint64_t& order_id, const uint64_t
     if (!market_order->IsClosed()) {
         throw std::runtime_error("OrderBook::CompleteUserMarketOrder - Order is too big.");
     }
+    BACKTEST_STATS(stats_.fills.Add(market_transactions_.GetTotalCount() - transactions_before));
 }
 
-template <typename TLimitSet>
-void OrderBook::CompleteUserMarketOrder(TMarket market_order, TLimitSet& orders,
+template <typename TOrders>
+void OrderBook::CompleteUserMarketOrder(TMarket market_order, TOrders& orders, LevelIndex* index,
                                         const bool is_buyer_maker) {
     for (auto it = orders.begin(); it != orders.end() && !market_order->IsClosed(); ++it) {
         auto cur_pointer = *it;
@@ -102,60 +324,110 @@ void OrderBook::CompleteUserMarketOrder(TMarket market_order, TLimitSet& orders,
                 market_order->GetSubmitTimestamp(), transaction_volume,
                 cur_pointer->GetPriceLimit(), is_buyer_maker);
             cur_pointer->AddTransaction(transaction);
+            UpdateIndex(orders, index, cur_pointer->GetPriceLimit(), 0,
+                        -static_cast<int64_t>(transaction_volume));
             market_order->AddTransaction(transaction);
-            market_transactions_.emplace_back(transaction);
+            market_transactions_.Add(transaction, market_order->GetOrderId());
+            last_user_fills_.emplace_back(market_order, transaction);
         }
     }
 }
 
-void OrderBook::CompleteMarketTransaction(const CompletedTransaction& transaction) {
+void OrderBook::CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                          const TPrintEnds& print_ends) {
+    BACKTEST_STATS(ScopedTimer timer(stats_.stages[COMPLETE_MARKET_TRANSACTION]));
+    BACKTEST_ALLOCATION_SCOPE(MATCHING);
+    BACKTEST_STATS(uint64_t transactions_before = market_transactions_.GetTotalCount());
+    last_user_fills_.clear();
+    levels_depth_ = 0;
+    // the vectors share the orders with the sets, so a materialized book is updated in place
+    bool is_lazy = is_lazy_ && !is_materialized_;
     if (transaction.GetIsBuyerMaker()) {
-        CompleteMarketTransaction(transaction, bid_);
+        if (is_lazy) {
+            CompleteMarketTransaction(transaction, print_ends, lazy_bid_, nullptr);
+        } else {
+            CompleteMarketTransaction(transaction, print_ends, bid_, &bid_index_);
+        }
     } else {
-        CompleteMarketTransaction(transaction, ask_);
+        if (is_lazy) {
+            CompleteMarketTransaction(transaction, print_ends, lazy_ask_, nullptr);
+        } else {
+            CompleteMarketTransaction(transaction, print_ends, ask_, &ask_index_);
+        }
     }
+    BACKTEST_STATS(stats_.fills.Add(market_transactions_.GetTotalCount() - transactions_before));
 }
 
 uint64_t OrderBook::AddNewOrder() {
+    BACKTEST_ALLOCATION_SCOPE(USER_ORDERS);
     all_user_orders_.push_back(nullptr);
     return all_user_orders_.size() - 1;
 }
 
+void OrderBook::ReserveOrderId(const uint64_t& order_id) {
+    BACKTEST_ALLOCATION_SCOPE(USER_ORDERS);
+    if (order_id >= all_user_orders_.size()) {
+        all_user_orders_.resize(order_id + 1);
+    }
+}
+
 void OrderBook::RemoveOrder(const uint64_t& order_id) {
+    BACKTEST_STATS(ScopedTimer timer(stats_.stages[REMOVE_ORDER]));
+    BACKTEST_ALLOCATION_SCOPE(USER_ORDERS);
     auto order = static_cast<LimitOrder*>(all_user_orders_[order_id].get());
     if (order->IsClosed()) {
         return;
     }
     order->CancelOrder();
+    levels_depth_ = 0;
     auto ptr = std::make_shared<LimitOrder>(order->GetOrderId(), order->GetSubmitTimestamp(),
                                             order->GetOrderType(), order->GetVolume(),
                                             order->GetPriceLimit());
+    int64_t remaining_volume = order->GetRemainingVolume();
     if (ptr->GetOrderType() == ASK) {
-        ask_.erase(ptr);
+        if (ask_.erase(ptr) > 0) {
+            UpdateIndex(ask_, &ask_index_, ptr->GetPriceLimit(), -1, -remaining_volume);
+        }
     } else if (ptr->GetOrderType() == BID) {
-        bid_.erase(ptr);
+        if (bid_.erase(ptr) > 0) {
+            UpdateIndex(bid_, &bid_index_, ptr->GetPriceLimit(), -1, -remaining_volume);
+        }
     } else {
         throw std::runtime_error("OrderBook::RemoveOrder - Incorrect order_type.");
     }
 }
 
-template <typename TLimitSet>
+template <typename TOrders>
 void OrderBook::CompleteMarketTransaction(const CompletedTransaction& transaction,
-                                          TLimitSet& orders) {
+                                          const TPrintEnds& print_ends, TOrders& orders,
+                                          LevelIndex* index) {
     uint64_t current_volume = transaction.GetVolume();
 
     for (auto it = orders.begin(); it != orders.end() && current_volume > 0; ++it) {
         auto cur_pointer = *it;
         // Q: Maybe there have to be another condition?
         if (!cur_pointer->IsClosed()) {
-            uint64_t transaction_volume =
-                std::min(current_volume, cur_pointer->GetRemainingVolume());
-            TTransaction current_transaction = std::make_shared<CompletedTransaction>(
-                transaction.GetTransactionTimestamp(), transaction_volume,
-                cur_pointer->GetPriceLimit(), transaction.GetIsBuyerMaker());
-            cur_pointer->AddTransaction(current_transaction);
-            current_volume -= transaction_volume;
-            market_transactions_.emplace_back(current_transaction);
+            uint64_t order_volume = std::min(current_volume, cur_pointer->GetRemainingVolume());
+            UpdateIndex(orders, index, cur_pointer->GetPriceLimit(), 0,
+                        -static_cast<int64_t>(order_volume));
+            bool is_user_order = cur_pointer->GetOrderId() != -1;
+            while (order_volume > 0) {
+                uint64_t transaction_volume =
+                    is_user_order ? GetPrintPart(print_ends,
+                                                 transaction.GetVolume() - current_volume,
+                                                 order_volume)
+                                  : order_volume;
+                TTransaction current_transaction = std::make_shared<CompletedTransaction>(
+                    transaction.GetTransactionTimestamp(), transaction_volume,
+                    cur_pointer->GetPriceLimit(), transaction.GetIsBuyerMaker());
+                cur_pointer->AddTransaction(current_transaction);
+                order_volume -= transaction_volume;
+                current_volume -= transaction_volume;
+                market_transactions_.Add(current_transaction, cur_pointer->GetOrderId());
+                if (is_user_order) {
+                    last_user_fills_.emplace_back(cur_pointer, current_transaction);
+                }
+            }
         }
     }
     if (current_volume > 0) {
@@ -171,14 +443,147 @@ TBase OrderBook::GetOrderInfo(const uint64_t& order_id) const {
     return all_user_orders_[order_id];
 }
 
+uint64_t OrderBook::GetOrderPosition(const uint64_t& order_id) const {
+    return GetAhead(order_id).first;
+}
+
+uint64_t OrderBook::GetVolumeAhead(const uint64_t& order_id) const {
+    return GetAhead(order_id).second;
+}
+
+std::pair<uint64_t, uint64_t> OrderBook::GetAhead(const uint64_t& order_id) const {
+    auto order = std::dynamic_pointer_cast<LimitOrder>(GetOrderInfo(order_id));
+    // no user order is in the book in the lazy mode
+    if (!order || is_lazy_) {
+        return {-1, -1};
+    }
+    bool is_in_book = order->GetOrderType() == ASK ? ask_.count(order) > 0
+                                                   : bid_.count(order) > 0;
+    if (!is_in_book) {
+        return {-1, -1};
+    }
+    return GetAhead(order);
+}
+
+std::pair<uint64_t, uint64_t> OrderBook::GetAhead(const TLimit& order) const {
+    if (order->GetOrderType() == ASK) {
+        return is_lazy_ ? GetLazyAhead<TAskLimitSet>(lazy_ask_, order)
+                        : GetAhead(ask_, ask_index_, order);
+    } else if (order->GetOrderType() == BID) {
+        return is_lazy_ ? GetLazyAhead<TBidLimitSet>(lazy_bid_, order)
+                        : GetAhead(bid_, bid_index_, order);
+    } else {
+        throw std::runtime_error("OrderBook::GetAhead - Incorrect order_type.");
+    }
+}
+
+template <typename TLimitSet>
+std::pair<uint64_t, uint64_t> OrderBook::GetAhead(const TLimitSet& orders,
+                                                  const LevelIndex& index,
+                                                  const TLimit& order) const {
+    auto it = orders.lower_bound(order);
+    uint64_t count = 0, volume = 0;
+    auto level_begin = orders.begin();
+    if (index.IsValid() && !orders.empty()) {
+        // the prices of the orderbook fit the index, the price of the order doesn't have to
+        uint64_t price = (it != orders.end() ? *it : *orders.rbegin())->GetPriceLimit();
+        std::tie(count, volume) = index.GetAhead(price);
+        // the first possible order of the level: the smallest timestamp and order_id
+        LimitOrder level_order(0, 0, order->GetOrderType(), 0, price);
+        level_begin = orders.lower_bound(TLimit(TLimit(), &level_order));
+    }
+    for (; level_begin != it; ++level_begin) {
+        ++count;
+        volume += (*level_begin)->GetRemainingVolume();
+    }
+    return {count, volume};
+}
+
+template <typename TLimitSet>
+std::pair<uint64_t, uint64_t> OrderBook::GetLazyAhead(const TLimitVector& orders,
+                                                      const TLimit& order) {
+    typename TLimitSet::key_compare comparator;
+    auto position = std::lower_bound(orders.begin(), orders.end(), order, comparator);
+    uint64_t volume = 0;
+    for (auto it = orders.begin(); it != position; ++it) {
+        volume += (*it)->GetRemainingVolume();
+    }
+    return {position - orders.begin(), volume};
+}
+
+template <typename TOrders>
+void OrderBook::UpdateIndex(const TOrders& orders, LevelIndex* index, const uint64_t& price,
+                            const int64_t& count, const int64_t& volume) {
+    if (index && !index->Update(price, count, volume)) {
+        index->Rebuild(orders);
+    }
+}
+
 const TAskLimitSet& OrderBook::GetAsk() const {
+    Materialize();
     return ask_;
 }
 
 const TBidLimitSet& OrderBook::GetBid() const {
+    Materialize();
     return bid_;
 }
 
+const TLimitVector* OrderBook::GetLazyAsk() const {
+    return is_lazy_ ? &lazy_ask_ : nullptr;
+}
+
+const TLimitVector* OrderBook::GetLazyBid() const {
+    return is_lazy_ ? &lazy_bid_ : nullptr;
+}
+
+const BookLevels& OrderBook::GetAskLevels() const {
+    UpdateLevels(-1);
+    return ask_levels_;
+}
+
+const BookLevels& OrderBook::GetBidLevels() const {
+    UpdateLevels(-1);
+    return bid_levels_;
+}
+
+const Quote& OrderBook::GetQuote() const {
+    UpdateLevels(1);
+    return quote_;
+}
+
+DepthView OrderBook::GetDepth(const size_t& depth) const {
+    UpdateLevels(depth);
+    return DepthView(ask_levels_, bid_levels_, depth);
+}
+
+void OrderBook::UpdateLevels(const size_t& depth) const {
+    // the quote needs the first level
+    size_t levels_depth = std::max<size_t>(depth, 1);
+    if (levels_depth_ >= levels_depth) {
+        return;
+    }
+    BACKTEST_ALLOCATION_SCOPE(ORDERBOOK_UPDATE);
+    // the vectors hold the same orders in the same order as the sets
+    if (is_lazy_) {
+        FillBookLevels(lazy_ask_, levels_depth, ask_levels_);
+        FillBookLevels(lazy_bid_, levels_depth, bid_levels_);
+    } else {
+        FillBookLevels(ask_, levels_depth, ask_levels_);
+        FillBookLevels(bid_, levels_depth, bid_levels_);
+    }
+    quote_ = Quote();
+    if (ask_levels_.Size() > 0) {
+        quote_.ask_price = ask_levels_.prices[0];
+        quote_.ask_volume = ask_levels_.volumes[0];
+    }
+    if (bid_levels_.Size() > 0) {
+        quote_.bid_price = bid_levels_.prices[0];
+        quote_.bid_volume = bid_levels_.volumes[0];
+    }
+    levels_depth_ = levels_depth;
+}
+
 const TLimitVector& OrderBook::GetUserLimitAsk() const {
     return user_limit_ask_;
 }
@@ -195,10 +600,30 @@ const TMarketVector& OrderBook::GetUserMarketBid() const {
     return user_market_bid_;
 }
 
-const TTransactionVector& OrderBook::GetMarketTransactions() const {
+const TradeHistory& OrderBook::GetMarketTransactions() const {
     return market_transactions_;
 }
 
+void OrderBook::SetTradeRetention(const RetentionConfig& config) {
+    if (market_transactions_.GetTotalCount() > 0) {
+        throw std::runtime_error(
+            "OrderBook::SetTradeRetention - Retention has to be set before the first transaction.");
+    }
+    market_transactions_ = TradeHistory(config);
+}
+
+void OrderBook::FlushTradeLog() {
+    market_transactions_.Flush();
+}
+
+const TUserFillVector& OrderBook::GetLastUserFills() const {
+    return last_user_fills_;
+}
+
+const OrderBookStats& OrderBook::GetStats() const {
+    return stats_;
+}
+
 void OrderBook::Print(bool print_name) const {
     if (print_name) {
         std::cerr << "OrderBook:" << std::endl;
@@ -216,6 +641,9 @@ void OrderBook::Print(bool print_name) const {
     //     transaction->Print(false);
     // }
     for (const auto& order : all_user_orders_) {
-        order->Print(true);
+        // orders which are still in flight have no info yet
+        if (order) {
+            order->Print(true);
+        }
     }
 }
\ No newline at end of file
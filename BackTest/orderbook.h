@@ -1,47 +1,174 @@
 #pragma once
 
+#include "allocation_tracker.h"
+#include "book_kernels.h"
+#include "instrumentation.h"
+#include "level_index.h"
+#include "level_update.h"
 #include "order.h"
+#include "trade_history.h"
 
 #include <memory>
 #include <set>
+#include <utility>
 #include <vector>
 
+// A fill of a user order produced by the last matching operation of the orderbook.
+struct UserFill {
+    TBase order;
+    TTransaction transaction;
+    UserFill() = default;
+    UserFill(const TBase& order, const TTransaction& transaction);
+};
+
+using TUserFillVector = std::vector<UserFill>;
+
+// The best level of both sides by the remaining volume, 0 price and volume for an empty side.
+struct Quote {
+    uint64_t bid_price;
+    uint64_t bid_volume;
+    uint64_t ask_price;
+    uint64_t ask_volume;
+    Quote();
+    bool HasBid() const;
+    bool HasAsk() const;
+    void Print(bool print_name = true) const;
+};
+
+// The first levels of both sides aggregated by price, best level first. The arrays belong to the
+// orderbook and are valid until its next change.
+struct DepthView {
+    const uint64_t* ask_prices;
+    const uint64_t* ask_volumes;
+    size_t ask_depth;
+    const uint64_t* bid_prices;
+    const uint64_t* bid_volumes;
+    size_t bid_depth;
+    DepthView(const BookLevels& ask, const BookLevels& bid, const size_t& depth);
+};
+
+// While no user limit order rests in the book and no level update has come, the snapshots and the
+// market transactions are applied to sorted vectors of the orders and the sets are built only
+// when they are read or a user order arrives. The vectors hold the same order objects the sets
+// would, so the results don't depend on the mode.
 class OrderBook {
 public:
-    OrderBook() = default;
+    OrderBook();
+    // the lazy mode is on by default
+    void SetLazyMode(bool is_lazy);
+    bool IsLazy() const;
     void UpdateOrderBook(const TLimitVector& new_ask, const TLimitVector& new_bid);
+    // replaces the historical orders of one level by an order with the new volume, stamped with
+    // the time of the update like the orders of a snapshot. The user orders of the level keep
+    // their place, the other levels aren't touched. O(log n) in the sets, the first update leaves
+    // the lazy mode for the rest of the replay
+    void UpdateLevel(const LevelUpdate& update);
     void AddUserLimitOrder(const uint64_t& order_id, const uint64_t& submit_timestamp,
                            const OrderTypes& order_type, const uint64_t& volume,
                            const uint64_t& price_limit);
     void CompleteUserMarketOrder(const uint64_t& order_id, const uint64_t& submit_timestamp,
                                  const OrderTypes& order_type, const uint64_t& volume);
-    void CompleteMarketTransaction(const CompletedTransaction& transaction);
+    // a user order gets one fill per print of a coalesced transaction
+    void CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                   const TPrintEnds& print_ends = TPrintEnds());
     uint64_t AddNewOrder();
+    // makes order_id valid in a book which takes its ids from another one
+    void ReserveOrderId(const uint64_t& order_id);
     void RemoveOrder(const uint64_t& order_id);
     TBase GetOrderInfo(const uint64_t& order_id) const;
+    // number of orders before the user limit order in its side of the orderbook,
+    // -1 if the order isn't in the orderbook
+    uint64_t GetOrderPosition(const uint64_t& order_id) const;
+    // remaining volume of the orders before the user limit order, -1 if it isn't in the orderbook
+    uint64_t GetVolumeAhead(const uint64_t& order_id) const;
+    // count and remaining volume of the orders which are before the place of the order, the order
+    // doesn't have to be in the orderbook. O(log n) in the sets, a walk of the orders ahead in the
+    // lazy mode
+    std::pair<uint64_t, uint64_t> GetAhead(const TLimit& order) const;
     const TAskLimitSet& GetAsk() const;
     const TBidLimitSet& GetBid() const;
+    // the sorted vector of the side in the lazy mode without building the sets, nullptr if the
+    // sets hold the orders
+    const TLimitVector* GetLazyAsk() const;
+    const TLimitVector* GetLazyBid() const;
+    // the levels and the quote are built at the first read after a change of the book, without
+    // building the sets in the lazy mode. Only the levels which are read are built: the quote
+    // walks the first level of each side and GetDepth the first depth levels, so a read of more
+    // levels rebuilds the arrays of a view returned before
+    const BookLevels& GetAskLevels() const;
+    const BookLevels& GetBidLevels() const;
+    const Quote& GetQuote() const;
+    DepthView GetDepth(const size_t& depth) const;
     const TLimitVector& GetUserLimitAsk() const;
     const TLimitVector& GetUserLimitBid() const;
     const TMarketVector& GetUserMarketAsk() const;
     const TMarketVector& GetUserMarketBid() const;
-    const TTransactionVector& GetMarketTransactions() const;
+    // only the tail allowed by the retention is in memory
+    const TradeHistory& GetMarketTransactions() const;
+    void SetTradeRetention(const RetentionConfig& config);
+    // blocks until the trade log contains every transaction
+    void FlushTradeLog();
+    const TUserFillVector& GetLastUserFills() const;
+    // empty unless built with BACKTEST_INSTRUMENTATION
+    const OrderBookStats& GetStats() const;
     void Print(bool print_name = true) const;
 
 private:
     template <typename TLimitSet>
-    void UpdateOrders(TLimitVector cur_orders, TLimitSet& old_orderbook,
+    void UpdateOrders(TLimitVector cur_orders, TLimitSet& old_orderbook, LevelIndex& index,
                       TLimitVector& historical_orders);
+    // UpdateOrders over the sorted vector of a side without user orders
     template <typename TLimitSet>
-    void CompleteUserMarketOrder(TMarket market_order, TLimitSet& orders,
+    void UpdateLazyOrders(TLimitVector cur_orders, TLimitVector& orders,
+                          TLimitVector& historical_orders);
+    template <typename TLimitSet>
+    void UpdateLevel(const LevelUpdate& update, TLimitSet& orders, LevelIndex& index);
+    // orders is a set or the sorted vector of a side, the index is nullptr for a vector
+    template <typename TOrders>
+    void CompleteUserMarketOrder(TMarket market_order, TOrders& orders, LevelIndex* index,
                                  const bool is_buyer_maker);
+    template <typename TOrders>
+    void CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                   const TPrintEnds& print_ends, TOrders& orders,
+                                   LevelIndex* index);
+    template <typename TOrders>
+    void UpdateIndex(const TOrders& orders, LevelIndex* index, const uint64_t& price,
+                     const int64_t& count, const int64_t& volume);
+    bool HasUserOrders() const;
+    void EnterLazyMode();
+    void LeaveLazyMode();
+    // builds the sets from the vectors in the lazy mode
+    void Materialize() const;
+    // builds at least the first depth levels of both sides and the quote
+    void UpdateLevels(const size_t& depth) const;
+    // count and remaining volume of the orders before the place of the order
+    template <typename TLimitSet>
+    std::pair<uint64_t, uint64_t> GetAhead(const TLimitSet& orders, const LevelIndex& index,
+                                           const TLimit& order) const;
     template <typename TLimitSet>
-    void CompleteMarketTransaction(const CompletedTransaction& transaction, TLimitSet& orders);
-    TAskLimitSet ask_;
-    TBidLimitSet bid_;
+    static std::pair<uint64_t, uint64_t> GetLazyAhead(const TLimitVector& orders,
+                                                      const TLimit& order);
+    // -1 if the order isn't in the orderbook
+    std::pair<uint64_t, uint64_t> GetAhead(const uint64_t& order_id) const;
+    // in the lazy mode the sets are a cache of lazy_ask_ and lazy_bid_
+    mutable TAskLimitSet ask_;
+    mutable TBidLimitSet bid_;
+    mutable LevelIndex ask_index_, bid_index_;
+    bool is_lazy_allowed_;
+    bool is_lazy_;
+    mutable bool is_materialized_;
+    bool has_level_updates_;
+    TLimitVector lazy_ask_, lazy_bid_;
+    // number of levels built since the last change of the book, 0 after every change and -1
+    // when all levels are built
+    mutable size_t levels_depth_;
+    mutable BookLevels ask_levels_, bid_levels_;
+    mutable Quote quote_;
     TLimitVector historical_ask_, historical_bid_;
     TLimitVector user_limit_ask_, user_limit_bid_;
     TMarketVector user_market_ask_, user_market_bid_;
-    TTransactionVector market_transactions_;
+    TradeHistory market_transactions_;
     TBaseVector all_user_orders_;
+    TUserFillVector last_user_fills_;
+    OrderBookStats stats_;
 };
@@ -0,0 +1,203 @@
+#include "parameter_sweep.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+// TopPressureParameters
+
+TopPressureParameters::TopPressureParameters(const uint64_t& cnt, const double& threshold,
+                                             const uint64_t& butch)
+    : cnt(cnt), threshold(threshold), butch(butch) {
+}
+
+void TopPressureParameters::Print(bool print_name) const {
+    if (print_name) {
+        std::cerr << "TopPressureParameters:" << std::endl;
+    }
+    std::cerr << "cnt = " << cnt << " threshold = " << threshold << " butch = " << butch
+              << std::endl;
+}
+
+// SweepConfig
+
+SweepConfig::SweepConfig(const uint64_t& order_volume, const uint64_t& price_step,
+                         const uint64_t& order_lifetime)
+    : order_volume(order_volume), price_step(price_step), order_lifetime(order_lifetime) {
+}
+
+// TopPressureSweep
+
+TopPressureSweep::TopPressureSweep(const std::vector<TopPressureParameters>& parameters,
+                                   const SweepConfig& config)
+    : parameters_(parameters),
+      config_(config),
+      timestamp_(0),
+      cnts_(),
+      thresholds_(),
+      butches_(),
+      half_butches_(),
+      order_prices_(parameters.size(), 0),
+      order_sides_(parameters.size(), 0),
+      order_remaining_(parameters.size(), 0),
+      pending_sides_(parameters.size(), 0),
+      arrival_timestamps_(parameters.size(), 0),
+      expiry_timestamps_(parameters.size(), 0),
+      next_update_(-1),
+      total_cash_(parameters.size(), 0),
+      total_asset_(parameters.size(), 0),
+      orders_count_(parameters.size(), 0),
+      filled_volume_(parameters.size(), 0),
+      ask_cumulative_(),
+      bid_cumulative_(),
+      trade_signs_(),
+      imbalances_(),
+      signals_(parameters.size(), 0),
+      fills_(parameters.size(), 0) {
+    if (parameters_.empty()) {
+        throw std::runtime_error("TopPressureSweep::TopPressureSweep - No parameters.");
+    }
+    uint64_t max_cnt = 0, max_butch = 0;
+    for (const auto& lane_parameters : parameters_) {
+        cnts_.emplace_back(lane_parameters.cnt);
+        thresholds_.emplace_back(lane_parameters.threshold);
+        butches_.emplace_back(lane_parameters.butch);
+        // the integer division of main.cpp
+        half_butches_.emplace_back(lane_parameters.butch / 2);
+        max_cnt = std::max(max_cnt, lane_parameters.cnt);
+        max_butch = std::max(max_butch, lane_parameters.butch);
+    }
+    ask_cumulative_.resize(max_cnt + 1);
+    bid_cumulative_.resize(max_cnt + 1);
+    imbalances_.resize(max_butch + 1);
+}
+
+size_t TopPressureSweep::Size() const {
+    return parameters_.size();
+}
+
+const TopPressureParameters& TopPressureSweep::GetParameters(const size_t& lane) const {
+    return parameters_.at(lane);
+}
+
+double TopPressureSweep::GetSignal(const size_t& lane) const {
+    return signals_.at(lane);
+}
+
+ForPNL TopPressureSweep::GetPNL(const size_t& lane) const {
+    return ForPNL(total_cash_.at(lane), total_asset_.at(lane), timestamp_);
+}
+
+uint64_t TopPressureSweep::GetOrdersCount(const size_t& lane) const {
+    return orders_count_.at(lane);
+}
+
+uint64_t TopPressureSweep::GetFilledVolume(const size_t& lane) const {
+    return filled_volume_.at(lane);
+}
+
+void TopPressureSweep::AddTransaction(const CompletedTransaction& transaction) {
+    timestamp_ = transaction.GetTransactionTimestamp();
+    UpdateOrders(timestamp_);
+    if (imbalances_.size() > 1) {
+        trade_signs_.emplace_back(transaction.GetIsBuyerMaker() ? 1 : -1);
+        if (trade_signs_.size() >= imbalances_.size()) {
+            trade_signs_.pop_front();
+        }
+    }
+    GetLaneFills(order_prices_.data(), order_sides_.data(), order_remaining_.data(),
+                 transaction.GetPrice(), transaction.GetVolume(), transaction.GetIsBuyerMaker(),
+                 Size(), fills_.data());
+    for (size_t lane = 0; lane < Size(); ++lane) {
+        if (fills_[lane] == 0) {
+            continue;
+        }
+        auto volume = static_cast<uint64_t>(fills_[lane]);
+        auto cash = static_cast<int64_t>(static_cast<uint64_t>(order_prices_[lane]) * volume);
+        if (order_sides_[lane] > 0) {
+            total_cash_[lane] -= cash;
+            total_asset_[lane] += volume;
+        } else {
+            total_cash_[lane] += cash;
+            total_asset_[lane] -= volume;
+        }
+        filled_volume_[lane] += volume;
+        order_remaining_[lane] -= fills_[lane];
+        if (order_remaining_[lane] == 0) {
+            order_sides_[lane] = 0;
+        }
+    }
+}
+
+void TopPressureSweep::Decide(const TAskLimitSet& ask, const TBidLimitSet& bid,
+                              const uint64_t& total, const uint64_t& timestamp,
+                              const uint64_t& post_latency, const uint64_t& cancel_latency) {
+    timestamp_ = timestamp;
+    UpdateOrders(timestamp);
+    if (ask.empty() || bid.empty()) {
+        return;
+    }
+    FillCumulative(ask, ask_cumulative_);
+    FillCumulative(bid, bid_cumulative_);
+    GetLaneSignals(ask_cumulative_.data(), bid_cumulative_.data(), cnts_.data(),
+                   thresholds_.data(), total, Size(), signals_.data());
+    FillImbalances();
+    GetLaneConfirmations(imbalances_.data(), butches_.data(), half_butches_.data(), Size(),
+                         signals_.data());
+    uint64_t mid = ((*ask.begin())->GetPriceLimit() + (*bid.begin())->GetPriceLimit()) / 2;
+    for (size_t lane = 0; lane < Size(); ++lane) {
+        if (signals_[lane] == 0 || order_sides_[lane] != 0 || pending_sides_[lane] != 0) {
+            continue;
+        }
+        pending_sides_[lane] = signals_[lane];
+        order_prices_[lane] = signals_[lane] > 0 ? mid - config_.price_step
+                                                 : mid + config_.price_step;
+        order_remaining_[lane] = config_.order_volume;
+        arrival_timestamps_[lane] = timestamp + post_latency;
+        expiry_timestamps_[lane] = timestamp + config_.order_lifetime + cancel_latency;
+        next_update_ = std::min(next_update_, arrival_timestamps_[lane]);
+        ++orders_count_[lane];
+    }
+}
+
+void TopPressureSweep::UpdateOrders(const uint64_t& timestamp) {
+    if (timestamp < next_update_) {
+        return;
+    }
+    next_update_ = -1;
+    for (size_t lane = 0; lane < Size(); ++lane) {
+        if (pending_sides_[lane] != 0 && arrival_timestamps_[lane] <= timestamp) {
+            order_sides_[lane] = pending_sides_[lane];
+            pending_sides_[lane] = 0;
+        }
+        if (order_sides_[lane] != 0 && expiry_timestamps_[lane] <= timestamp) {
+            order_sides_[lane] = 0;
+        }
+        if (pending_sides_[lane] != 0) {
+            next_update_ = std::min(next_update_, arrival_timestamps_[lane]);
+        } else if (order_sides_[lane] != 0) {
+            next_update_ = std::min(next_update_, expiry_timestamps_[lane]);
+        }
+    }
+}
+
+template <typename TLimitSet>
+void TopPressureSweep::FillCumulative(const TLimitSet& orders, std::vector<double>& cumulative) {
+    cumulative[0] = 0;
+    auto it = orders.begin();
+    for (size_t cnt = 1; cnt < cumulative.size(); ++cnt) {
+        cumulative[cnt] = cumulative[cnt - 1];
+        if (it != orders.end()) {
+            cumulative[cnt] += (*it++)->GetVolume();
+        }
+    }
+}
+
+void TopPressureSweep::FillImbalances() {
+    imbalances_[0] = 0;
+    auto it = trade_signs_.rbegin();
+    for (size_t butch = 1; butch < imbalances_.size(); ++butch) {
+        // the windows longer than the transactions wait
+        imbalances_[butch] = it != trade_signs_.rend() ? imbalances_[butch - 1] + *it++ : 0;
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "backtest.h"
+#include "book_kernels.h"
+#include "completed_transaction.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// time in ms
+
+// the parameters of GetTopPressurePrediction and GetCountTransactionsPredictoin from main.cpp
+struct TopPressureParameters {
+    // number of orders of each side
+    uint64_t cnt;
+    // the lane waits while |ask volume - bid volume| * threshold < total ask volume
+    double threshold;
+    // the lane trades only if the buyer maker imbalance of the last butch transactions points the
+    // same way, as GetMixedPrediction does, 0 turns it off
+    uint64_t butch;
+    TopPressureParameters(const uint64_t& cnt = 10, const double& threshold = 8,
+                          const uint64_t& butch = 0);
+    void Print(bool print_name = true) const;
+};
+
+// the orders of every lane, as the main loop sends them
+struct SweepConfig {
+    uint64_t order_volume;
+    // a buy is placed price_step below the mid price and a sell above it
+    uint64_t price_step;
+    // a withdraw is sent this long after the order
+    uint64_t order_lifetime;
+    SweepConfig(const uint64_t& order_volume = 10, const uint64_t& price_step = 100,
+                const uint64_t& order_lifetime = 10000);
+};
+
+// Runs the top pressure strategy for many parameter sets in one replay. The state of the lanes is
+// stored as arrays, one element per lane, and every timer and every market transaction updates
+// all lanes with the lane kernels of book_kernels.h. The signal of a lane is the one of main.cpp:
+// the volumes of the first cnt orders of each side as GetTopPressurePrediction reads them and the
+// last butch transactions as GetCountTransactionsPredictoin, except that the lane waits instead
+// of a random prediction while there are fewer transactions. Each lane trades in its own
+// simulated account instead of the orderbook: it has at most one order, which arrives after the
+// post latency, is filled by the market transactions through its price regardless of the queue
+// and is gone after the order lifetime and the cancel latency. The lanes pay no fees and don't
+// take volume from each other, so they can be compared but their PnL is optimistic against
+// BackTest.
+//
+//     TopPressureSweep sweep(parameters);
+//     backtest.Run(sweep, end_timestamp, 1000);
+//     sweep.GetPNL(lane).Print();
+class TopPressureSweep : public BaseStrategy {
+public:
+    explicit TopPressureSweep(const std::vector<TopPressureParameters>& parameters,
+                              const SweepConfig& config = SweepConfig());
+    template <typename TBackTest>
+    void OnTrade(TBackTest& /*backtest*/, const CompletedTransaction& transaction) {
+        AddTransaction(transaction);
+    }
+    // every lane makes its decision
+    template <typename TBackTest>
+    void OnTimer(TBackTest& backtest) {
+        Decide(backtest.GetAsk(), backtest.GetBid(), backtest.GetTotalMarketAsset(),
+               backtest.GetCurrentTimestamp(), backtest.GetPostLatency(),
+               backtest.GetCancelLatency());
+    }
+    size_t Size() const;
+    const TopPressureParameters& GetParameters(const size_t& lane) const;
+    // the last signal of the lane: 1 to buy, -1 to sell and 0 to wait
+    double GetSignal(const size_t& lane) const;
+    ForPNL GetPNL(const size_t& lane) const;
+    uint64_t GetOrdersCount(const size_t& lane) const;
+    uint64_t GetFilledVolume(const size_t& lane) const;
+
+private:
+    void AddTransaction(const CompletedTransaction& transaction);
+    void Decide(const TAskLimitSet& ask, const TBidLimitSet& bid, const uint64_t& total,
+                const uint64_t& timestamp, const uint64_t& post_latency,
+                const uint64_t& cancel_latency);
+    // places the orders which arrived and drops the expired ones
+    void UpdateOrders(const uint64_t& timestamp);
+    // the volumes of the first orders, closed ones too, like GetTopPressurePrediction
+    template <typename TLimitSet>
+    static void FillCumulative(const TLimitSet& orders, std::vector<double>& cumulative);
+    // the buyer maker imbalances of the last transactions for every window length
+    void FillImbalances();
+
+    std::vector<TopPressureParameters> parameters_;
+    SweepConfig config_;
+    uint64_t timestamp_;
+    // the lane parameters
+    std::vector<uint64_t> cnts_;
+    std::vector<double> thresholds_;
+    std::vector<uint64_t> butches_;
+    std::vector<double> half_butches_;
+    // the lane orders, side is 1 for a bid, -1 for an ask and 0 without an order
+    std::vector<double> order_prices_;
+    std::vector<double> order_sides_;
+    std::vector<double> order_remaining_;
+    std::vector<double> pending_sides_;
+    std::vector<uint64_t> arrival_timestamps_;
+    std::vector<uint64_t> expiry_timestamps_;
+    // the earliest arrival or expiry, UpdateOrders skips the lanes until then
+    uint64_t next_update_;
+    // the lane accounts
+    std::vector<int64_t> total_cash_;
+    std::vector<int64_t> total_asset_;
+    std::vector<uint64_t> orders_count_;
+    std::vector<uint64_t> filled_volume_;
+    // buffers of the kernels
+    std::vector<double> ask_cumulative_, bid_cumulative_;
+    // 1 for a buyer maker transaction and -1 for the other one, the last ones up to the longest
+    // window
+    std::deque<double> trade_signs_;
+    std::vector<double> imbalances_;
+    std::vector<double> signals_, fills_;
+};
@@ -0,0 +1,327 @@
+#include "prefetcher.h"
+
+#include "scanner.h"
+
+#include <chrono>
+#include <stdexcept>
+
+// Prefetcher
+
+Prefetcher::Prefetcher(const std::string& path_orderbook, const std::string& path_transactions,
+                       const PrefetchConfig& config)
+    : config_(config),
+      orderbook_in_(path_orderbook),
+      transactions_in_(path_transactions),
+      level_updates_in_(),
+      snapshot_queue_(config.blocks_ahead),
+      transaction_queue_(config.blocks_ahead),
+      level_update_queue_(config.blocks_ahead),
+      snapshots_(),
+      snapshots_position_(0),
+      snapshots_finished_(false),
+      transactions_(),
+      transactions_position_(0),
+      transactions_finished_(false),
+      is_coalescing_(config.coalesce_trades),
+      has_coalesced_(false),
+      coalesced_(0, 0, 0, false),
+      print_ends_(),
+      coalesced_rows_(0),
+      transaction_rows_(0),
+      coalesced_transactions_(0),
+      level_updates_(),
+      level_updates_position_(0),
+      level_updates_finished_(true),
+      waits_(0),
+      stop_(false),
+      snapshot_error_(),
+      transaction_error_(),
+      level_update_error_(),
+      snapshot_thread_(),
+      transaction_thread_(),
+      level_update_thread_() {
+    if (config_.snapshot_block_size == 0 || config_.transaction_block_size == 0 ||
+        config_.level_update_block_size == 0) {
+        throw std::runtime_error("Prefetcher::Prefetcher - Block sizes have to be positive.");
+    }
+    if (!orderbook_in_.is_open()) {
+        throw std::runtime_error(
+            "Prefetcher::Prefetcher - Failed to open the file with an orderbook.");
+    }
+    if (!transactions_in_.is_open()) {
+        throw std::runtime_error(
+            "Prefetcher::Prefetcher - Failed to open the file with transactions.");
+    }
+    std::string header;
+    getline(orderbook_in_, header);
+    getline(transactions_in_, header);
+    snapshot_thread_ = std::thread(&Prefetcher::ParseSnapshots, this);
+    transaction_thread_ = std::thread(&Prefetcher::ParseTransactions, this);
+}
+
+Prefetcher::~Prefetcher() {
+    stop_ = true;
+    snapshot_thread_.join();
+    transaction_thread_.join();
+    if (level_update_thread_.joinable()) {
+        level_update_thread_.join();
+    }
+}
+
+bool Prefetcher::HasSnapshot() {
+    if (snapshots_position_ < snapshots_.ask.size()) {
+        return true;
+    }
+    if (snapshots_finished_) {
+        return false;
+    }
+    Pop(snapshot_queue_, snapshots_);
+    snapshots_position_ = 0;
+    if (snapshots_.ask.empty()) {
+        snapshots_finished_ = true;
+        if (snapshot_error_) {
+            std::rethrow_exception(snapshot_error_);
+        }
+        return false;
+    }
+    return true;
+}
+
+uint64_t Prefetcher::GetSnapshotTimestamp() const {
+    return snapshots_.ask[snapshots_position_][0]->GetSubmitTimestamp();
+}
+
+const TLimitVector& Prefetcher::GetAsk() const {
+    return snapshots_.ask[snapshots_position_];
+}
+
+const TLimitVector& Prefetcher::GetBid() const {
+    return snapshots_.bid[snapshots_position_];
+}
+
+void Prefetcher::PopSnapshot() {
+    // the orderbook keeps what it needs, the consumed snapshot isn't read again
+    TLimitVector().swap(snapshots_.ask[snapshots_position_]);
+    TLimitVector().swap(snapshots_.bid[snapshots_position_]);
+    ++snapshots_position_;
+}
+
+bool Prefetcher::HasTransaction() {
+    if (!is_coalescing_) {
+        return HasTransactionRow();
+    }
+    if (has_coalesced_) {
+        return true;
+    }
+    if (!HasTransactionRow()) {
+        return false;
+    }
+    const auto& first = transactions_.transactions[transactions_position_];
+    uint64_t volume = first.GetVolume();
+    coalesced_ = first;
+    coalesced_rows_ = 1;
+    print_ends_.assign(1, volume);
+    ++transactions_position_;
+    // the next row can be in the next block, the parser is usually ahead
+    while (HasTransactionRow()) {
+        const auto& next = transactions_.transactions[transactions_position_];
+        if (next.GetTransactionTimestamp() != coalesced_.GetTransactionTimestamp() ||
+            next.GetPrice() != coalesced_.GetPrice() ||
+            next.GetIsBuyerMaker() != coalesced_.GetIsBuyerMaker()) {
+            break;
+        }
+        volume += next.GetVolume();
+        print_ends_.emplace_back(volume);
+        ++coalesced_rows_;
+        ++transactions_position_;
+    }
+    coalesced_ = CompletedTransaction(coalesced_.GetTransactionTimestamp(), volume,
+                                      coalesced_.GetPrice(), coalesced_.GetIsBuyerMaker());
+    has_coalesced_ = true;
+    return true;
+}
+
+const CompletedTransaction& Prefetcher::GetTransaction() const {
+    if (is_coalescing_) {
+        return coalesced_;
+    }
+    return transactions_.transactions[transactions_position_];
+}
+
+const TPrintEnds& Prefetcher::GetPrintEnds() const {
+    return print_ends_;
+}
+
+void Prefetcher::PopTransaction() {
+    if (is_coalescing_) {
+        has_coalesced_ = false;
+        transaction_rows_ += coalesced_rows_;
+        coalesced_transactions_ += coalesced_rows_ - 1;
+        return;
+    }
+    ++transactions_position_;
+    ++transaction_rows_;
+}
+
+void Prefetcher::SetTradeCoalescing(bool is_coalescing) {
+    if (has_coalesced_ || transaction_rows_ != 0) {
+        throw std::runtime_error(
+            "Prefetcher::SetTradeCoalescing - Transactions were already returned.");
+    }
+    is_coalescing_ = is_coalescing;
+}
+
+void Prefetcher::OpenLevelUpdates(const std::string& path_level_updates) {
+    if (level_updates_in_.is_open()) {
+        throw std::runtime_error(
+            "Prefetcher::OpenLevelUpdates - The level updates are already open.");
+    }
+    level_updates_in_.open(path_level_updates);
+    if (!level_updates_in_.is_open()) {
+        throw std::runtime_error(
+            "Prefetcher::OpenLevelUpdates - Failed to open the file with level updates.");
+    }
+    std::string header;
+    getline(level_updates_in_, header);
+    level_updates_finished_ = false;
+    level_update_thread_ = std::thread(&Prefetcher::ParseLevelUpdates, this);
+}
+
+bool Prefetcher::HasLevelUpdate() {
+    if (level_updates_position_ < level_updates_.level_updates.size()) {
+        return true;
+    }
+    if (level_updates_finished_) {
+        return false;
+    }
+    Pop(level_update_queue_, level_updates_);
+    level_updates_position_ = 0;
+    if (level_updates_.level_updates.empty()) {
+        level_updates_finished_ = true;
+        if (level_update_error_) {
+            std::rethrow_exception(level_update_error_);
+        }
+        return false;
+    }
+    return true;
+}
+
+const LevelUpdate& Prefetcher::GetLevelUpdate() const {
+    return level_updates_.level_updates[level_updates_position_];
+}
+
+void Prefetcher::PopLevelUpdate() {
+    ++level_updates_position_;
+}
+
+uint64_t Prefetcher::GetWaits() const {
+    return waits_;
+}
+
+uint64_t Prefetcher::GetTransactionRows() const {
+    return transaction_rows_;
+}
+
+uint64_t Prefetcher::GetCoalescedTransactions() const {
+    return coalesced_transactions_;
+}
+
+bool Prefetcher::HasTransactionRow() {
+    if (transactions_position_ < transactions_.transactions.size()) {
+        return true;
+    }
+    if (transactions_finished_) {
+        return false;
+    }
+    Pop(transaction_queue_, transactions_);
+    transactions_position_ = 0;
+    if (transactions_.transactions.empty()) {
+        transactions_finished_ = true;
+        if (transaction_error_) {
+            std::rethrow_exception(transaction_error_);
+        }
+        return false;
+    }
+    return true;
+}
+
+template <typename TBlock>
+bool Prefetcher::Push(SpscQueue<TBlock>& queue, TBlock&& block) {
+    while (!queue.TryPush(std::move(block))) {
+        if (stop_) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return true;
+}
+
+template <typename TBlock>
+void Prefetcher::Pop(SpscQueue<TBlock>& queue, TBlock& block) {
+    if (!queue.TryPop(block)) {
+        ++waits_;
+        while (!queue.TryPop(block)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void Prefetcher::ParseSnapshots() {
+    Scanner scanner;
+    try {
+        while (!stop_) {
+            size_t lines =
+                scanner.ReadOrderBookLines(orderbook_in_, config_.snapshot_block_size);
+            SnapshotBlock block{scanner.ReleaseAsk(), scanner.ReleaseBid()};
+            if (!block.ask.empty() && !Push(snapshot_queue_, std::move(block))) {
+                return;
+            }
+            if (lines < config_.snapshot_block_size) {
+                break;
+            }
+        }
+    } catch (...) {
+        snapshot_error_ = std::current_exception();
+    }
+    Push(snapshot_queue_, SnapshotBlock());
+}
+
+void Prefetcher::ParseTransactions() {
+    Scanner scanner;
+    try {
+        while (!stop_) {
+            size_t lines =
+                scanner.ReadTransactionsLines(transactions_in_, config_.transaction_block_size);
+            TransactionBlock block{scanner.ReleaseTransactions()};
+            if (!block.transactions.empty() && !Push(transaction_queue_, std::move(block))) {
+                return;
+            }
+            if (lines < config_.transaction_block_size) {
+                break;
+            }
+        }
+    } catch (...) {
+        transaction_error_ = std::current_exception();
+    }
+    Push(transaction_queue_, TransactionBlock());
+}
+
+void Prefetcher::ParseLevelUpdates() {
+    Scanner scanner;
+    try {
+        while (!stop_) {
+            size_t lines =
+                scanner.ReadLevelUpdatesLines(level_updates_in_, config_.level_update_block_size);
+            LevelUpdateBlock block{scanner.ReleaseLevelUpdates()};
+            if (!block.level_updates.empty() && !Push(level_update_queue_, std::move(block))) {
+                return;
+            }
+            if (lines < config_.level_update_block_size) {
+                break;
+            }
+        }
+    } catch (...) {
+        level_update_error_ = std::current_exception();
+    }
+    Push(level_update_queue_, LevelUpdateBlock());
+}
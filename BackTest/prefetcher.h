@@ -0,0 +1,120 @@
+#pragma once
+
+#include "completed_transaction.h"
+#include "level_update.h"
+#include "order.h"
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// an empty block marks the end of the file
+struct SnapshotBlock {
+    std::vector<TLimitVector> ask, bid;
+};
+
+struct TransactionBlock {
+    std::vector<CompletedTransaction> transactions;
+};
+
+struct LevelUpdateBlock {
+    TLevelUpdateVector level_updates;
+};
+
+struct PrefetchConfig {
+    // rows parsed at once
+    size_t snapshot_block_size = 256;
+    size_t transaction_block_size = 4096;
+    // parsed blocks which can wait for the replay, per file
+    size_t blocks_ahead = 4;
+    // consecutive transactions with equal timestamp, price and aggressor side are returned as one
+    // transaction with their total volume, see Prefetcher::SetTradeCoalescing
+    bool coalesce_trades = false;
+    // rows of the level updates parsed at once
+    size_t level_update_block_size = 4096;
+};
+
+// Parses the orderbook and the transactions files on two background threads, and the level
+// updates on a third one if they are opened, while the replay consumes the rows parsed before, so
+// the replay is bounded by the slower of parsing and simulation instead of their sum. The blocks
+// are passed through bounded lock-free queues, a parser sleeps while its queue is full. All other
+// calls have to come from one thread.
+class Prefetcher {
+public:
+    Prefetcher(const std::string& path_orderbook, const std::string& path_transactions,
+               const PrefetchConfig& config = PrefetchConfig());
+    ~Prefetcher();
+    Prefetcher(const Prefetcher&) = delete;
+    Prefetcher& operator=(const Prefetcher&) = delete;
+    // false once the file is over, waits for the parser if the next block isn't ready and
+    // rethrows its exception if the file is incorrect
+    bool HasSnapshot();
+    // the current snapshot, HasSnapshot has to be true
+    uint64_t GetSnapshotTimestamp() const;
+    const TLimitVector& GetAsk() const;
+    const TLimitVector& GetBid() const;
+    // releases the current snapshot
+    void PopSnapshot();
+    bool HasTransaction();
+    const CompletedTransaction& GetTransaction() const;
+    // the ends of the rows merged into the current transaction, empty without coalescing
+    const TPrintEnds& GetPrintEnds() const;
+    void PopTransaction();
+    // The orderbook fills the same orders with the same volumes whether the prints of one
+    // aggressor at one price and time come one by one or as their sum. GetPrintEnds lets it
+    // split the volume a user order takes into the fills of the single prints. Has to be set
+    // before the first HasTransaction.
+    void SetTradeCoalescing(bool is_coalescing);
+    // starts the parser of a file of level updates on a third thread, without it there are no
+    // level updates. Has to be called before the first HasLevelUpdate
+    void OpenLevelUpdates(const std::string& path_level_updates);
+    bool HasLevelUpdate();
+    const LevelUpdate& GetLevelUpdate() const;
+    void PopLevelUpdate();
+    // number of times the replay had to wait for a block
+    uint64_t GetWaits() const;
+    // number of rows of the transactions file returned so far and number of them which were
+    // merged into the transaction before
+    uint64_t GetTransactionRows() const;
+    uint64_t GetCoalescedTransactions() const;
+
+private:
+    template <typename TBlock>
+    bool Push(SpscQueue<TBlock>& queue, TBlock&& block);
+    template <typename TBlock>
+    void Pop(SpscQueue<TBlock>& queue, TBlock& block);
+    bool HasTransactionRow();
+    void ParseSnapshots();
+    void ParseTransactions();
+    void ParseLevelUpdates();
+    PrefetchConfig config_;
+    std::ifstream orderbook_in_, transactions_in_, level_updates_in_;
+    SpscQueue<SnapshotBlock> snapshot_queue_;
+    SpscQueue<TransactionBlock> transaction_queue_;
+    SpscQueue<LevelUpdateBlock> level_update_queue_;
+    SnapshotBlock snapshots_;
+    size_t snapshots_position_;
+    bool snapshots_finished_;
+    TransactionBlock transactions_;
+    size_t transactions_position_;
+    bool transactions_finished_;
+    // the merged transaction is built on the replay thread and is current until PopTransaction
+    bool is_coalescing_;
+    bool has_coalesced_;
+    CompletedTransaction coalesced_;
+    TPrintEnds print_ends_;
+    uint64_t coalesced_rows_;
+    uint64_t transaction_rows_, coalesced_transactions_;
+    LevelUpdateBlock level_updates_;
+    size_t level_updates_position_;
+    bool level_updates_finished_;
+    uint64_t waits_;
+    std::atomic<bool> stop_;
+    // set by a parser before it pushes the end of the file
+    std::exception_ptr snapshot_error_, transaction_error_, level_update_error_;
+    std::thread snapshot_thread_, transaction_thread_, level_update_thread_;
+};
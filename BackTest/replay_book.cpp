@@ -0,0 +1,89 @@
+#include "replay_book.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+// ReplayBook
+
+void ReplayBook::UpdateOrderBook(const TLimitVector& new_ask, const TLimitVector& new_bid) {
+    UpdateLevels<std::less<uint64_t>>(new_ask, ask_);
+    UpdateLevels<std::greater<uint64_t>>(new_bid, bid_);
+}
+
+void ReplayBook::UpdateOrderBook(const CompactSnapshots& snapshots, const size_t& row) {
+    snapshots.GetAsk(row, buffer_);
+    BuildLevels<std::less<uint64_t>>(ask_);
+    snapshots.GetBid(row, buffer_);
+    BuildLevels<std::greater<uint64_t>>(bid_);
+}
+
+template <typename TComparator>
+void ReplayBook::UpdateLevels(const TLimitVector& orders, BookLevels& levels) {
+    buffer_.clear();
+    for (const auto& order : orders) {
+        buffer_.emplace_back(order->GetPriceLimit(), order->GetVolume());
+    }
+    BuildLevels<TComparator>(levels);
+}
+
+template <typename TComparator>
+void ReplayBook::BuildLevels(BookLevels& levels) {
+    // OrderBook skips empty levels of a snapshot
+    buffer_.erase(std::remove_if(buffer_.begin(), buffer_.end(),
+                                 [](const auto& level) { return level.second == 0; }),
+                  buffer_.end());
+    auto comparator = [](const auto& lhs, const auto& rhs) {
+        return TComparator()(lhs.first, rhs.first);
+    };
+    // the orderbook set keeps only the first order of the snapshot with the same price
+    std::stable_sort(buffer_.begin(), buffer_.end(), comparator);
+    levels.Clear();
+    for (const auto& [price, volume] : buffer_) {
+        if (levels.Size() > 0 && levels.prices.back() == price) {
+            continue;
+        }
+        levels.prices.emplace_back(price);
+        levels.volumes.emplace_back(volume);
+    }
+}
+
+void ReplayBook::CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                           std::vector<CompletedTransaction>& completed) {
+    if (transaction.GetIsBuyerMaker()) {
+        CompleteMarketTransaction(transaction, bid_, completed);
+    } else {
+        CompleteMarketTransaction(transaction, ask_, completed);
+    }
+}
+
+void ReplayBook::CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                           BookLevels& levels,
+                                           std::vector<CompletedTransaction>& completed) {
+    uint64_t current_volume = transaction.GetVolume();
+    size_t closed = 0;
+    for (; closed < levels.Size() && current_volume > 0; ++closed) {
+        uint64_t transaction_volume = std::min(current_volume, levels.volumes[closed]);
+        completed.emplace_back(transaction.GetTransactionTimestamp(), transaction_volume,
+                               levels.prices[closed], transaction.GetIsBuyerMaker());
+        current_volume -= transaction_volume;
+        levels.volumes[closed] -= transaction_volume;
+        if (levels.volumes[closed] > 0) {
+            break;
+        }
+    }
+    levels.prices.erase(levels.prices.begin(), levels.prices.begin() + closed);
+    levels.volumes.erase(levels.volumes.begin(), levels.volumes.begin() + closed);
+    if (current_volume > 0) {
+        throw std::runtime_error(
+            "ReplayBook::CompleteMarketTransaction - Transaction is too big.");
+    }
+}
+
+const BookLevels& ReplayBook::GetAsk() const {
+    return ask_;
+}
+
+const BookLevels& ReplayBook::GetBid() const {
+    return bid_;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "book_kernels.h"
+#include "compact_data.h"
+#include "completed_transaction.h"
+#include "order.h"
+
+#include <vector>
+
+// The orderbook the way OrderBook keeps it while the user has no orders: the last snapshot with
+// the volume consumed by the market transactions after it. Levels are plain arrays, so the book
+// is cheap to rebuild and several books can be replayed in parallel over the same read-only data.
+class ReplayBook {
+public:
+    ReplayBook() = default;
+    void UpdateOrderBook(const TLimitVector& new_ask, const TLimitVector& new_bid);
+    void UpdateOrderBook(const CompactSnapshots& snapshots, const size_t& row);
+    // splits the transaction over the levels like OrderBook::CompleteMarketTransaction does and
+    // appends the produced transactions to completed
+    void CompleteMarketTransaction(const CompletedTransaction& transaction,
+                                   std::vector<CompletedTransaction>& completed);
+    const BookLevels& GetAsk() const;
+    const BookLevels& GetBid() const;
+
+private:
+    template <typename TComparator>
+    void UpdateLevels(const TLimitVector& orders, BookLevels& levels);
+    // makes levels from the snapshot levels in buffer_
+    template <typename TComparator>
+    void BuildLevels(BookLevels& levels);
+    void CompleteMarketTransaction(const CompletedTransaction& transaction, BookLevels& levels,
+                                   std::vector<CompletedTransaction>& completed);
+    BookLevels ask_, bid_;
+    std::vector<std::pair<uint64_t, uint64_t>> buffer_;
+};
@@ -0,0 +1,155 @@
+#include "results_sink.h"
+
+#include <chrono>
+#include <stdexcept>
+
+// OrderEvents
+
+std::string ToString(const OrderEvents& order_event) {
+    switch (order_event) {
+        case ORDER_SUBMIT:
+            return "submit";
+        case ORDER_ACK:
+            return "ack";
+        case CANCEL_REQUEST:
+            return "cancel_request";
+        case CANCEL_ACK:
+            return "cancel_ack";
+    }
+    throw std::runtime_error("ToString - Incorrect order_event.");
+}
+
+// ResultsSink
+
+ResultsSink::ResultsSink(const std::string& prefix, const size_t& capacity)
+    : pnl_queue_(capacity),
+      order_queue_(capacity),
+      fill_queue_(capacity),
+      pnl_out_(prefix + "pnl.csv"),
+      orders_out_(prefix + "orders.csv"),
+      fills_out_(prefix + "fills.csv"),
+      added_(0),
+      stalls_(0),
+      written_(0),
+      stop_(false),
+      failed_(false),
+      thread_() {
+    if (!pnl_out_.is_open() || !orders_out_.is_open() || !fills_out_.is_open()) {
+        throw std::runtime_error("ResultsSink::ResultsSink - Failed to open the output files.");
+    }
+    pnl_out_ << "timestamp,total_cash,total_asset,best_bid,best_ask\n";
+    orders_out_ << "timestamp,order_id,event,order_type,volume,price_limit\n";
+    fills_out_ << "timestamp,order_id,order_type,volume,price,is_buyer_maker\n";
+    thread_ = std::thread(&ResultsSink::Run, this);
+}
+
+ResultsSink::~ResultsSink() {
+    stop_ = true;
+    thread_.join();
+}
+
+void ResultsSink::AddPnl(const PnlRecord& record) {
+    Push(pnl_queue_, record);
+}
+
+void ResultsSink::AddOrder(const OrderRecord& record) {
+    Push(order_queue_, record);
+}
+
+void ResultsSink::AddFill(const FillRecord& record) {
+    Push(fill_queue_, record);
+}
+
+template <typename TRecord>
+void ResultsSink::Push(SpscQueue<TRecord>& queue, const TRecord& record) {
+    if (!queue.TryPush(record)) {
+        ++stalls_;
+        while (!queue.TryPush(record)) {
+            std::this_thread::yield();
+        }
+    }
+    ++added_;
+}
+
+void ResultsSink::Flush() {
+    while (written_.load() < added_ && !failed_) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    if (failed_) {
+        throw std::runtime_error("ResultsSink::Flush - Failed to write the output files.");
+    }
+}
+
+uint64_t ResultsSink::GetStalls() const {
+    return stalls_;
+}
+
+void ResultsSink::Run() {
+    static const size_t buffer_size = 1 << 20;
+    std::string pnl_buffer, orders_buffer, fills_buffer;
+    auto append = [](std::string& buffer, const auto& value) {
+        buffer += std::to_string(value);
+        buffer += ',';
+    };
+    auto write = [](std::ofstream& out, std::string& buffer) {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    };
+    uint64_t processed = 0;
+    PnlRecord pnl;
+    OrderRecord order;
+    FillRecord fill;
+    while (true) {
+        // everything pushed before the stop is popped by this iteration
+        bool stop = stop_;
+        uint64_t popped = 0;
+        for (; pnl_queue_.TryPop(pnl); ++popped) {
+            append(pnl_buffer, pnl.timestamp);
+            append(pnl_buffer, pnl.total_cash);
+            append(pnl_buffer, pnl.total_asset);
+            append(pnl_buffer, pnl.best_bid);
+            pnl_buffer += std::to_string(pnl.best_ask) + '\n';
+        }
+        for (; order_queue_.TryPop(order); ++popped) {
+            append(orders_buffer, order.timestamp);
+            append(orders_buffer, order.order_id);
+            orders_buffer += ToString(order.order_event) + ',';
+            if (order.order_event == CANCEL_REQUEST || order.order_event == CANCEL_ACK) {
+                orders_buffer += ",,\n";
+                continue;
+            }
+            orders_buffer += ToString(order.order_type) + ',';
+            append(orders_buffer, order.volume);
+            orders_buffer += std::to_string(order.price_limit) + '\n';
+        }
+        for (; fill_queue_.TryPop(fill); ++popped) {
+            append(fills_buffer, fill.timestamp);
+            append(fills_buffer, fill.order_id);
+            fills_buffer += ToString(fill.order_type) + ',';
+            append(fills_buffer, fill.volume);
+            append(fills_buffer, fill.price);
+            fills_buffer += fill.is_buyer_maker ? "True\n" : "False\n";
+        }
+        processed += popped;
+
+        if (popped == 0 || pnl_buffer.size() + orders_buffer.size() + fills_buffer.size() >=
+                               buffer_size) {
+            write(pnl_out_, pnl_buffer);
+            write(orders_out_, orders_buffer);
+            write(fills_out_, fills_buffer);
+        }
+        if (popped == 0) {
+            pnl_out_.flush();
+            orders_out_.flush();
+            fills_out_.flush();
+            if (!pnl_out_ || !orders_out_ || !fills_out_) {
+                failed_ = true;
+            }
+            written_ = processed;
+            if (stop) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "order.h"
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+// time in ms
+
+struct PnlRecord {
+    uint64_t timestamp;
+    int64_t total_cash;
+    int64_t total_asset;
+    uint64_t best_bid;
+    uint64_t best_ask;
+};
+
+enum OrderEvents {
+    ORDER_SUBMIT,    // the order was sent, it reaches the orderbook after the post latency
+    ORDER_ACK,       // the order reached the orderbook
+    CANCEL_REQUEST,  // a withdraw was sent
+    CANCEL_ACK       // the withdraw reached the orderbook
+};
+
+std::string ToString(const OrderEvents& order_event);
+
+// the order fields aren't written for the cancel events, price_limit is 0 for market orders
+struct OrderRecord {
+    uint64_t timestamp;
+    uint64_t order_id;
+    OrderEvents order_event;
+    OrderTypes order_type;
+    uint64_t volume;
+    uint64_t price_limit;
+};
+
+struct FillRecord {
+    uint64_t timestamp;
+    uint64_t order_id;
+    OrderTypes order_type;
+    uint64_t volume;
+    uint64_t price;
+    bool is_buyer_maker;
+};
+
+// Writes the results of a run into <prefix>pnl.csv, <prefix>orders.csv and <prefix>fills.csv.
+// The records are passed through lock-free queues to a background thread which formats and
+// writes them, so the simulation thread never waits for the disk. It only spins if a queue is
+// full, which is counted in GetStalls. All Add calls have to come from one thread.
+class ResultsSink {
+public:
+    explicit ResultsSink(const std::string& prefix, const size_t& capacity = 1 << 16);
+    // writes everything which was added
+    ~ResultsSink();
+    ResultsSink(const ResultsSink&) = delete;
+    ResultsSink& operator=(const ResultsSink&) = delete;
+    void AddPnl(const PnlRecord& record);
+    void AddOrder(const OrderRecord& record);
+    void AddFill(const FillRecord& record);
+    // blocks until every added record is in the files
+    void Flush();
+    // number of times a queue was full and the simulation thread had to wait
+    uint64_t GetStalls() const;
+
+private:
+    template <typename TRecord>
+    void Push(SpscQueue<TRecord>& queue, const TRecord& record);
+    void Run();
+    SpscQueue<PnlRecord> pnl_queue_;
+    SpscQueue<OrderRecord> order_queue_;
+    SpscQueue<FillRecord> fill_queue_;
+    // only the background thread writes into the files
+    std::ofstream pnl_out_, orders_out_, fills_out_;
+    uint64_t added_;
+    uint64_t stalls_;
+    std::atomic<uint64_t> written_;
+    std::atomic<bool> stop_;
+    std::atomic<bool> failed_;
+    std::thread thread_;
+};
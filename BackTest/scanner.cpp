@@ -1,5 +1,7 @@
 #include "scanner.h"
 
+#include "allocation_tracker.h"
+
 #include <iostream>
 #include <fstream>
 
@@ -11,6 +13,7 @@ void Scanner::ReadAll(const std::string& path_orderbook, const std::string& path
 }
 
 void Scanner::ReadOrderBook(const std::string& path_orderbook) {
+    BACKTEST_ALLOCATION_SCOPE(SCANNER);
     std::ifstream in(path_orderbook);
     if (!in.is_open()) {
         throw std::runtime_error(
@@ -18,12 +21,11 @@ void Scanner::ReadOrderBook(const std::string& path_orderbook) {
     }
     std::string cur_line;
     getline(in, cur_line);
-    while (getline(in, cur_line)) {
-        TokenizeOrders(cur_line);
-    }
+    ReadOrderBookLines(in, -1);
 }
 
 void Scanner::ReadTransactions(const std::string& path_transactions) {
+    BACKTEST_ALLOCATION_SCOPE(SCANNER);
     std::ifstream in(path_transactions);
     if (!in.is_open()) {
         throw std::runtime_error(
@@ -31,9 +33,49 @@ void Scanner::ReadTransactions(const std::string& path_transactions) {
     }
     std::string cur_line;
     getline(in, cur_line);
-    while (getline(in, cur_line)) {
+    ReadTransactionsLines(in, -1);
+}
+
+void Scanner::ReadLevelUpdates(const std::string& path_level_updates) {
+    BACKTEST_ALLOCATION_SCOPE(SCANNER);
+    std::ifstream in(path_level_updates);
+    if (!in.is_open()) {
+        throw std::runtime_error(
+            "Scanner::ReadLevelUpdates - Failed to open the file with level updates.");
+    }
+    std::string cur_line;
+    getline(in, cur_line);
+    ReadLevelUpdatesLines(in, -1);
+}
+
+size_t Scanner::ReadOrderBookLines(std::istream& in, const size_t& max_lines) {
+    BACKTEST_ALLOCATION_SCOPE(SCANNER);
+    std::string cur_line;
+    size_t lines = 0;
+    for (; lines < max_lines && getline(in, cur_line); ++lines) {
+        TokenizeOrders(cur_line);
+    }
+    return lines;
+}
+
+size_t Scanner::ReadTransactionsLines(std::istream& in, const size_t& max_lines) {
+    BACKTEST_ALLOCATION_SCOPE(SCANNER);
+    std::string cur_line;
+    size_t lines = 0;
+    for (; lines < max_lines && getline(in, cur_line); ++lines) {
         TokenizeTransactions(cur_line);
     }
+    return lines;
+}
+
+size_t Scanner::ReadLevelUpdatesLines(std::istream& in, const size_t& max_lines) {
+    BACKTEST_ALLOCATION_SCOPE(SCANNER);
+    std::string cur_line;
+    size_t lines = 0;
+    for (; lines < max_lines && getline(in, cur_line); ++lines) {
+        TokenizeLevelUpdates(cur_line);
+    }
+    return lines;
 }
 
 uint64_t Scanner::ToInt(const std::string& s, bool use_precition) const {
@@ -79,6 +121,17 @@ bool Scanner::ToBool(const std::string& s) const {
     }
 }
 
+OrderTypes Scanner::ToOrderType(const std::string& s) const {
+    if (s == "ASK") {
+        return ASK;
+    } else if (s == "BID") {
+        return BID;
+    } else {
+        throw std::runtime_error(
+            "Scanner::ToOrderType - Incorrect s, it have to be equal to ASK/BID.");
+    }
+}
+
 std::vector<std::string> Scanner::Split(const std::string& line, const char delimiter) const {
     std::vector<std::string> answer;
     std::string cur;
@@ -105,17 +158,18 @@ void Scanner::TokenizeOrders(const std::string& line) {
         return;
     }
 
-    if (blocks.size() != 202) {
+    // an index, a timestamp and four blocks of top prices or volumes
+    if (blocks.size() < 6 || (blocks.size() - 2) % 4 != 0) {
         throw std::runtime_error(
             "Scanner::TokenizeOrders - Incorrect number of blocks in the line.");
     }
 
-    static const uint64_t top = 50;
+    const uint64_t top = (blocks.size() - 2) / 4;
     static const uint64_t timestamp_position = 1;
     static const uint64_t from_ask_price = timestamp_position + 1;
-    static const uint64_t from_ask_volume = from_ask_price + top;
-    static const uint64_t from_bid_price = from_ask_volume + top;
-    static const uint64_t from_bid_volume = from_bid_volume + top;
+    const uint64_t from_ask_volume = from_ask_price + top;
+    const uint64_t from_bid_price = from_ask_volume + top;
+    const uint64_t from_bid_volume = from_bid_price + top;
 
     TLimitVector to_ask, to_bid;
 
@@ -157,6 +211,27 @@ void Scanner::TokenizeTransactions(const std::string& line) {
                                ToBool(blocks[is_buyer_maker_position]));
 }
 
+void Scanner::TokenizeLevelUpdates(const std::string& line) {
+    auto blocks = Split(line);
+    if (blocks.empty()) {
+        return;
+    }
+
+    if (blocks.size() != 5) {
+        throw std::runtime_error(
+            "Scanner::TokenizeLevelUpdates - Incorrect number of blocks in the line.");
+    }
+
+    static const uint64_t timestamp_position = 1;
+    static const uint64_t side_position = timestamp_position + 1;
+    static const uint64_t price_position = side_position + 1;
+    static const uint64_t volume_position = price_position + 1;
+
+    level_updates_.emplace_back(ToInt(blocks[timestamp_position], false),
+                                ToOrderType(blocks[side_position]), ToInt(blocks[price_position]),
+                                ToInt(blocks[volume_position]));
+}
+
 const std::vector<TLimitVector>& Scanner::GetAsk() const {
     return ask_;
 }
@@ -167,4 +242,32 @@ const std::vector<TLimitVector>& Scanner::GetBid() const {
 
 const std::vector<CompletedTransaction>& Scanner::GetTransactions() const {
     return transactions_;
+}
+
+const TLevelUpdateVector& Scanner::GetLevelUpdates() const {
+    return level_updates_;
+}
+
+std::vector<TLimitVector> Scanner::ReleaseAsk() {
+    std::vector<TLimitVector> ask;
+    ask.swap(ask_);
+    return ask;
+}
+
+std::vector<TLimitVector> Scanner::ReleaseBid() {
+    std::vector<TLimitVector> bid;
+    bid.swap(bid_);
+    return bid;
+}
+
+std::vector<CompletedTransaction> Scanner::ReleaseTransactions() {
+    std::vector<CompletedTransaction> transactions;
+    transactions.swap(transactions_);
+    return transactions;
+}
+
+TLevelUpdateVector Scanner::ReleaseLevelUpdates() {
+    TLevelUpdateVector level_updates;
+    level_updates.swap(level_updates_);
+    return level_updates;
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "completed_transaction.h"
+#include "level_update.h"
 #include "order.h"
 
+#include <istream>
 #include <string>
 
 class Scanner {
@@ -11,16 +13,32 @@ public:
     void ReadAll(const std::string& path_orderbook, const std::string& path_transactions);
     void ReadOrderBook(const std::string& path_orderbook);
     void ReadTransactions(const std::string& path_transactions);
+    // the lines are: an index, a timestamp, ASK or BID, a price and the new volume of the level
+    void ReadLevelUpdates(const std::string& path_level_updates);
+    // parse at most max_lines lines of an opened file whose header was skipped, returns the number
+    // of lines read, less than max_lines only at the end of the file
+    size_t ReadOrderBookLines(std::istream& in, const size_t& max_lines);
+    size_t ReadTransactionsLines(std::istream& in, const size_t& max_lines);
+    size_t ReadLevelUpdatesLines(std::istream& in, const size_t& max_lines);
     const std::vector<TLimitVector>& GetAsk() const;
     const std::vector<TLimitVector>& GetBid() const;
     const std::vector<CompletedTransaction>& GetTransactions() const;
+    const TLevelUpdateVector& GetLevelUpdates() const;
+    // hand the parsed rows over, the scanner is left empty
+    std::vector<TLimitVector> ReleaseAsk();
+    std::vector<TLimitVector> ReleaseBid();
+    std::vector<CompletedTransaction> ReleaseTransactions();
+    TLevelUpdateVector ReleaseLevelUpdates();
 
 private:
     uint64_t ToInt(const std::string& s, bool use_precision = true) const;
     bool ToBool(const std::string& s) const;
+    OrderTypes ToOrderType(const std::string& s) const;
     std::vector<std::string> Split(const std::string& line, const char delimiter = ',') const;
     void TokenizeOrders(const std::string& line);
     void TokenizeTransactions(const std::string& line);
+    void TokenizeLevelUpdates(const std::string& line);
     std::vector<TLimitVector> ask_, bid_;
     std::vector<CompletedTransaction> transactions_;
+    TLevelUpdateVector level_updates_;
 };
\ No newline at end of file
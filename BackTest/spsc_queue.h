@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// A bounded lock-free queue for exactly one producer thread and one consumer thread. The
+// capacity is rounded up to a power of two.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(const size_t& capacity);
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    // producer only, false if the queue is full
+    bool TryPush(const T& value);
+    // the value is moved only on success
+    bool TryPush(T&& value);
+    // consumer only, false if the queue is empty, the slot is left moved from
+    bool TryPop(T& value);
+
+private:
+    std::vector<T> buffer_;
+    size_t mask_;
+    // the indices only grow, they are kept on separate cache lines so the threads don't share one
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(const size_t& capacity) : buffer_(), mask_(0), head_(0), tail_(0) {
+    size_t size = 1;
+    while (size < capacity) {
+        size *= 2;
+    }
+    buffer_.resize(size);
+    mask_ = size - 1;
+}
+
+template <typename T>
+bool SpscQueue<T>::TryPush(const T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == buffer_.size()) {
+        return false;
+    }
+    buffer_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::TryPush(T&& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == buffer_.size()) {
+        return false;
+    }
+    buffer_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::TryPop(T& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    value = std::move(buffer_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,263 @@
+#include "trade_history.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+// TradeLogRecord
+
+TradeLogRecord::TradeLogRecord(const CompletedTransaction& transaction, const uint64_t& order_id)
+    : timestamp(transaction.GetTransactionTimestamp()),
+      price(transaction.GetPrice()),
+      volume(transaction.GetVolume()),
+      order_id(order_id),
+      is_buyer_maker(transaction.GetIsBuyerMaker()) {
+}
+
+bool TradeLogRecord::operator==(const TradeLogRecord& other) const {
+    return timestamp == other.timestamp && price == other.price && volume == other.volume &&
+           order_id == other.order_id && is_buyer_maker == other.is_buyer_maker;
+}
+
+// TradeLogWriter
+
+TradeLogWriter::TradeLogWriter(const std::string& path)
+    : mutex_(),
+      has_work_(),
+      is_written_(),
+      pending_(),
+      added_(0),
+      written_(0),
+      flush_requested_(false),
+      stop_(false),
+      failed_(false),
+      path_(path),
+      thread_() {
+    std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("TradeLogWriter::TradeLogWriter - Failed to open the log file.");
+    }
+    out.write("BTTRADE1", 8);
+    out.close();
+    thread_ = std::thread(&TradeLogWriter::Run, this);
+}
+
+TradeLogWriter::~TradeLogWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    has_work_.notify_all();
+    thread_.join();
+}
+
+void TradeLogWriter::Add(const TradeLogRecord& record) {
+    bool is_full;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.emplace_back(record);
+        ++added_;
+        is_full = pending_.size() >= batch_size_;
+    }
+    if (is_full) {
+        has_work_.notify_one();
+    }
+}
+
+void TradeLogWriter::Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = added_;
+    flush_requested_ = true;
+    has_work_.notify_one();
+    is_written_.wait(lock, [&]() { return written_ >= target || failed_; });
+    if (failed_) {
+        throw std::runtime_error("TradeLogWriter::Flush - Failed to write the log file.");
+    }
+}
+
+void TradeLogWriter::Run() {
+    std::ofstream out(path_, std::ios::binary | std::ios::app);
+    std::vector<TradeLogRecord> batch;
+    std::vector<char> buffer;
+    auto write_number = [&buffer](const uint64_t& value) {
+        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&value),
+                      reinterpret_cast<const char*>(&value) + sizeof(value));
+    };
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // a partial batch is written after a timeout, so the log never lags far behind
+        has_work_.wait_for(lock, std::chrono::milliseconds(100), [&]() {
+            return stop_ || flush_requested_ || pending_.size() >= batch_size_;
+        });
+        flush_requested_ = false;
+        batch.swap(pending_);
+        bool stop = stop_;
+        lock.unlock();
+
+        buffer.clear();
+        for (const auto& record : batch) {
+            write_number(record.timestamp);
+            write_number(record.price);
+            write_number(record.volume);
+            write_number(record.order_id);
+            buffer.push_back(record.is_buyer_maker);
+        }
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+
+        lock.lock();
+        written_ += batch.size();
+        failed_ = failed_ || !out;
+        batch.clear();
+        is_written_.notify_all();
+        if (stop && pending_.empty()) {
+            return;
+        }
+    }
+}
+
+std::vector<TradeLogRecord> ReadTradeLog(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[8];
+    if (!in.read(magic, sizeof(magic)) || std::string(magic, sizeof(magic)) != "BTTRADE1") {
+        throw std::runtime_error("ReadTradeLog - The file isn't a trade log.");
+    }
+    auto read_number = [&in]() {
+        uint64_t value = 0;
+        in.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return value;
+    };
+    std::vector<TradeLogRecord> records;
+    while (in.peek() != EOF) {
+        TradeLogRecord record;
+        record.timestamp = read_number();
+        record.price = read_number();
+        record.volume = read_number();
+        record.order_id = read_number();
+        record.is_buyer_maker = in.get() != 0;
+        if (!in) {
+            throw std::runtime_error("ReadTradeLog - The last record is truncated.");
+        }
+        records.emplace_back(record);
+    }
+    return records;
+}
+
+// TradePrefix
+
+TradePrefix::TradePrefix() : volume(0), signed_volume(0), notional(0), buyer_maker_count(0) {
+}
+
+// TradeHistory
+
+TradeHistory::TradeHistory() : TradeHistory(RetentionConfig()) {
+}
+
+TradeHistory::TradeHistory(const RetentionConfig& config)
+    : config_(config), transactions_(), prefixes_(1), first_index_(0), writer_() {
+    if (config_.max_count == 0) {
+        throw std::runtime_error("TradeHistory::TradeHistory - max_count has to be positive.");
+    }
+    if (!config_.log_path.empty()) {
+        writer_ = std::make_unique<TradeLogWriter>(config_.log_path);
+    }
+}
+
+const RetentionConfig& TradeHistory::GetConfig() const {
+    return config_;
+}
+
+void TradeHistory::Add(const TTransaction& transaction, const uint64_t& order_id) {
+    if (writer_) {
+        writer_->Add(TradeLogRecord(*transaction, order_id));
+    }
+    transactions_.emplace_back(transaction);
+    TradePrefix prefix = prefixes_.back();
+    prefix.volume += transaction->GetVolume();
+    prefix.notional += transaction->GetPrice() * transaction->GetVolume();
+    if (transaction->GetIsBuyerMaker()) {
+        prefix.signed_volume += transaction->GetVolume();
+        ++prefix.buyer_maker_count;
+    } else {
+        prefix.signed_volume -= transaction->GetVolume();
+    }
+    prefixes_.emplace_back(prefix);
+    uint64_t newest = transaction->GetTransactionTimestamp();
+    while (transactions_.size() > config_.max_count ||
+           (newest >= transactions_.front()->GetTransactionTimestamp() &&
+            newest - transactions_.front()->GetTransactionTimestamp() > config_.max_age)) {
+        transactions_.pop_front();
+        prefixes_.pop_front();
+        ++first_index_;
+    }
+}
+
+uint64_t TradeHistory::GetTotalCount() const {
+    return first_index_ + transactions_.size();
+}
+
+uint64_t TradeHistory::GetFirstIndex() const {
+    return first_index_;
+}
+
+const TTransaction& TradeHistory::Get(const uint64_t& index) const {
+    if (index < first_index_ || index >= GetTotalCount()) {
+        throw std::runtime_error("TradeHistory::Get - The transaction isn't in memory.");
+    }
+    return transactions_[index - first_index_];
+}
+
+TradeWindowStats TradeHistory::GetStats(const uint64_t& from, const uint64_t& to) const {
+    if (from > to || from < first_index_ || to > GetTotalCount()) {
+        throw std::runtime_error("TradeHistory::GetStats - The range isn't in memory.");
+    }
+    const auto& first = prefixes_[from - first_index_];
+    const auto& last = prefixes_[to - first_index_];
+    TradeWindowStats stats;
+    stats.count = to - from;
+    stats.volume = last.volume - first.volume;
+    stats.signed_volume = static_cast<int64_t>(last.signed_volume - first.signed_volume);
+    stats.notional = last.notional - first.notional;
+    stats.buyer_maker_count = last.buyer_maker_count - first.buyer_maker_count;
+    return stats;
+}
+
+uint64_t TradeHistory::GetVWAP(const uint64_t& from, const uint64_t& to) const {
+    return GetStats(from, to).GetVWAP();
+}
+
+int64_t TradeHistory::GetSignedVolume(const uint64_t& from, const uint64_t& to) const {
+    return GetStats(from, to).signed_volume;
+}
+
+uint64_t TradeHistory::GetIndexByTime(const uint64_t& timestamp) const {
+    auto it = std::lower_bound(transactions_.begin(), transactions_.end(), timestamp,
+                               [](const TTransaction& transaction, const uint64_t& value) {
+                                   return transaction->GetTransactionTimestamp() < value;
+                               });
+    return first_index_ + (it - transactions_.begin());
+}
+
+TradeWindowStats TradeHistory::GetTimeStats(const uint64_t& from, const uint64_t& to) const {
+    uint64_t from_index = GetIndexByTime(from);
+    return GetStats(from_index, std::max(from_index, GetIndexByTime(to)));
+}
+
+size_t TradeHistory::Size() const {
+    return transactions_.size();
+}
+
+TradeHistory::TIterator TradeHistory::begin() const {
+    return transactions_.begin();
+}
+
+TradeHistory::TIterator TradeHistory::end() const {
+    return transactions_.end();
+}
+
+void TradeHistory::Flush() {
+    if (writer_) {
+        writer_->Flush();
+    }
+}
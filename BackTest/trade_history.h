@@ -0,0 +1,119 @@
+#pragma once
+
+#include "completed_transaction.h"
+#include "feature_store.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// time in ms
+struct RetentionConfig {
+    // transactions kept in memory, the defaults keep everything
+    uint64_t max_count = -1;
+    // transactions older than the newest one by more than max_age are dropped from memory
+    uint64_t max_age = -1;
+    // if not empty, every transaction is appended to a binary log at this path
+    std::string log_path;
+};
+
+struct TradeLogRecord {
+    uint64_t timestamp;
+    uint64_t price;
+    uint64_t volume;
+    // id of the user order which took part in the transaction, -1 for the market ones
+    uint64_t order_id;
+    bool is_buyer_maker;
+    TradeLogRecord() = default;
+    TradeLogRecord(const CompletedTransaction& transaction, const uint64_t& order_id);
+    bool operator==(const TradeLogRecord& other) const;
+};
+
+// Appends records to a file from a background thread, the owner only swaps a buffer under a
+// mutex. The file is "BTTRADE1" followed by records of timestamp, price, volume, order_id as
+// little endian uint64 and is_buyer_maker as one byte.
+class TradeLogWriter {
+public:
+    explicit TradeLogWriter(const std::string& path);
+    ~TradeLogWriter();
+    TradeLogWriter(const TradeLogWriter&) = delete;
+    TradeLogWriter& operator=(const TradeLogWriter&) = delete;
+    void Add(const TradeLogRecord& record);
+    // blocks until everything added before is written to the file
+    void Flush();
+
+private:
+    void Run();
+    static const size_t batch_size_ = 4096;
+    std::mutex mutex_;
+    std::condition_variable has_work_, is_written_;
+    std::vector<TradeLogRecord> pending_;
+    uint64_t added_;
+    uint64_t written_;
+    bool flush_requested_;
+    bool stop_;
+    bool failed_;
+    std::string path_;
+    std::thread thread_;
+};
+
+std::vector<TradeLogRecord> ReadTradeLog(const std::string& path);
+
+// Sums over the transactions before a number. The sums wrap around in 64 bits, but the difference
+// of two prefixes is exact while the sum over the range fits.
+struct TradePrefix {
+    uint64_t volume;
+    uint64_t signed_volume;
+    uint64_t notional;
+    uint64_t buyer_maker_count;
+    TradePrefix();
+};
+
+// The completed transactions of an orderbook. Only the tail allowed by the RetentionConfig is kept
+// in memory, the transactions are numbered from 0 in the order they were added, so a reader can
+// remember its position even after the older ones are dropped. The prefix sums of the
+// transactions in memory answer the range queries in O(1), whatever the length of the range.
+class TradeHistory {
+public:
+    using TIterator = std::deque<TTransaction>::const_iterator;
+
+    TradeHistory();
+    explicit TradeHistory(const RetentionConfig& config);
+    const RetentionConfig& GetConfig() const;
+    void Add(const TTransaction& transaction, const uint64_t& order_id = -1);
+    // number of transactions ever added
+    uint64_t GetTotalCount() const;
+    // number of the oldest transaction in memory
+    uint64_t GetFirstIndex() const;
+    // the number has to be in [GetFirstIndex(), GetTotalCount())
+    const TTransaction& Get(const uint64_t& index) const;
+    // aggregates of the transactions numbered [from, to), the numbers have to be in
+    // [GetFirstIndex(), GetTotalCount()]
+    TradeWindowStats GetStats(const uint64_t& from, const uint64_t& to) const;
+    uint64_t GetVWAP(const uint64_t& from, const uint64_t& to) const;
+    int64_t GetSignedVolume(const uint64_t& from, const uint64_t& to) const;
+    // the number of the first transaction in memory with a timestamp not less than the given one,
+    // O(log n)
+    uint64_t GetIndexByTime(const uint64_t& timestamp) const;
+    // aggregates of the transactions in memory with timestamps in [from, to) ms
+    TradeWindowStats GetTimeStats(const uint64_t& from, const uint64_t& to) const;
+    // transactions in memory
+    size_t Size() const;
+    TIterator begin() const;
+    TIterator end() const;
+    // blocks until the log contains every added transaction
+    void Flush();
+
+private:
+    RetentionConfig config_;
+    std::deque<TTransaction> transactions_;
+    // one more than the transactions: the sums before each of them and after the last one
+    std::deque<TradePrefix> prefixes_;
+    uint64_t first_index_;
+    std::unique_ptr<TradeLogWriter> writer_;
+};
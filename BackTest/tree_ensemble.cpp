@@ -0,0 +1,136 @@
+#include "tree_ensemble.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+// TreeEnsemble
+
+TreeEnsemble::TreeEnsemble(const uint64_t& feature_count, const double& bias)
+    : feature_count_(feature_count), bias_(bias) {
+}
+
+TreeEnsemble::TreeEnsemble(const std::string& path_model) {
+    std::ifstream in(path_model);
+    if (!in.is_open()) {
+        throw std::runtime_error("TreeEnsemble::TreeEnsemble - Failed to open the model file.");
+    }
+    auto expect = [&in](const std::string& expected) {
+        std::string token;
+        if (!(in >> token) || token != expected) {
+            throw std::runtime_error("TreeEnsemble::TreeEnsemble - Expected '" + expected +
+                                     "' in the model file.");
+        }
+    };
+    auto read = [&in](auto& value) {
+        if (!(in >> value)) {
+            throw std::runtime_error(
+                "TreeEnsemble::TreeEnsemble - Failed to read a number from the model file.");
+        }
+    };
+    expect("features");
+    read(feature_count_);
+    expect("bias");
+    read(bias_);
+    std::string token;
+    while (in >> token) {
+        if (token != "tree") {
+            throw std::runtime_error(
+                "TreeEnsemble::TreeEnsemble - Expected 'tree' in the model file.");
+        }
+        uint32_t depth;
+        read(depth);
+        if (depth > max_depth_) {
+            throw std::runtime_error("TreeEnsemble::TreeEnsemble - The tree is too deep.");
+        }
+        std::vector<uint32_t> features(depth);
+        std::vector<double> thresholds(depth);
+        for (uint32_t i = 0; i < depth; ++i) {
+            expect("split");
+            read(features[i]);
+            read(thresholds[i]);
+        }
+        expect("leaves");
+        std::vector<double> leaves(1u << depth);
+        for (auto& leaf : leaves) {
+            read(leaf);
+        }
+        AddTree(features, thresholds, leaves);
+    }
+}
+
+void TreeEnsemble::AddTree(const std::vector<uint32_t>& features,
+                           const std::vector<double>& thresholds,
+                           const std::vector<double>& leaves) {
+    if (features.size() != thresholds.size() || features.size() > max_depth_ ||
+        leaves.size() != (1u << features.size())) {
+        throw std::runtime_error("TreeEnsemble::AddTree - Incorrect shape of the tree.");
+    }
+    for (const auto& feature : features) {
+        if (feature >= feature_count_) {
+            throw std::runtime_error("TreeEnsemble::AddTree - Incorrect feature in a split.");
+        }
+    }
+    depths_.emplace_back(features.size());
+    split_offsets_.emplace_back(split_features_.size());
+    split_features_.insert(split_features_.end(), features.begin(), features.end());
+    split_thresholds_.insert(split_thresholds_.end(), thresholds.begin(), thresholds.end());
+    leaf_offsets_.emplace_back(leaf_values_.size());
+    leaf_values_.insert(leaf_values_.end(), leaves.begin(), leaves.end());
+}
+
+uint64_t TreeEnsemble::GetFeatureCount() const {
+    return feature_count_;
+}
+
+uint64_t TreeEnsemble::GetTreeCount() const {
+    return depths_.size();
+}
+
+double TreeEnsemble::Predict(const double* features) const {
+    double prediction = bias_;
+    const uint32_t* split_feature = split_features_.data();
+    const double* split_threshold = split_thresholds_.data();
+    for (size_t tree = 0; tree < depths_.size(); ++tree) {
+        uint32_t leaf = 0;
+        for (uint32_t level = 0; level < depths_[tree]; ++level) {
+            leaf |= static_cast<uint32_t>(features[*split_feature++] > *split_threshold++)
+                    << level;
+        }
+        prediction += leaf_values_[leaf_offsets_[tree] + leaf];
+    }
+    return prediction;
+}
+
+void TreeEnsemble::Predict(const double* features, const size_t& rows,
+                           double* predictions) const {
+    // trees are applied to a block of rows at once: every split is loaded once per block and the
+    // block is transposed, so a split compares contiguous values of one feature
+    std::vector<double> columns(feature_count_ * block_size_);
+    uint32_t leaves[block_size_];
+    for (size_t from = 0; from < rows; from += block_size_) {
+        size_t count = std::min(block_size_, rows - from);
+        for (size_t row = 0; row < count; ++row) {
+            const double* row_features = features + (from + row) * feature_count_;
+            for (size_t feature = 0; feature < feature_count_; ++feature) {
+                columns[feature * block_size_ + row] = row_features[feature];
+            }
+        }
+        std::fill(predictions + from, predictions + from + count, bias_);
+        for (size_t tree = 0; tree < depths_.size(); ++tree) {
+            std::fill(leaves, leaves + count, 0);
+            for (uint32_t level = 0; level < depths_[tree]; ++level) {
+                const double* column =
+                    columns.data() + split_features_[split_offsets_[tree] + level] * block_size_;
+                double threshold = split_thresholds_[split_offsets_[tree] + level];
+                for (size_t row = 0; row < count; ++row) {
+                    leaves[row] |= static_cast<uint32_t>(column[row] > threshold) << level;
+                }
+            }
+            const double* tree_leaves = leaf_values_.data() + leaf_offsets_[tree];
+            for (size_t row = 0; row < count; ++row) {
+                predictions[from + row] += tree_leaves[leaves[row]];
+            }
+        }
+    }
+}
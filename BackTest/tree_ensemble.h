@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Gradient boosted oblivious trees (the catboost kind): all nodes of one level of a tree share
+// the same split, so a tree is just depth (feature, threshold) pairs and 2^depth leaves. Leaf
+// number has bit d set when features[feature_d] > threshold_d. All trees are stored in a few flat
+// arrays and evaluated without branches.
+//
+// Text format of the model, tokens are separated by whitespaces:
+//   features <feature count>
+//   bias <value>
+//   tree <depth>  split <feature> <threshold> (depth times)  leaves <value> (2^depth times)
+//   ... the other trees
+class TreeEnsemble {
+public:
+    TreeEnsemble() = default;
+    explicit TreeEnsemble(const uint64_t& feature_count, const double& bias = 0);
+    explicit TreeEnsemble(const std::string& path_model);
+    void AddTree(const std::vector<uint32_t>& features, const std::vector<double>& thresholds,
+                 const std::vector<double>& leaves);
+    uint64_t GetFeatureCount() const;
+    uint64_t GetTreeCount() const;
+    // features of one row
+    double Predict(const double* features) const;
+    // features are rows * GetFeatureCount() values, row after row
+    void Predict(const double* features, const size_t& rows, double* predictions) const;
+
+private:
+    static const uint32_t max_depth_ = 16;
+    static const size_t block_size_ = 64;
+    uint64_t feature_count_ = 0;
+    double bias_ = 0;
+    std::vector<uint32_t> depths_;
+    std::vector<uint32_t> split_offsets_;
+    std::vector<uint32_t> split_features_;
+    std::vector<double> split_thresholds_;
+    std::vector<uint32_t> leaf_offsets_;
+    std::vector<double> leaf_values_;
+};